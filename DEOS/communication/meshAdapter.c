@@ -0,0 +1,399 @@
+/*!
+ *  \brief Mesh routing built into serialAdapter.
+ *
+ *  \author   Fachbereich 5 - FH Aachen
+ *  \date     2024
+ *  \version  1.0
+ */
+
+#include "meshAdapter.h"
+#include "rfAdapter.h"
+#include "../lib/terminal.h"
+#include "../os_scheduler.h"
+
+#include <string.h>
+
+//----------------------------------------------------------------------------
+// Types
+//----------------------------------------------------------------------------
+
+//! Entry of the payload of CMD_ROUTE_ADVERTISEMENT
+typedef struct cmd_routeAdvertisement
+{
+    address_t destination;
+    uint8_t hops;
+} cmd_routeAdvertisement_t;
+
+//! Route to one destination
+typedef struct MeshRoute
+{
+    address_t destination;
+    address_t nextHop;
+    uint8_t hops; //!< 0 if the entry is free
+    uint8_t age;  //!< Advertisement intervals since the route was confirmed
+} mesh_route_t;
+
+//! A frame that was received already
+typedef struct MeshSeen
+{
+    address_t srcAddr;
+    uint8_t sequence;
+} mesh_seen_t;
+
+//----------------------------------------------------------------------------
+// Globals
+//----------------------------------------------------------------------------
+
+//! Whether frames are sent as mesh frames and frames for other nodes are forwarded
+bool meshAdapter_enabled = false;
+
+//! The routing table
+static mesh_route_t mesh_routes[MESH_ROUTE_COUNT];
+
+//! Recently received frames, used as ring buffer
+static mesh_seen_t mesh_seen[MESH_DUPLICATE_COUNT];
+
+//! Entry of mesh_seen that is replaced next
+static uint8_t mesh_nextSeen = 0;
+
+//! Sequence number of the last frame sent by this node
+static uint8_t mesh_sequence = 0;
+
+//! When the last route advertisement was sent
+static time_t mesh_lastAdvertisement = 0;
+
+//! Counters
+static mesh_stats_t mesh_stats;
+
+//----------------------------------------------------------------------------
+// Private functions
+//----------------------------------------------------------------------------
+
+/*!
+ *  Looks up the route to a destination.
+ *  Must be called from within a critical section.
+ *
+ *  \param destination Address of the destination
+ *  \return The route or NULL if none is known
+ */
+static mesh_route_t* meshAdapter_findRoute(address_t destination)
+{
+    for (uint8_t i = 0; i < MESH_ROUTE_COUNT; i++)
+    {
+        if (mesh_routes[i].hops != 0 && mesh_routes[i].destination == destination)
+        {
+            return &mesh_routes[i];
+        }
+    }
+    return NULL;
+}
+
+/*!
+ *  Returns the neighbour a frame for the destination is sent to. Without a
+ *  known route the frame is sent to all neighbours.
+ *  Must be called from within a critical section.
+ *
+ *  \param destination Address of the final receiver
+ *  \return Address of the neighbour or ADDRESS_BROADCAST
+ */
+static address_t meshAdapter_nextHop(address_t destination)
+{
+    mesh_route_t* route = destination == ADDRESS_BROADCAST ? NULL : meshAdapter_findRoute(destination);
+    return route == NULL ? ADDRESS_BROADCAST : route->nextHop;
+}
+
+/*!
+ *  Adds or updates the route to a destination. A known route is only
+ *  replaced by a shorter one, unless the new one leads over the same
+ *  neighbour. If the table is full, the least recently confirmed route
+ *  is replaced.
+ *  Must be called from within a critical section.
+ *
+ *  \param destination Address of the destination
+ *  \param nextHop Neighbour the destination is reached over
+ *  \param hops Number of hops to the destination
+ */
+static void meshAdapter_learnRoute(address_t destination, address_t nextHop, uint8_t hops)
+{
+    if (destination == serialAdapter_address || destination == ADDRESS_BROADCAST || hops > MESH_MAX_HOPS)
+    {
+        return;
+    }
+
+    mesh_route_t* route = meshAdapter_findRoute(destination);
+
+    if (route == NULL)
+    {
+        route = &mesh_routes[0];
+        for (uint8_t i = 0; i < MESH_ROUTE_COUNT && route->hops != 0; i++)
+        {
+            if (mesh_routes[i].hops == 0 || mesh_routes[i].age > route->age)
+            {
+                route = &mesh_routes[i];
+            }
+        }
+    }
+    else if (route->nextHop != nextHop && hops > route->hops)
+    {
+        return;
+    }
+
+    route->destination = destination;
+    route->nextHop = nextHop;
+    route->hops = hops;
+    route->age = 0;
+}
+
+/*!
+ *  Checks whether a frame was received already and remembers it otherwise.
+ *  Must be called from within a critical section.
+ *
+ *  \param srcAddr Original sender of the frame
+ *  \param sequence Sequence number of the frame
+ *  \return True if the frame is a duplicate
+ */
+static bool meshAdapter_isDuplicate(address_t srcAddr, uint8_t sequence)
+{
+    for (uint8_t i = 0; i < MESH_DUPLICATE_COUNT; i++)
+    {
+        if (mesh_seen[i].srcAddr == srcAddr && mesh_seen[i].sequence == sequence)
+        {
+            return true;
+        }
+    }
+
+    mesh_seen[mesh_nextSeen].srcAddr = srcAddr;
+    mesh_seen[mesh_nextSeen].sequence = sequence;
+    mesh_nextSeen = (mesh_nextSeen + 1) % MESH_DUPLICATE_COUNT;
+    return false;
+}
+
+/*!
+ *  Learns the routes a neighbour advertised, they are one hop longer over it.
+ *  Malformed frames that are too short are ignored.
+ *  Must be called from within a critical section.
+ *
+ *  \param frame Advertisement received from the neighbour
+ */
+static void meshAdapter_receiveAdvertisement(frame_t* frame)
+{
+    // A frame without command byte carries no entries, the length would underflow
+    if (frame->header.length < sizeof(command_t))
+    {
+        return;
+    }
+
+    cmd_routeAdvertisement_t* entries = FRAME_PAYLOAD(frame, cmd_routeAdvertisement_t);
+    uint8_t count = (frame->header.length - sizeof(command_t)) / sizeof(cmd_routeAdvertisement_t);
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        meshAdapter_learnRoute(entries[i].destination, frame->mesh.prevHop, entries[i].hops + 1);
+    }
+}
+
+/*!
+ *  Forwards a frame for another node to the next hop, as long as it did
+ *  not reach MESH_MAX_HOPS.
+ *
+ *  \param frame The received frame, its link fields are overwritten
+ */
+static void meshAdapter_forward(frame_t* frame)
+{
+    // The frame travelled hops + 1 hops to reach this node
+    if (frame->mesh.hops + 1 >= MESH_MAX_HOPS)
+    {
+        mesh_stats.hopLimit++;
+        return;
+    }
+
+    os_enterCriticalSection();
+    frame->mesh.hops++;
+    frame->mesh.prevHop = serialAdapter_address;
+    frame->mesh.nextHop = meshAdapter_nextHop(frame->header.destAddr);
+    os_leaveCriticalSection();
+
+    if (frame->mesh.nextHop == ADDRESS_BROADCAST && frame->header.destAddr != ADDRESS_BROADCAST)
+    {
+        mesh_stats.flooded++;
+    }
+    mesh_stats.forwarded++;
+
+    serialAdapter_transmitFrame(frame, frame->header.length);
+}
+
+//----------------------------------------------------------------------------
+// Public functions
+//----------------------------------------------------------------------------
+
+/*!
+ *  Assigns a new sequence number and the next hop to a mesh frame sent by
+ *  this node. Is called by serialAdapter_transmitFrame for every
+ *  transmission, so retransmitted frames are not taken for duplicates.
+ *
+ *  \param frame Mesh frame with hops set to 0
+ */
+void meshAdapter_prepareFrame(frame_t* frame)
+{
+    os_enterCriticalSection();
+    frame->mesh.sequence = ++mesh_sequence;
+    frame->mesh.prevHop = serialAdapter_address;
+    frame->mesh.nextHop = meshAdapter_nextHop(frame->header.destAddr);
+    os_leaveCriticalSection();
+}
+
+/*!
+ *  Handles a received mesh frame that was sent to this node or to all
+ *  neighbours. The routes to its sender and to the neighbour it came from
+ *  are learned, duplicates and advertisements are consumed and frames for
+ *  other nodes are forwarded if the mesh is enabled.
+ *
+ *  \param frame The received frame
+ *  \return True if the frame has to be processed by this node
+ */
+bool meshAdapter_receiveFrame(frame_t* frame)
+{
+    // Own frames that come back while being flooded
+    if (frame->header.srcAddr == serialAdapter_address)
+    {
+        return false;
+    }
+
+    bool advertisement = frame->innerFrame.command == CMD_ROUTE_ADVERTISEMENT;
+    bool duplicate = false;
+
+    os_enterCriticalSection();
+    meshAdapter_learnRoute(frame->mesh.prevHop, frame->mesh.prevHop, 1);
+    meshAdapter_learnRoute(frame->header.srcAddr, frame->mesh.prevHop, frame->mesh.hops + 1);
+
+    if (advertisement)
+    {
+        meshAdapter_receiveAdvertisement(frame);
+    }
+    else
+    {
+        duplicate = meshAdapter_isDuplicate(frame->header.srcAddr, frame->mesh.sequence);
+    }
+    os_leaveCriticalSection();
+
+    if (advertisement)
+    {
+        return false;
+    }
+    if (duplicate)
+    {
+        mesh_stats.duplicates++;
+        return false;
+    }
+
+    if (meshAdapter_enabled && frame->header.destAddr != serialAdapter_address)
+    {
+        meshAdapter_forward(frame);
+    }
+
+    return frame->header.destAddr == serialAdapter_address || frame->header.destAddr == ADDRESS_BROADCAST;
+}
+
+/*!
+ *  Ages the routes and advertises the valid ones to all neighbours every
+ *  MESH_ADVERTISE_INTERVAL_MS. Is called by serialAdapter_worker.
+ */
+void meshAdapter_worker(void)
+{
+    if (!meshAdapter_enabled || getSystemTime_ms() - mesh_lastAdvertisement < MESH_ADVERTISE_INTERVAL_MS)
+    {
+        return;
+    }
+    mesh_lastAdvertisement = getSystemTime_ms();
+
+    frame_t* frame = serialAdapter_allocFrame(ADDRESS_BROADCAST, CMD_ROUTE_ADVERTISEMENT);
+    cmd_routeAdvertisement_t* entries = frame == NULL ? NULL : FRAME_PAYLOAD(frame, cmd_routeAdvertisement_t);
+    uint8_t count = 0;
+
+    os_enterCriticalSection();
+    for (uint8_t i = 0; i < MESH_ROUTE_COUNT; i++)
+    {
+        mesh_route_t* route = &mesh_routes[i];
+
+        if (route->hops == 0)
+        {
+            continue;
+        }
+        if (++route->age > MESH_ROUTE_TIMEOUT)
+        {
+            route->hops = 0;
+            continue;
+        }
+        if (entries != NULL)
+        {
+            entries[count].destination = route->destination;
+            entries[count].hops = route->hops;
+            count++;
+        }
+    }
+    os_leaveCriticalSection();
+
+    // Neighbours learn the route to this node from the advertisement itself, even if it is empty
+    if (frame != NULL)
+    {
+        serialAdapter_sendFrame(frame, sizeof(command_t) + count * sizeof(cmd_routeAdvertisement_t));
+    }
+}
+
+/*!
+ *  Looks up the route to a destination
+ *
+ *  \param destination Address of the destination
+ *  \param nextHop Neighbour the destination is reached over
+ *  \param hops Number of hops to the destination
+ *  \return False if no route is known, the parameters stay unchanged then
+ */
+bool meshAdapter_getRoute(address_t destination, address_t* nextHop, uint8_t* hops)
+{
+    os_enterCriticalSection();
+    mesh_route_t* route = meshAdapter_findRoute(destination);
+    if (route != NULL)
+    {
+        *nextHop = route->nextHop;
+        *hops = route->hops;
+    }
+    os_leaveCriticalSection();
+
+    return route != NULL;
+}
+
+/*!
+ *  Returns the counters of the mesh routing
+ *
+ *  \return A copy of the counters
+ */
+mesh_stats_t meshAdapter_getStats(void)
+{
+    os_enterCriticalSection();
+    mesh_stats_t stats = mesh_stats;
+    os_leaveCriticalSection();
+    return stats;
+}
+
+/*!
+ *  Prints the routing table and the counters to the terminal
+ */
+void meshAdapter_printRoutes(void)
+{
+    mesh_route_t routes[MESH_ROUTE_COUNT];
+
+    os_enterCriticalSection();
+    memcpy(routes, mesh_routes, sizeof(routes));
+    os_leaveCriticalSection();
+
+    for (uint8_t i = 0; i < MESH_ROUTE_COUNT; i++)
+    {
+        if (routes[i].hops != 0)
+        {
+            INFO("Route to %u: over %u, %u hops, age %u", routes[i].destination, routes[i].nextHop, routes[i].hops, routes[i].age);
+        }
+    }
+
+    mesh_stats_t stats = meshAdapter_getStats();
+    INFO("Mesh: %u forwarded, %u flooded, %u duplicates, %u at hop limit", stats.forwarded, stats.flooded, stats.duplicates, stats.hopLimit);
+}
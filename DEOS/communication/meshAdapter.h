@@ -0,0 +1,70 @@
+/*!
+ *  \brief Mesh routing built into serialAdapter.
+ *
+ *  Mesh frames are announced by serialAdapter_startFlagMesh. Their header
+ *  keeps the addresses of the original sender and the final receiver, the
+ *  link between two neighbours is described by frame_mesh_t, which also
+ *  counts the hops. Nodes forward mesh frames for other destinations along
+ *  a small routing table, suppress duplicates by sender and sequence number
+ *  and advertise their routes periodically. Routes are also learned from
+ *  every received mesh frame.
+ *
+ *  \author   Fachbereich 5 - FH Aachen
+ *  \date     2024
+ *  \version  1.0
+ */
+
+#ifndef MESH_ADAPTER_H_
+#define MESH_ADAPTER_H_
+
+#include "serialAdapter.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+//! Number of destinations a route is kept for
+#define MESH_ROUTE_COUNT 8
+
+//! Number of received frames (sender and sequence number) remembered to drop duplicates
+#define MESH_DUPLICATE_COUNT 8
+
+//! Maximum number of hops a frame travels, this bounds the cost of flooding
+#define MESH_MAX_HOPS 4
+
+//! Interval of the route advertisements
+#define MESH_ADVERTISE_INTERVAL_MS ((time_t)10000)
+
+//! Number of advertisement intervals a route stays valid without being confirmed
+#define MESH_ROUTE_TIMEOUT 3
+
+//! Counters of the mesh routing
+typedef struct MeshStats
+{
+	uint16_t forwarded;  //!< Frames forwarded for other nodes
+	uint16_t flooded;    //!< Frames sent to all neighbours as no route was known
+	uint16_t duplicates; //!< Received frames dropped as duplicates
+	uint16_t hopLimit;   //!< Frames not forwarded as they reached MESH_MAX_HOPS
+} mesh_stats_t;
+
+//! Whether frames are sent as mesh frames and frames for other nodes are forwarded (mesh frames for this node are always accepted)
+extern bool meshAdapter_enabled;
+
+//! Assigns sequence number and next hop to a mesh frame sent by this node
+void meshAdapter_prepareFrame(frame_t *frame);
+
+//! Handles a received mesh frame, returns true if it has to be processed by this node
+bool meshAdapter_receiveFrame(frame_t *frame);
+
+//! Ages the routes and sends the route advertisements
+void meshAdapter_worker(void);
+
+//! Looks up the route to a destination, returns false if none is known
+bool meshAdapter_getRoute(address_t destination, address_t *nextHop, uint8_t *hops);
+
+//! Returns the counters of the mesh routing
+mesh_stats_t meshAdapter_getStats(void);
+
+//! Prints the routing table and the counters to the terminal
+void meshAdapter_printRoutes(void);
+
+#endif /* MESH_ADAPTER_H_ */
@@ -0,0 +1,511 @@
+/*!
+ *  \brief Reliable channel built on top of serialAdapter.
+ *
+ *  \author   Fachbereich 5 - FH Aachen
+ *  \date     2024
+ *  \version  1.0
+ */
+
+#include "reliableAdapter.h"
+#include "rfAdapter.h"
+#include "../lib/terminal.h"
+#include "../os_mempool.h"
+#include "../os_scheduler.h"
+
+#include <string.h>
+
+//----------------------------------------------------------------------------
+// Defines
+//----------------------------------------------------------------------------
+
+//! Set until the first acknowledgement of a peer arrived, the receiver restarts its sequence numbering
+#define RELIABLE_FLAG_SYNC (1 << 0)
+
+//----------------------------------------------------------------------------
+// Types
+//----------------------------------------------------------------------------
+
+//! Header in front of the payload of CMD_RELIABLE_DATA
+typedef struct cmd_reliableData
+{
+    uint8_t seq;
+    uint8_t flags;
+    uint8_t base;      //!< Oldest sequence number that is neither acknowledged nor given up
+    command_t command;
+} cmd_reliableData_t;
+
+_Static_assert(sizeof(cmd_reliableData_t) == RELIABLE_HEADER_LENGTH, "RELIABLE_HEADER_LENGTH does not match cmd_reliableData_t");
+
+//! Payload of CMD_RELIABLE_ACK
+typedef struct cmd_reliableAck
+{
+    uint8_t expected; //!< All sequence numbers before this one were received
+    uint8_t received; //!< Bit n is set if expected + n was received
+} cmd_reliableAck_t;
+
+//! Sequence number state of one peer
+typedef struct ReliablePeer
+{
+    address_t address;
+    bool used;
+    bool synced;        //!< The peer acknowledged at least one frame
+    bool rxKnown;       //!< A frame of the peer was received, rxExpected is valid
+    uint8_t txSeq;      //!< Next sequence number sent to the peer
+    uint8_t rxExpected; //!< Next sequence number expected from the peer
+    uint8_t rxReceived; //!< Bit n is set if rxExpected + n was received
+} reliable_peer_t;
+
+//! An unacknowledged frame
+typedef struct ReliableEntry
+{
+    frame_t* frame;  //!< NULL if the entry is free
+    inner_frame_length_t length;
+    uint8_t seq;
+    uint8_t retries;
+    time_t deadline; //!< When the frame is sent again
+    bool sending;    //!< The frame is being transmitted outside of a critical section
+    bool acked;      //!< Acknowledged while sending, released when the transmission finished
+} reliable_entry_t;
+
+//----------------------------------------------------------------------------
+// Globals
+//----------------------------------------------------------------------------
+
+//! Known peers
+static reliable_peer_t reliable_peers[RELIABLE_MAX_PEERS];
+
+//! Peer slot that is replaced next if all slots are used
+static uint8_t reliable_nextVictim = 0;
+
+//! The retransmit window
+static reliable_entry_t reliable_window[RELIABLE_WINDOW_SIZE];
+
+//! Counters
+static reliable_stats_t reliable_stats;
+
+//----------------------------------------------------------------------------
+// Forward declarations
+//----------------------------------------------------------------------------
+
+void reliableAdapter_receiveData(frame_t* frame);
+void reliableAdapter_receiveAck(frame_t* frame);
+
+//----------------------------------------------------------------------------
+// Private functions
+//----------------------------------------------------------------------------
+
+/*!
+ *  Looks up the state of a peer and creates it if it is unknown.
+ *  Must be called from within a critical section.
+ *
+ *  \param address Address of the peer
+ *  \return The state of the peer
+ */
+static reliable_peer_t* reliableAdapter_getPeer(address_t address)
+{
+    reliable_peer_t* free = NULL;
+
+    for (uint8_t i = 0; i < RELIABLE_MAX_PEERS; i++)
+    {
+        if (reliable_peers[i].used && reliable_peers[i].address == address)
+        {
+            return &reliable_peers[i];
+        }
+        if (!reliable_peers[i].used && free == NULL)
+        {
+            free = &reliable_peers[i];
+        }
+    }
+
+    if (free == NULL)
+    {
+        free = &reliable_peers[reliable_nextVictim];
+        reliable_nextVictim = (reliable_nextVictim + 1) % RELIABLE_MAX_PEERS;
+    }
+
+    memset(free, 0, sizeof(reliable_peer_t));
+    free->address = address;
+    free->used = true;
+    return free;
+}
+
+/*!
+ *  Frees an entry of the window.
+ *  Must be called from within a critical section.
+ *
+ *  \param entry The entry to be freed
+ */
+static void reliableAdapter_release(reliable_entry_t* entry)
+{
+    os_memPoolFree(entry->frame);
+    entry->frame = NULL;
+}
+
+/*!
+ *  Looks up the oldest frame to the destination of an entry that is neither
+ *  acknowledged nor given up. The receiver skips all sequence numbers before
+ *  it, so a frame that was given up does not block the following ones.
+ *  Must be called from within a critical section.
+ *
+ *  \param entry A used entry of the window
+ *  \return The oldest outstanding sequence number, at most the one of the entry
+ */
+static uint8_t reliableAdapter_getBase(reliable_entry_t const* entry)
+{
+    uint8_t base = entry->seq;
+
+    for (uint8_t i = 0; i < RELIABLE_WINDOW_SIZE; i++)
+    {
+        reliable_entry_t const* other = &reliable_window[i];
+        if (other->frame != NULL && !other->acked && other->frame->header.destAddr == entry->frame->header.destAddr && (int8_t)(other->seq - base) < 0)
+        {
+            base = other->seq;
+        }
+    }
+
+    return base;
+}
+
+/*!
+ *  Sends an acknowledgement with the receive state of a peer.
+ *  If no frame buffer is available, the sender will retransmit.
+ *
+ *  \param destAddr The peer to acknowledge
+ *  \param state The receive state of the peer
+ */
+static void reliableAdapter_sendAck(address_t destAddr, cmd_reliableAck_t state)
+{
+    frame_t* frame = serialAdapter_allocFrame(destAddr, CMD_RELIABLE_ACK);
+    if (frame == NULL)
+        return;
+
+    *FRAME_PAYLOAD(frame, cmd_reliableAck_t) = state;
+
+    serialAdapter_sendFrame(frame, sizeof(command_t) + sizeof(cmd_reliableAck_t));
+}
+
+/*!
+ *  Marks the transmission of an entry as finished and releases the entry if
+ *  it was acknowledged in the meantime
+ *
+ *  \param entry The entry that was transmitted
+ */
+static void reliableAdapter_finishSending(reliable_entry_t* entry)
+{
+    os_enterCriticalSection();
+    entry->sending = false;
+    if (entry->acked)
+    {
+        reliableAdapter_release(entry);
+    }
+    os_leaveCriticalSection();
+}
+
+/*!
+ *  Retransmits all frames whose deadline passed and gives up frames that
+ *  reached RELIABLE_MAX_RETRIES. The window is only locked to pick the next
+ *  due frame, the serial transmission runs outside of the critical section.
+ */
+static void reliableAdapter_checkTimeouts(void)
+{
+    while (1)
+    {
+        reliable_entry_t* entry = NULL;
+
+        os_enterCriticalSection();
+
+        time_t now = getSystemTime_ms();
+        for (uint8_t i = 0; i < RELIABLE_WINDOW_SIZE && entry == NULL; i++)
+        {
+            reliable_entry_t* candidate = &reliable_window[i];
+            if (candidate->frame != NULL && !candidate->sending && (int32_t)(now - candidate->deadline) >= 0)
+            {
+                entry = candidate;
+            }
+        }
+
+        if (entry == NULL)
+        {
+            os_leaveCriticalSection();
+            return;
+        }
+
+        if (entry->retries == RELIABLE_MAX_RETRIES)
+        {
+            uint8_t seq = entry->seq;
+            address_t destAddr = entry->frame->header.destAddr;
+            reliable_stats.failed++;
+            reliableAdapter_release(entry);
+            os_leaveCriticalSection();
+
+            WARN("Reliable frame %u to %u was not acknowledged", seq, destAddr);
+            continue;
+        }
+
+        entry->retries++;
+        entry->deadline = now + (RELIABLE_BASE_TIMEOUT_MS << entry->retries);
+        entry->sending = true;
+        FRAME_PAYLOAD(entry->frame, cmd_reliableData_t)->base = reliableAdapter_getBase(entry);
+        reliable_stats.retransmissions++;
+
+        os_leaveCriticalSection();
+
+        serialAdapter_transmitFrame(entry->frame, entry->length);
+        reliableAdapter_finishSending(entry);
+    }
+}
+
+//----------------------------------------------------------------------------
+// Public functions
+//----------------------------------------------------------------------------
+
+/*!
+ *  Registers the commands of the reliable channel at the rfAdapter
+ */
+void reliableAdapter_init(void)
+{
+    rfAdapter_registerCommand(CMD_RELIABLE_DATA, sizeof(cmd_reliableData_t), COMM_MAX_PAYLOAD_LENGTH, reliableAdapter_receiveData);
+    rfAdapter_registerCommand(CMD_RELIABLE_ACK, sizeof(cmd_reliableAck_t), sizeof(cmd_reliableAck_t), reliableAdapter_receiveAck);
+}
+
+/*!
+ *  Sends a frame built in place (see serialAdapter_allocFrame) reliably.
+ *  The command and payload are moved behind the header of the reliable
+ *  channel. Once sent, the frame buffer is kept until the frame is
+ *  acknowledged or given up, so the caller must not use it afterwards.
+ *  Broadcasts cannot be acknowledged and are sent unreliably.
+ *  Does not wait for a free entry of the window, as acknowledgements are only
+ *  processed by rfAdapter_worker, which may run in the calling process.
+ *
+ *  \param frame buffer returned by serialAdapter_allocFrame
+ *  \param length how many bytes the innerFrame has (command and payload)
+ *  \return RELIABLE_WINDOW_FULL if the frame was not sent and the caller still owns the buffer
+ */
+reliable_result_t reliableAdapter_sendFrame(frame_t* frame, inner_frame_length_t length)
+{
+    if (length > sizeof(command_t) + RELIABLE_MAX_PAYLOAD_LENGTH)
+    {
+        serialAdapter_freeFrame(frame);
+        return RELIABLE_TOO_LONG;
+    }
+
+    if (frame->header.destAddr == ADDRESS_BROADCAST)
+    {
+        serialAdapter_sendFrame(frame, length);
+        return RELIABLE_SENT;
+    }
+
+    os_enterCriticalSection();
+
+    reliable_entry_t* entry = NULL;
+    for (uint8_t i = 0; i < RELIABLE_WINDOW_SIZE && entry == NULL; i++)
+    {
+        if (reliable_window[i].frame == NULL)
+        {
+            entry = &reliable_window[i];
+        }
+    }
+    if (entry == NULL)
+    {
+        os_leaveCriticalSection();
+        return RELIABLE_WINDOW_FULL;
+    }
+
+    // Wrap the command in front of the payload
+    memmove(frame->innerFrame.payload + RELIABLE_HEADER_LENGTH, frame->innerFrame.payload, length - sizeof(command_t));
+    cmd_reliableData_t* header = FRAME_PAYLOAD(frame, cmd_reliableData_t);
+    header->command = frame->innerFrame.command;
+    frame->innerFrame.command = CMD_RELIABLE_DATA;
+    length += RELIABLE_HEADER_LENGTH;
+
+    // The window owns the buffer, it must survive its sender
+    os_memPoolSetOwner(frame, INVALID_PROCESS);
+
+    reliable_peer_t* peer = reliableAdapter_getPeer(frame->header.destAddr);
+    header->seq = peer->txSeq++;
+    header->flags = peer->synced ? 0 : RELIABLE_FLAG_SYNC;
+
+    entry->frame = frame;
+    entry->length = length;
+    entry->seq = header->seq;
+    entry->retries = 0;
+    entry->deadline = getSystemTime_ms() + RELIABLE_BASE_TIMEOUT_MS;
+    entry->sending = true;
+    entry->acked = false;
+    header->base = reliableAdapter_getBase(entry);
+    reliable_stats.sent++;
+
+    os_leaveCriticalSection();
+
+    serialAdapter_transmitFrame(frame, length);
+    reliableAdapter_finishSending(entry);
+    return RELIABLE_SENT;
+}
+
+/*!
+ *  Retransmits frames whose acknowledgement timed out. Called periodically
+ *  by rfAdapter_worker.
+ */
+void reliableAdapter_worker(void)
+{
+    reliableAdapter_checkTimeouts();
+}
+
+/*!
+ *  Returns the number of unacknowledged frames
+ *
+ *  \return Number of used entries of the window
+ */
+uint8_t reliableAdapter_getOutstanding(void)
+{
+    uint8_t count = 0;
+
+    os_enterCriticalSection();
+    for (uint8_t i = 0; i < RELIABLE_WINDOW_SIZE; i++)
+    {
+        if (reliable_window[i].frame != NULL)
+        {
+            count++;
+        }
+    }
+    os_leaveCriticalSection();
+
+    return count;
+}
+
+/*!
+ *  Returns the counters of the reliable channel
+ *
+ *  \return Copy of the counters
+ */
+reliable_stats_t reliableAdapter_getStats(void)
+{
+    os_enterCriticalSection();
+    reliable_stats_t stats = reliable_stats;
+    os_leaveCriticalSection();
+
+    return stats;
+}
+
+/*!
+ *  Handler that's called when command CMD_RELIABLE_DATA was received.
+ *  Acknowledges the frame, drops it if it was received before and otherwise
+ *  unwraps the command and dispatches it like a normal frame.
+ *
+ *  \param frame Received frame
+ */
+void reliableAdapter_receiveData(frame_t* frame)
+{
+    cmd_reliableData_t header = *FRAME_PAYLOAD(frame, cmd_reliableData_t);
+
+    if (frame->header.destAddr == ADDRESS_BROADCAST || header.command == CMD_RELIABLE_DATA)
+    {
+        return;
+    }
+
+    os_enterCriticalSection();
+
+    reliable_peer_t* peer = reliableAdapter_getPeer(frame->header.srcAddr);
+    uint8_t offset = header.seq - peer->rxExpected;
+
+    // Adopt the sequence of an unknown peer or of a peer that restarted its
+    // sequence (a sync frame far away from the current receive window)
+    if (!peer->rxKnown || (header.flags & RELIABLE_FLAG_SYNC && offset >= RELIABLE_RECEIVE_WINDOW && offset < (uint8_t)(256 - RELIABLE_RECEIVE_WINDOW)))
+    {
+        peer->rxKnown = true;
+        peer->rxExpected = header.seq;
+        peer->rxReceived = 0;
+        offset = 0;
+    }
+
+    // The sender acknowledged or gave up everything before its base, frames
+    // that never arrived must not hold the receive window
+    uint8_t skip = header.base - peer->rxExpected;
+    if (skip > 0 && skip < 128)
+    {
+        peer->rxReceived = skip < RELIABLE_RECEIVE_WINDOW ? peer->rxReceived >> skip : 0;
+        peer->rxExpected = header.base;
+        while (peer->rxReceived & 1)
+        {
+            peer->rxReceived >>= 1;
+            peer->rxExpected++;
+        }
+        offset = header.seq - peer->rxExpected;
+    }
+    bool duplicate = offset >= RELIABLE_RECEIVE_WINDOW || (peer->rxReceived & (1 << offset));
+
+    if (offset < RELIABLE_RECEIVE_WINDOW)
+    {
+        peer->rxReceived |= 1 << offset;
+        while (peer->rxReceived & 1)
+        {
+            peer->rxReceived >>= 1;
+            peer->rxExpected++;
+        }
+    }
+    if (duplicate)
+    {
+        reliable_stats.duplicates++;
+    }
+
+    cmd_reliableAck_t state = {peer->rxExpected, peer->rxReceived};
+
+    os_leaveCriticalSection();
+
+    reliableAdapter_sendAck(frame->header.srcAddr, state);
+
+    if (duplicate)
+    {
+        return;
+    }
+
+    // Unwrap and dispatch the command
+    frame->innerFrame.command = header.command;
+    frame->header.length -= RELIABLE_HEADER_LENGTH;
+    memmove(frame->innerFrame.payload, frame->innerFrame.payload + RELIABLE_HEADER_LENGTH, frame->header.length - sizeof(command_t));
+
+    serialAdapter_processFrame(frame);
+}
+
+/*!
+ *  Handler that's called when command CMD_RELIABLE_ACK was received.
+ *  Releases all frames to the sender of the acknowledgement that it received.
+ *
+ *  \param frame Received frame
+ */
+void reliableAdapter_receiveAck(frame_t* frame)
+{
+    cmd_reliableAck_t* ack = FRAME_PAYLOAD(frame, cmd_reliableAck_t);
+
+    os_enterCriticalSection();
+
+    reliableAdapter_getPeer(frame->header.srcAddr)->synced = true;
+
+    for (uint8_t i = 0; i < RELIABLE_WINDOW_SIZE; i++)
+    {
+        reliable_entry_t* entry = &reliable_window[i];
+
+        if (entry->frame == NULL || entry->acked || entry->frame->header.destAddr != frame->header.srcAddr)
+        {
+            continue;
+        }
+
+        // Sequence numbers before expected are acknowledged cumulatively
+        uint8_t offset = entry->seq - ack->expected;
+        if (offset >= 128 || (offset < RELIABLE_RECEIVE_WINDOW && (ack->received & (1 << offset))))
+        {
+            reliable_stats.acknowledged++;
+            if (entry->sending)
+            {
+                // The sender still transmits the buffer and releases it afterwards
+                entry->acked = true;
+            }
+            else
+            {
+                reliableAdapter_release(entry);
+            }
+        }
+    }
+
+    os_leaveCriticalSection();
+}
@@ -0,0 +1,81 @@
+/*!
+ *  \brief Reliable channel built on top of serialAdapter.
+ *
+ *  Frames sent through this layer carry a sequence number per destination
+ *  and are retransmitted with exponential backoff until the receiver
+ *  acknowledges them. Several frames may be outstanding at the same time.
+ *  The receiver acknowledges selectively and drops duplicates before the
+ *  wrapped command is dispatched like any other received frame. Every frame
+ *  carries the oldest sequence number its sender still retransmits, so the
+ *  receiver moves on past frames that were given up.
+ *
+ *  \author   Fachbereich 5 - FH Aachen
+ *  \date     2024
+ *  \version  1.0
+ */
+
+#ifndef RELIABLE_ADAPTER_H_
+#define RELIABLE_ADAPTER_H_
+
+#include "serialAdapter.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+//! Number of frames that may be unacknowledged at the same time (all destinations)
+#define RELIABLE_WINDOW_SIZE 4
+
+//! Number of sequence numbers ahead of the expected one the receiver keeps track of
+#define RELIABLE_RECEIVE_WINDOW 8
+
+//! Number of peers whose sequence numbers are remembered
+#define RELIABLE_MAX_PEERS 4
+
+//! Time until the first retransmission, doubled for every further one
+#define RELIABLE_BASE_TIMEOUT_MS ((time_t)150)
+
+//! Number of retransmissions before a frame is given up
+#define RELIABLE_MAX_RETRIES 5
+
+//! Bytes the reliable channel puts in front of the payload (sequence number, flags, oldest outstanding sequence number, command)
+#define RELIABLE_HEADER_LENGTH 4
+
+//! Maximum payload length of a frame sent reliably
+#define RELIABLE_MAX_PAYLOAD_LENGTH (COMM_MAX_PAYLOAD_LENGTH - RELIABLE_HEADER_LENGTH)
+
+//! Result of reliableAdapter_sendFrame
+typedef enum ReliableResult
+{
+	RELIABLE_SENT = 0,        //!< The window owns the buffer until the frame is acknowledged or given up
+	RELIABLE_WINDOW_FULL = 1, //!< Not sent, the caller still owns the buffer and may retry after rfAdapter_worker ran
+	RELIABLE_TOO_LONG = 2     //!< Not sent, the buffer was released
+} reliable_result_t;
+
+//! Counters of the reliable channel
+typedef struct ReliableStats
+{
+	uint16_t sent;            //!< Frames sent for the first time
+	uint16_t retransmissions; //!< Frames sent again after a timeout
+	uint16_t acknowledged;    //!< Frames acknowledged by their receiver
+	uint16_t failed;          //!< Frames given up after RELIABLE_MAX_RETRIES
+	uint16_t duplicates;      //!< Received frames dropped as duplicates
+} reliable_stats_t;
+
+//! Registers the commands of the reliable channel (called by rfAdapter_init)
+void reliableAdapter_init(void);
+
+//! Sends a frame built in place reliably. Never blocks: acknowledgements only
+//! free the window when rfAdapter_worker processes them, so a process that
+//! runs the worker itself must call it between retries of a full window.
+reliable_result_t reliableAdapter_sendFrame(frame_t *frame, inner_frame_length_t length);
+
+//! Retransmits frames whose acknowledgement timed out
+void reliableAdapter_worker(void);
+
+//! Returns the number of unacknowledged frames
+uint8_t reliableAdapter_getOutstanding(void);
+
+//! Returns the counters of the reliable channel
+reliable_stats_t reliableAdapter_getStats(void);
+
+#endif /* RELIABLE_ADAPTER_H_ */
@@ -7,10 +7,15 @@
  */
 
 #include "rfAdapter.h"
+#include "reliableAdapter.h"
+#include "sensorHistory.h"
+#include "sensorRegistry.h"
+#include "../lib/fixed_point.h"
 #include "../lib/lcd.h"
 #include "../os_core.h"
+#include "../lib/terminal.h"
+#include "../os_scheduler.h"
 #include "string.h"
-#include "../gui/gui.h"
 
 #include <avr/io.h>
 #include <avr/pgmspace.h>
@@ -26,18 +31,51 @@ bool rfAdapter_initialized = false;
 //! Start-Flag that announces a new frame
 start_flag_t serialAdapter_startFlag = 0x5246; // "RF"
 
+//! Start-Flag that announces a new frame protected by a CRC-16
+start_flag_t serialAdapter_startFlagCrc = 0x5243; // "RC"
+
+//! Start-Flag that announces a new mesh frame protected by a CRC-16
+start_flag_t serialAdapter_startFlagMesh = 0x524D; // "RM"
+
+//! Whether frames are sent with CRC-16
+bool serialAdapter_sendCrc = false;
+
 //! Configuration what address this microcontroller has
 address_t serialAdapter_address = ADDRESS(1, 4);
 
+//! A registered command
+typedef struct rfAdapterCommandEntry
+{
+    uint8_t minLength;                   //!< Minimum payload length (without command)
+    uint8_t maxLength;                   //!< Maximum payload length (without command)
+    rfAdapter_commandHandler_t* handler; //!< Called for valid frames
+} rfAdapterCommandEntry_t;
+
+//! Maps every command id to its slot in rfAdapter_commands (two 4 bit slots per byte, 0 means unregistered)
+static uint8_t rfAdapter_commandIndex[256 / 2];
+
+//! Registered commands, slot n is stored at index n - 1
+static rfAdapterCommandEntry_t rfAdapter_commands[RF_ADAPTER_MAX_COMMANDS];
+
+//! Number of used slots in rfAdapter_commands
+static uint8_t rfAdapter_commandCount = 0;
+
+//! Handlers for sensor data by sensor type
+static rfAdapter_sensorHandler_t* rfAdapter_sensorHandlers[RF_ADAPTER_SENSOR_TYPE_COUNT];
+
+//! Accepted parameter types by sensor type (bit n - 1 for parameter type n)
+static uint8_t rfAdapter_sensorParams[RF_ADAPTER_SENSOR_TYPE_COUNT];
+
 //----------------------------------------------------------------------------
 // Forward declarations
 //----------------------------------------------------------------------------
 
-void rfAdapter_receiveSetLed(cmd_setLed_t*);
-void rfAdapter_receiveToggleLed();
-void rfAdapter_receiveLcdGoto(cmd_lcdGoto_t*);
-void rfAdapter_receiveLcdPrint(cmd_lcdPrint_t*);
-void rfAdapter_receiveLcdClear();
+void rfAdapter_receiveSetLed(frame_t*);
+void rfAdapter_receiveToggleLed(frame_t*);
+void rfAdapter_receiveLcdGoto(frame_t*);
+void rfAdapter_receiveLcdPrint(frame_t*);
+void rfAdapter_receiveLcdClear(frame_t*);
+void rfAdapter_receiveSensorDataFrame(frame_t*);
 
 //----------------------------------------------------------------------------
 // Your Homework
@@ -50,9 +88,88 @@ void rfAdapter_init()
 {
     serialAdapter_init();
     DDRB |= (1 << PB7);
+
+    rfAdapter_registerCommand(CMD_SET_LED, sizeof(cmd_setLed_t), sizeof(cmd_setLed_t), rfAdapter_receiveSetLed);
+    rfAdapter_registerCommand(CMD_TOGGLE_LED, 0, 0, rfAdapter_receiveToggleLed);
+    rfAdapter_registerCommand(CMD_LCD_CLEAR, 0, 0, rfAdapter_receiveLcdClear);
+    rfAdapter_registerCommand(CMD_LCD_GOTO, sizeof(cmd_lcdGoto_t), sizeof(cmd_lcdGoto_t), rfAdapter_receiveLcdGoto);
+    rfAdapter_registerCommand(CMD_LCD_PRINT, sizeof(uint8_t), sizeof(cmd_lcdPrint_t), rfAdapter_receiveLcdPrint);
+    rfAdapter_registerCommand(CMD_SENSOR_DATA, sizeof(cmd_sensorData_t), sizeof(cmd_sensorData_t), rfAdapter_receiveSensorDataFrame);
+    reliableAdapter_init();
+
     rfAdapter_initialized = true;
 }
 
+/*!
+ *  Registers a handler for a command. Frames with this command are only
+ *  passed to the handler if their payload length (without the command)
+ *  lies within [minLength, maxLength]. Registering a command again replaces
+ *  its handler and length range.
+ *
+ *  \param command The command id
+ *  \param minLength Minimum payload length
+ *  \param maxLength Maximum payload length
+ *  \param handler Function that is called with the received frame
+ *  \return False if the command table is full or the parameters are invalid
+ */
+bool rfAdapter_registerCommand(command_t command, uint8_t minLength, uint8_t maxLength, rfAdapter_commandHandler_t* handler)
+{
+    if (handler == NULL || minLength > maxLength || maxLength > COMM_MAX_PAYLOAD_LENGTH)
+    {
+        return false;
+    }
+
+    os_enterCriticalSection();
+
+    uint8_t* index = &rfAdapter_commandIndex[command >> 1];
+    uint8_t shift = (command & 1) ? 4 : 0;
+    uint8_t slot = (*index >> shift) & 0x0F;
+
+    if (slot == 0)
+    {
+        if (rfAdapter_commandCount == RF_ADAPTER_MAX_COMMANDS)
+        {
+            os_leaveCriticalSection();
+            WARN("Command table full, 0x%02x not registered", command);
+            return false;
+        }
+        slot = ++rfAdapter_commandCount;
+        *index = (*index & (0xF0 >> shift)) | (slot << shift);
+    }
+
+    rfAdapter_commands[slot - 1].minLength = minLength;
+    rfAdapter_commands[slot - 1].maxLength = maxLength;
+    rfAdapter_commands[slot - 1].handler = handler;
+
+    os_leaveCriticalSection();
+    return true;
+}
+
+/*!
+ *  Registers a handler for sensor data. Every sensor type has one handler
+ *  that receives all registered parameter types of it, so registering
+ *  another parameter type adds it to the accepted ones and replaces the handler.
+ *
+ *  \param sensor The sensor type
+ *  \param paramType A parameter type of the sensor that should be accepted
+ *  \param handler Function that is called with the received sensor data
+ *  \return False if sensor or parameter type are unknown
+ */
+bool rfAdapter_registerSensor(sensor_type_t sensor, sensor_parameter_type_t paramType, rfAdapter_sensorHandler_t* handler)
+{
+    if (handler == NULL || sensor >= RF_ADAPTER_SENSOR_TYPE_COUNT || paramType < PARAM_TEMPERATURE_CELSIUS || paramType > PARAM_CO2_PPM)
+    {
+        return false;
+    }
+
+    os_enterCriticalSection();
+    rfAdapter_sensorHandlers[sensor] = handler;
+    rfAdapter_sensorParams[sensor] |= 1 << (paramType - 1);
+    os_leaveCriticalSection();
+
+    return true;
+}
+
 /*!
  * Check if adapter has been initialized
  *
@@ -69,10 +186,12 @@ uint8_t rfAdapter_isInitialized()
 void rfAdapter_worker()
 {
     serialAdapter_worker();
+    reliableAdapter_worker();
 }
 
 /*!
- *  Is called on command frame receive
+ *  Is called on command frame receive. Looks up the handler of the command
+ *  and passes the frame on if its payload length is valid for the command.
  *
  *  \param frame Received frame
  */
@@ -86,202 +205,89 @@ void serialAdapter_processFrame(frame_t* frame)
 
     //printFrame(frame, "serialAdapter_processFrame");
 
-    switch (frame->innerFrame.command)
+    command_t command = frame->innerFrame.command;
+    uint8_t slot = rfAdapter_commandIndex[command >> 1];
+    slot = (command & 1) ? (slot >> 4) : (slot & 0x0F);
+
+    if (slot == 0)
     {
-        case CMD_SET_LED:
-        {
-            if (frame->header.length - sizeof(command_t) != sizeof(cmd_setLed_t))
-            {
-                return;
-            }
-            else
-            {
-                // printf_P(PSTR("Setting LED to %d\n"), ((cmd_setLed_t *)&(frame->innerFrame.payload))->enable);
-                rfAdapter_receiveSetLed(((cmd_setLed_t*)&(frame->innerFrame.payload)));
-            }
-        }
-        break;
-        case CMD_TOGGLE_LED:
-        {
-            if (frame->header.length - sizeof(command_t) != 0)
-            {
-                return;
-            }
-            else
-            {
-                // printf_P(PSTR("Toggling LED\n"));
-                rfAdapter_receiveToggleLed();
-            }
-        }
-        break;
+        DEBUG("Ignored unknown command 0x%02x", command);
+        return;
+    }
 
-        case CMD_LCD_CLEAR:
-        {
-            if (frame->header.length - sizeof(command_t) != 0)
-            {
-                return;
-            }
-            else
-            {
-                // printf_P(PSTR("Clearing LCD\n"));
-                rfAdapter_receiveLcdClear();
-            }
-        }
-        break;
+    rfAdapterCommandEntry_t* entry = &rfAdapter_commands[slot - 1];
+    uint8_t payloadLength = frame->header.length - sizeof(command_t);
 
-        case CMD_LCD_GOTO:
-        {
-            if (frame->header.length - sizeof(command_t) != sizeof(cmd_lcdGoto_t))
-            {
-                printf_P(PSTR("Invalid length for CMD_LCD_GOTO. Length w/o command is %d instead of %d\n"), frame->header.length - sizeof(command_t), sizeof(cmd_lcdGoto_t));
-                return;
-            }
-            else
-            {
-                printf_P(PSTR("Goto LCD: %d, %d\n"), ((cmd_lcdGoto_t*)&(frame->innerFrame.payload))->x, ((cmd_lcdGoto_t*)&(frame->innerFrame.payload))->y);
-                rfAdapter_receiveLcdGoto((cmd_lcdGoto_t*)&(frame->innerFrame.payload));
-            }
-        }
-        break;
+    if (payloadLength < entry->minLength || payloadLength > entry->maxLength)
+    {
+        DEBUG("Invalid length for command 0x%02x. Length w/o command is %d instead of %d..%d", command, payloadLength, entry->minLength, entry->maxLength);
+        return;
+    }
 
-        case CMD_LCD_PRINT:
-        {
-            // cmd_lcdPrint_t toprnt = *(cmd_lcdPrint_t*)&(frame->innerFrame.payload);
-
-            if (frame->header.length - sizeof(command_t) > sizeof(cmd_lcdPrint_t))
-            {
-                printf_P(PSTR("Invalid length for CMD_LCD_PRINT. Length w/o command is %d instead of %d\n"), frame->header.length - sizeof(command_t), sizeof(cmd_lcdPrint_t));
-                return;
-            }
-            else if ((*(cmd_lcdPrint_t*)&(frame->innerFrame.payload)).length != frame->header.length - sizeof(command_t) - sizeof((*(cmd_lcdPrint_t*)&(frame->innerFrame.payload)).length))
-            {
-                printf_P(PSTR("Invalid length for CMD_LCD_PRINT. Length of expected String is not equal to length described in cmd_lcdPrint_t object\n"), frame->header.length - sizeof(command_t), sizeof(cmd_lcdPrint_t));
-            }
-            else
-            {
-                printf_P(PSTR("Printing to LCD: %s\n"), ((cmd_lcdPrint_t*)&(frame->innerFrame.payload))->message);
-
-                rfAdapter_receiveLcdPrint((cmd_lcdPrint_t*)&(frame->innerFrame.payload));
-            }
-        }
-        break;
+    entry->handler(frame);
+}
 
-        case CMD_SENSOR_DATA:
-        {
-            uint8_t test1 = frame->header.length - sizeof(command_t);
-            uint8_t test2 = sizeof(cmd_sensorData_t);
-
-            if (test1 != test2)
-            {
-                DEBUG("Invalid length for CMD_SENSOR_DATA. Length w/o command is %d instead of %d\n\n\n\n\n\n", test1, test2);
-            }
-            else
-            {
-                cmd_sensorData_t payload = *(cmd_sensorData_t*)frame->innerFrame.payload;
-
-                sensor_data_t sensor_data;
-                sensor_data.sensor_src_address = frame->header.srcAddr;
-                sensor_data.sensor_type = payload.sensor;
-                sensor_data.sensor_data_type = payload.paramType;
-                sensor_data.sensor_data_value = payload.param;
-                sensor_data.sensor_last_update = getSystemTime_ms();
-
-                rfAdapter_receiveSensorData(&sensor_data);
-            }
-        }
-        break;
+/*!
+ *  Handler that's called when command CMD_SENSOR_DATA was received
+ *
+ *  \param frame Received frame
+ */
+void rfAdapter_receiveSensorDataFrame(frame_t* frame)
+{
+    cmd_sensorData_t* payload = FRAME_PAYLOAD(frame, cmd_sensorData_t);
 
-        default:
-            return;
-    }
+    sensor_data_t sensor_data;
+    sensor_data.sensor_src_address = frame->header.srcAddr;
+    sensor_data.sensor_type = payload->sensor;
+    sensor_data.sensor_data_type = payload->paramType;
+    sensor_data.sensor_data_value = payload->param;
+    sensor_data.sensor_last_update = getSystemTime_ms();
+
+    rfAdapter_receiveSensorData(&sensor_data);
 }
 
+/*!
+ *  Forwards received sensor data to the handler that was registered for its
+ *  sensor type, if the parameter type was registered as well.
+ *
+ *  \param sensor_data Received sensor data
+ */
 void rfAdapter_receiveSensorData(sensor_data_t* sensor_data)
 {
-    switch (sensor_data->sensor_type)
+    sensor_type_t sensor = sensor_data->sensor_type;
+    sensor_parameter_type_t paramType = sensor_data->sensor_data_type;
+
+    if (sensor >= RF_ADAPTER_SENSOR_TYPE_COUNT || paramType < PARAM_TEMPERATURE_CELSIUS || paramType > PARAM_CO2_PPM
+        || !(rfAdapter_sensorParams[sensor] & (1 << (paramType - 1))))
     {
-        case SENSOR_LPS28DFW: // BOL Sensor (1,3) // 11
-        {
-            // printf("rfAdapter_receiveSensorData() for BOL Sensor\n");
-            if (sensor_data->sensor_data_type == PARAM_PRESSURE_PASCAL) //float
-            {
-                enqueue_sensor_data_into_buffer(sensor_data);
-            }
-            else
-            {
-                printf_P(PSTR("rfAdapter_receiveSensorData() ignored %d Value of BOL Sensor\n\n\n\n\n\n"), sensor_data->sensor_data_type);
-            }
-        }
-        break;
+        printf_P(PSTR("rfAdapter_receiveSensorData() ignored %d Value of Sensor %d\n"), paramType, sensor);
+        return;
+    }
 
-        case SENSOR_SHTC3: // Adil Sensor adress (1,7) // 15
-        {
-            if (sensor_data->sensor_data_type == PARAM_HUMIDITY_PERCENT) //float
-            {
-                enqueue_sensor_data_into_buffer(sensor_data);
-            }
-            else
-            {
-                printf_P(PSTR("rfAdapter_receiveSensorData() ignored %d Value of Adil Sensor\n\n\n\n"), sensor_data->sensor_data_type);
-            }
-        }
-        break;
+    // The handle is looked up once here, history and handlers index their tables with it
+    sensor_data->sensor_handle = sensorRegistry_register(sensor_data->sensor_src_address, sensor, paramType);
+    if (sensor_data->sensor_handle == SENSOR_HANDLE_INVALID)
+    {
+        WARN("Sensor registry full, %u/%u/%u not kept", sensor_data->sensor_src_address, sensor, paramType);
+    }
 
-        case SENSOR_SCD41: // Richard Sensor Addresse(1, 6) // 14
-        {
-            if (sensor_data->sensor_data_type == PARAM_CO2_PPM) //uint
-            {
-
-                enqueue_sensor_data_into_buffer(sensor_data);
-            }
-            else
-            {
-                printf_P(PSTR("rfAdapter_receiveSensorData() ignored %d Value of Richard Sensor\n\n\n\n"), sensor_data->sensor_data_type);
-            }
-        }
-        break;
-        case SENSOR_SGP40: // Niklas Sensor Addresse(1,8) //8
-        {
-            if (sensor_data->sensor_data_type == PARAM_TVOC_PPB) //uint
-            {
-                enqueue_sensor_data_into_buffer(sensor_data);
-            }
-            else
-            {
-                printf_P(PSTR("rfAdapter_receiveSensorData() ignored %d Value of Niklas Sensor\n\n\n\n"), sensor_data->sensor_data_type);
-            }
-        }
-        break;
-        case SENSOR_TMP117: // Jannick Sensor Adresse(1,5) //13
-        {
-            if (sensor_data->sensor_data_type == PARAM_TEMPERATURE_CELSIUS) //float
-            {
-                enqueue_sensor_data_into_buffer(sensor_data);
-            }
-            else
-            {
-                printf_P(PSTR("rfAdapter_receiveSensorData() ignored %d Value of Jannick Sensor\n\n\n\n"), sensor_data->sensor_data_type);
-            }
-        }
-        break;
+    // Converted once here, history and GUI work on the fixed point value
+    sensor_data->sensor_fixed_value = sensorData_toFixed(paramType, sensor_data->sensor_data_value);
 
-        default:
-        {
-            printf_P(PSTR("rfAdapter_receiveSensorData() ignored %d Value of unknown Sensor\n\n\n\n"), sensor_data->sensor_data_type);
-        }
-        break;
-    }
+    // Keep the history of every registered sensor value, so handlers do not need their own copy
+    sensorHistory_append(sensor_data);
+    rfAdapter_sensorHandlers[sensor](sensor_data);
 }
 
 /*!
  *  Handler that's called when command CMD_SET_LED was received
  *
- *  \param data Payload of received frame
+ *  \param frame Received frame
  */
-void rfAdapter_receiveSetLed(cmd_setLed_t* data)
+void rfAdapter_receiveSetLed(frame_t* frame)
 {
     // printf("rfAdapter_receiveSetLed()");
-    if ((bool)data->enable)
+    if ((bool)FRAME_PAYLOAD(frame, cmd_setLed_t)->enable)
     {
         PORTB |= (1 << PB7); // on
     }
@@ -293,8 +299,10 @@ void rfAdapter_receiveSetLed(cmd_setLed_t* data)
 
 /*!
  *  Handler that's called when command CMD_TOGGLE_LED was received
+ *
+ *  \param frame Received frame
  */
-void rfAdapter_receiveToggleLed()
+void rfAdapter_receiveToggleLed(frame_t* frame)
 {
     // printf("rfAdapter_receiveToggleLed()");
     PORTB ^= (1 << PB7);
@@ -302,8 +310,10 @@ void rfAdapter_receiveToggleLed()
 
 /*!
  *  Handler that's called when command CMD_LCD_CLEAR was received
+ *
+ *  \param frame Received frame
  */
-void rfAdapter_receiveLcdClear()
+void rfAdapter_receiveLcdClear(frame_t* frame)
 {
     // printf("rfAdapter_receiveLcdClear()");
     lcd_clear();
@@ -312,10 +322,12 @@ void rfAdapter_receiveLcdClear()
 /*!
  *  Handler that's called when command CMD_LCD_GOTO was received
  *
- *  \param data Payload of received frame
+ *  \param frame Received frame
  */
-void rfAdapter_receiveLcdGoto(cmd_lcdGoto_t* data)
+void rfAdapter_receiveLcdGoto(frame_t* frame)
 {
+    cmd_lcdGoto_t* data = FRAME_PAYLOAD(frame, cmd_lcdGoto_t);
+
     // printf("rfAdapter_receiveLcdGoto()");
     lcd_goto(data->x, data->y);
 }
@@ -323,13 +335,19 @@ void rfAdapter_receiveLcdGoto(cmd_lcdGoto_t* data)
 /*!
  *  Handler that's called when command CMD_LCD_PRINT was received
  *
- *  \param data Payload of received frame
+ *  \param frame Received frame
  */
-void rfAdapter_receiveLcdPrint(cmd_lcdPrint_t* data)
+void rfAdapter_receiveLcdPrint(frame_t* frame)
 {
+    cmd_lcdPrint_t* data = FRAME_PAYLOAD(frame, cmd_lcdPrint_t);
+
     // printf("rfAdapter_receiveLcdPrint()");
-    if (data->length > 32)
+    // The announced string length has to match the length of the payload
+    if (data->length > 32 || data->length != frame->header.length - sizeof(command_t) - sizeof(data->length))
+    {
+        printf_P(PSTR("Invalid length for CMD_LCD_PRINT. Length of expected String is not equal to length described in cmd_lcdPrint_t object\n"));
         return;
+    }
 
     char buffer[33];
     memcpy(buffer, data->message, data->length);
@@ -345,16 +363,13 @@ void rfAdapter_receiveLcdPrint(cmd_lcdPrint_t* data)
  */
 void rfAdapter_sendSetLed(address_t destAddr, bool enable)
 {
+    frame_t* frame = serialAdapter_allocFrame(destAddr, CMD_SET_LED);
+    if (frame == NULL)
+        return;
 
-    inner_frame_t inner_frame;
-    inner_frame.command = CMD_SET_LED;
-    inner_frame.payload[0] = enable;
-
-    int size = sizeof(command_t) + sizeof(enable);
-
-    printf("rfAdapter_sendSetLed() with size: %d\n", size);
+    FRAME_PAYLOAD(frame, cmd_setLed_t)->enable = enable;
 
-    serialAdapter_writeFrame(destAddr, size, &inner_frame);
+    serialAdapter_sendFrame(frame, sizeof(command_t) + sizeof(cmd_setLed_t));
 }
 
 /*!
@@ -364,14 +379,11 @@ void rfAdapter_sendSetLed(address_t destAddr, bool enable)
  */
 void rfAdapter_sendToggleLed(address_t destAddr)
 {
-    inner_frame_t inner_frame;
-    inner_frame.command = CMD_TOGGLE_LED;
-
-    int size = sizeof(command_t);
-
-    printf("rfAdapter_sendToggleLed() with size: %d\n", size);
+    frame_t* frame = serialAdapter_allocFrame(destAddr, CMD_TOGGLE_LED);
+    if (frame == NULL)
+        return;
 
-    serialAdapter_writeFrame(destAddr, size, &inner_frame);
+    serialAdapter_sendFrame(frame, sizeof(command_t));
 }
 
 /*!
@@ -381,14 +393,11 @@ void rfAdapter_sendToggleLed(address_t destAddr)
  */
 void rfAdapter_sendLcdClear(address_t destAddr)
 {
-    inner_frame_t inner_frame;
-    inner_frame.command = CMD_LCD_CLEAR;
-
-    int size = sizeof(command_t);
-
-    printf("rfAdapter_sendLcdClear() with size: %d\n", size);
+    frame_t* frame = serialAdapter_allocFrame(destAddr, CMD_LCD_CLEAR);
+    if (frame == NULL)
+        return;
 
-    serialAdapter_writeFrame(destAddr, size, &inner_frame);
+    serialAdapter_sendFrame(frame, sizeof(command_t));
 }
 
 /*!
@@ -400,19 +409,15 @@ void rfAdapter_sendLcdClear(address_t destAddr)
  */
 void rfAdapter_sendLcdGoto(address_t destAddr, uint8_t x, uint8_t y)
 {
-    inner_frame_t inner_frame;
-    inner_frame.command = CMD_LCD_GOTO;
-
-    cmd_lcdGoto_t cmd;
-    cmd.x = x;
-    cmd.y = y;
-    memcpy(&inner_frame.payload, &cmd, sizeof(cmd));
-
-    int size = sizeof(command_t) + sizeof(cmd_lcdGoto_t);
+    frame_t* frame = serialAdapter_allocFrame(destAddr, CMD_LCD_GOTO);
+    if (frame == NULL)
+        return;
 
-    printf("rfAdapter_sendLcdGoto() with size: %d\n", size);
+    cmd_lcdGoto_t* cmd = FRAME_PAYLOAD(frame, cmd_lcdGoto_t);
+    cmd->x = x;
+    cmd->y = y;
 
-    serialAdapter_writeFrame(destAddr, size, &inner_frame);
+    serialAdapter_sendFrame(frame, sizeof(command_t) + sizeof(cmd_lcdGoto_t));
 }
 
 /*!
@@ -423,19 +428,17 @@ void rfAdapter_sendLcdGoto(address_t destAddr, uint8_t x, uint8_t y)
  */
 void rfAdapter_sendLcdPrint(address_t destAddr, const char* message)
 {
-    inner_frame_t inner_frame;
-    inner_frame.command = CMD_LCD_PRINT;
+    frame_t* frame = serialAdapter_allocFrame(destAddr, CMD_LCD_PRINT);
+    if (frame == NULL)
+        return;
 
-    cmd_lcdPrint_t* print;
-    print = (cmd_lcdPrint_t*)&inner_frame.payload;
+    cmd_lcdPrint_t* print = FRAME_PAYLOAD(frame, cmd_lcdPrint_t);
 
     print->length = strlen(message) < 32 ? strlen(message) : 32;
 
     memcpy(print->message, message, print->length);
 
-    printf("rfAdapter_sendLcdPrint() with size: %d\n", print->length);
-
-    serialAdapter_writeFrame(destAddr, sizeof(command_t) + print->length + 1, &inner_frame);
+    serialAdapter_sendFrame(frame, sizeof(command_t) + print->length + 1);
 }
 
 /*!
@@ -446,27 +449,28 @@ void rfAdapter_sendLcdPrint(address_t destAddr, const char* message)
  */
 void rfAdapter_sendLcdPrintProcMem(address_t destAddr, const char* message)
 {
-    inner_frame_t inner_frame;
-    inner_frame.command = CMD_LCD_PRINT;
+    frame_t* frame = serialAdapter_allocFrame(destAddr, CMD_LCD_PRINT);
+    if (frame == NULL)
+        return;
 
-    cmd_lcdPrint_t* print;
-    print = (cmd_lcdPrint_t*)&inner_frame.payload;
+    cmd_lcdPrint_t* print = FRAME_PAYLOAD(frame, cmd_lcdPrint_t);
 
     print->length = strlen_P(message) < 32 ? strlen_P(message) : 32;
 
     memcpy_P(print->message, message, print->length);
 
-    printf("rfAdapter_sendLcdPrint() with size: %d\n", print->length);
-
-    serialAdapter_writeFrame(destAddr, sizeof(command_t) + print->length + 1, &inner_frame);
+    serialAdapter_sendFrame(frame, sizeof(command_t) + print->length + 1);
 }
 
 void print_sensor_data(sensor_data_t* sensor_data)
 {
+    char value[FIXED_POINT_MAX_LENGTH + 1];
+    fixedPoint_format(value, sensor_data->sensor_fixed_value, sensorData_getDecimals(sensor_data->sensor_data_type), 0, NULL);
+
     printf_P(PSTR("{\nsensor_src_address: %d\n"), sensor_data->sensor_src_address);
     printf_P(PSTR("sensor_type: %d\n"), sensor_data->sensor_type);
     printf_P(PSTR("sensor_data_type: %d\n"), sensor_data->sensor_data_type);
-    printf_P(PSTR("sensor_data_value: %f\n"), sensor_data->sensor_data_value.fValue);
+    printf_P(PSTR("sensor_data_value: %s\n"), value);
     printf_P(PSTR("sensor_last_update: %d\n"), sensor_data->sensor_last_update);
     printf_P(PSTR("}\n"));
 }
\ No newline at end of file
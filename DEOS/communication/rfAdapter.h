@@ -26,7 +26,10 @@ typedef enum rfAdapterCommand
     CMD_LCD_CLEAR = 0x10,
     CMD_LCD_GOTO = 0x11,
     CMD_LCD_PRINT = 0x12,
-    CMD_SENSOR_DATA = 0x20
+    CMD_SENSOR_DATA = 0x20,
+    CMD_RELIABLE_DATA = 0x30,
+    CMD_RELIABLE_ACK = 0x31,
+    CMD_ROUTE_ADVERTISEMENT = 0x40
 } rfAdapterCommand_t;
 
 //! Command payload of command CMD_SET_LED
@@ -49,6 +52,19 @@ typedef struct cmd_lcdPrint
     char message[32];
 } cmd_lcdPrint_t;
 
+//! Maximum number of commands that can be registered (slot indices are 4 bit)
+#define RF_ADAPTER_MAX_COMMANDS 15
+
+//! Number of entries of the sensor table (sensor types are used as index)
+#define RF_ADAPTER_SENSOR_TYPE_COUNT (SENSOR_SCD41 + 1)
+
+//! This is the type of a command handler (not the pointer to one!).
+//! The frame is passed by reference and only valid during the call.
+typedef void rfAdapter_commandHandler_t(frame_t* frame);
+
+//! This is the type of a sensor data handler (not the pointer to one!).
+typedef void rfAdapter_sensorHandler_t(sensor_data_t* sensor_data);
+
 
 
 void print_sensor_data(sensor_data_t* sensor_data);
@@ -84,6 +100,13 @@ void rfAdapter_sendLcdPrint(address_t destAddr, const char* message);
 //! Sends a frame with command CMD_LCD_PRINT with a message from program memory
 void rfAdapter_sendLcdPrintProcMem(address_t destAddr, const char* message);
 
+//! Registers a handler for a command and the allowed payload length range
+bool rfAdapter_registerCommand(command_t command, uint8_t minLength, uint8_t maxLength, rfAdapter_commandHandler_t* handler);
+
+//! Registers a handler for sensor data of a sensor type and parameter type
+bool rfAdapter_registerSensor(sensor_type_t sensor, sensor_parameter_type_t paramType, rfAdapter_sensorHandler_t* handler);
+
+//! Forwards received sensor data to the handler registered for it
 void rfAdapter_receiveSensorData(sensor_data_t* sensor_data);
 
 #endif /* RF_ADAPTER_H_ */
\ No newline at end of file
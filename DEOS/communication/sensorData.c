@@ -0,0 +1,71 @@
+/*!
+ *  \brief Fixed point representation of sensor values.
+ *
+ *  \author   Fachbereich 5 - FH Aachen
+ *  \date     2024
+ *  \version  1.0
+ */
+
+#include "sensorData.h"
+#include "../lib/fixed_point.h"
+
+/*!
+ *  Returns the number of decimals values of a parameter type are kept with
+ *  as fixed point numbers. Float values are kept with the resolution the GUI
+ *  displays them with, integer values are kept as they are.
+ *
+ *  \param paramType The parameter type
+ *  \return The number of decimals, 0 for integer values
+ */
+uint8_t sensorData_getDecimals(sensor_parameter_type_t paramType)
+{
+    switch (paramType)
+    {
+        case PARAM_ALTITUDE_M:
+        case PARAM_TVOC_PPB:
+        case PARAM_CO2_PPM:
+            return 0;
+        default:
+            return 1;
+    }
+}
+
+/*!
+ *  Converts a received sensor value to a fixed point number
+ *
+ *  \param paramType The parameter type of the value
+ *  \param value The value as it was sent
+ *  \return The value with sensorData_getDecimals() decimals
+ */
+int32_t sensorData_toFixed(sensor_parameter_type_t paramType, sensor_parameter_t value)
+{
+    uint8_t decimals = sensorData_getDecimals(paramType);
+    if (decimals == 0)
+    {
+        return value.iValue;
+    }
+    return fixedPoint_fromFloat(value.fValue, decimals);
+}
+
+/*!
+ *  Converts a fixed point number back to a sensor value as it would be sent
+ *
+ *  \param paramType The parameter type of the value
+ *  \param fixed The value with sensorData_getDecimals() decimals
+ *  \return The value
+ */
+sensor_parameter_t sensorData_fromFixed(sensor_parameter_type_t paramType, int32_t fixed)
+{
+    sensor_parameter_t value;
+    uint8_t decimals = sensorData_getDecimals(paramType);
+
+    if (decimals == 0)
+    {
+        value.iValue = fixed;
+    }
+    else
+    {
+        value.fValue = fixedPoint_toFloat(fixed, decimals);
+    }
+    return value;
+}
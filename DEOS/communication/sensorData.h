@@ -60,6 +60,12 @@ typedef struct cmd_sensorData
     sensor_parameter_t param;
 } cmd_sensorData_t;
 
+//! Stable handle of a sensor value (address, sensor and parameter type), see sensorRegistry.h
+typedef uint8_t sensor_handle_t;
+
+//! Handle of a sensor value that is not registered
+#define SENSOR_HANDLE_INVALID 0xFF
+
  //cached data of a received sensor data frame
 typedef struct
 {
@@ -68,7 +74,18 @@ typedef struct
     sensor_parameter_type_t sensor_data_type;
     sensor_parameter_t sensor_data_value;
     time_t sensor_last_update;
+    sensor_handle_t sensor_handle; //!< Set by rfAdapter_receiveSensorData
+    int32_t sensor_fixed_value; //!< sensor_data_value with sensorData_getDecimals() decimals, set by rfAdapter_receiveSensorData
 } sensor_data_t;
 
+//! Returns the number of decimals values of a parameter type are kept with as fixed point numbers
+uint8_t sensorData_getDecimals(sensor_parameter_type_t paramType);
+
+//! Converts a received sensor value to a fixed point number with sensorData_getDecimals() decimals
+int32_t sensorData_toFixed(sensor_parameter_type_t paramType, sensor_parameter_t value);
+
+//! Converts a fixed point number with sensorData_getDecimals() decimals back to a sensor value
+sensor_parameter_t sensorData_fromFixed(sensor_parameter_type_t paramType, int32_t fixed);
+
 
 #endif /* SENSORDATA_H_ */
\ No newline at end of file
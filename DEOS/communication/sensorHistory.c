@@ -0,0 +1,610 @@
+/*!
+ *  \brief Compressed time series of received sensor values.
+ *
+ *  \author   Fachbereich 5 - FH Aachen
+ *  \date     2024
+ *  \version  1.0
+ */
+
+#include "sensorHistory.h"
+#include "sensorRegistry.h"
+#include "../lib/terminal.h"
+#include "../os_scheduler.h"
+
+#include <string.h>
+
+//----------------------------------------------------------------------------
+// Defines
+//----------------------------------------------------------------------------
+
+//! Marks a missing block
+#define BLOCK_NONE 0xFF
+
+//! Byte that ends the tokens of a block that is not filled completely
+#define BLOCK_END 0x02
+
+//! Low bits of the first byte of a token
+#define TOKEN_REGULAR   0x00 //!< Sample at the previous interval: value delta
+#define TOKEN_IRREGULAR 0x01 //!< Sample at another interval: value delta, change of the interval
+#define TOKEN_RUN       0x03 //!< Repeated samples at the previous interval, count 0 resets the state
+#define TOKEN_MASK      0x03
+
+//! Length of a token that resets the state: marker, value and time
+#define TOKEN_RESET_LENGTH 9
+
+//! Longest token: irregular sample with two 32 bit varints
+#define TOKEN_MAX_LENGTH 10
+
+//----------------------------------------------------------------------------
+// Types
+//----------------------------------------------------------------------------
+
+//! State the tokens of a series are decoded with
+typedef struct SensorHistoryState
+{
+    uint32_t time;  //!< In SENSOR_HISTORY_TIME_UNIT_MS
+    int32_t delta;  //!< Interval to the previous sample
+    int32_t value;  //!< Fixed point value
+} sensor_history_state_t;
+
+//! A series of samples. The first sample is kept in head, the tokens of the
+//! blocks describe the following ones.
+typedef struct SensorSeries
+{
+    sensor_parameter_type_t paramType;
+    uint16_t count;       //!< Number of samples, 0 if the series is free
+    uint8_t headBlock;    //!< Block with the oldest tokens
+    uint8_t tailBlock;    //!< Block new tokens are appended to
+    uint8_t tailUsed;     //!< Bytes used in the tail block, including the link
+    uint8_t runOffset;    //!< Position of the run token at the end of the tail block, 0 if there is none
+    uint8_t blockCount;
+    sensor_history_state_t head; //!< Oldest sample
+    sensor_history_state_t last; //!< Newest sample
+} sensor_series_t;
+
+//----------------------------------------------------------------------------
+// Globals
+//----------------------------------------------------------------------------
+
+//! The series, the handle of the sensor value is the index
+static sensor_series_t sensorHistory_series[SENSOR_HISTORY_SERIES_COUNT];
+
+//! The block pool. The first byte of a block links to the next block of its series or the free list
+static uint8_t sensorHistory_blocks[SENSOR_HISTORY_BLOCK_COUNT][SENSOR_HISTORY_BLOCK_SIZE];
+
+//! Rollups of the series, same index as sensorHistory_series
+static sensor_rollups_t sensorHistory_rollups[SENSOR_HISTORY_SERIES_COUNT];
+
+//! First free block
+static uint8_t sensorHistory_freeBlock = BLOCK_NONE;
+
+//! Whether the free list was built
+static bool sensorHistory_initialized = false;
+
+//----------------------------------------------------------------------------
+// Private functions
+//----------------------------------------------------------------------------
+
+/*!
+ *  Puts all blocks into the free list and frees all series.
+ *  Must be called from within a critical section.
+ */
+static void sensorHistory_init(void)
+{
+    for (uint8_t i = 0; i < SENSOR_HISTORY_BLOCK_COUNT; i++)
+    {
+        sensorHistory_blocks[i][0] = i + 1 < SENSOR_HISTORY_BLOCK_COUNT ? i + 1 : BLOCK_NONE;
+    }
+    sensorHistory_freeBlock = 0;
+    memset(sensorHistory_series, 0, sizeof(sensorHistory_series));
+    sensorHistory_initialized = true;
+}
+
+/*!
+ *  Looks up the series of a sensor value.
+ *  Must be called from within a critical section.
+ *
+ *  \return The series or NULL if none exists
+ */
+static sensor_series_t* sensorHistory_find(address_t address, sensor_type_t sensor, sensor_parameter_type_t paramType)
+{
+    sensor_handle_t handle = sensorRegistry_lookup(address, sensor, paramType);
+    if (handle == SENSOR_HANDLE_INVALID || sensorHistory_series[handle].count == 0)
+    {
+        return NULL;
+    }
+    return &sensorHistory_series[handle];
+}
+
+//! Maps signed deltas to unsigned numbers, small magnitudes to small numbers
+static uint32_t sensorHistory_zigzag(int32_t value)
+{
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+//! Reverts sensorHistory_zigzag
+static int32_t sensorHistory_unzigzag(uint32_t value)
+{
+    return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+/*!
+ *  Writes a number as varint, 7 bits per byte with the highest bit set if
+ *  another byte follows.
+ *
+ *  \return Number of bytes written
+ */
+static uint8_t sensorHistory_writeVarint(uint8_t* data, uint32_t value)
+{
+    uint8_t length = 0;
+    while (value >= 0x80)
+    {
+        data[length++] = (uint8_t)value | 0x80;
+        value >>= 7;
+    }
+    data[length++] = (uint8_t)value;
+    return length;
+}
+
+/*!
+ *  Reads a varint written by sensorHistory_writeVarint
+ *
+ *  \return Number of bytes read
+ */
+static uint8_t sensorHistory_readVarint(uint8_t const* data, uint32_t* value)
+{
+    uint8_t length = 0;
+    uint8_t shift = 0;
+    *value = 0;
+    do
+    {
+        *value |= (uint32_t)(data[length] & 0x7F) << shift;
+        shift += 7;
+    } while (data[length++] & 0x80);
+    return length;
+}
+
+/*!
+ *  Decodes a token and applies its first sample to the state
+ *
+ *  \param data First byte of the token
+ *  \param state State of the previous sample
+ *  \param repeat Number of further samples at the same interval described by the token
+ *  \return Length of the token
+ */
+static uint8_t sensorHistory_decode(uint8_t const* data, sensor_history_state_t* state, uint8_t* repeat)
+{
+    uint32_t token;
+    uint8_t length = sensorHistory_readVarint(data, &token);
+    *repeat = 0;
+
+    if ((token & TOKEN_MASK) == TOKEN_RUN)
+    {
+        uint8_t count = token >> 2;
+        if (count == 0)
+        {
+            memcpy(&state->value, &data[length], sizeof(int32_t));
+            memcpy(&state->time, &data[length + sizeof(int32_t)], sizeof(uint32_t));
+            state->delta = 0;
+            return TOKEN_RESET_LENGTH;
+        }
+        state->time += state->delta;
+        *repeat = count - 1;
+        return length;
+    }
+
+    if ((token & TOKEN_MASK) == TOKEN_IRREGULAR)
+    {
+        uint32_t deltaOfDelta;
+        length += sensorHistory_readVarint(&data[length], &deltaOfDelta);
+        state->delta += sensorHistory_unzigzag(deltaOfDelta);
+    }
+    state->time += state->delta;
+    state->value += sensorHistory_unzigzag(token >> 2);
+    return length;
+}
+
+/*!
+ *  Encodes a sample as token
+ *
+ *  \param data Buffer of at least TOKEN_MAX_LENGTH bytes
+ *  \param last State of the previous sample
+ *  \param next State of the sample, its delta is set to the one the token describes
+ *  \return Length of the token
+ */
+static uint8_t sensorHistory_encode(uint8_t* data, sensor_history_state_t const* last, sensor_history_state_t* next)
+{
+    int32_t deltaOfDelta = next->delta - last->delta;
+    uint32_t valueDelta = sensorHistory_zigzag(next->value - last->value);
+
+    // Deltas that do not fit next to the tag, the sample is stored as is
+    if (valueDelta >= (1UL << 30))
+    {
+        data[0] = TOKEN_RUN;
+        memcpy(&data[1], &next->value, sizeof(int32_t));
+        memcpy(&data[1 + sizeof(int32_t)], &next->time, sizeof(uint32_t));
+        next->delta = 0;
+        return TOKEN_RESET_LENGTH;
+    }
+    if (valueDelta == 0 && deltaOfDelta == 0)
+    {
+        data[0] = (1 << 2) | TOKEN_RUN;
+        return 1;
+    }
+    if (deltaOfDelta == 0)
+    {
+        return sensorHistory_writeVarint(data, (valueDelta << 2) | TOKEN_REGULAR);
+    }
+
+    uint8_t length = sensorHistory_writeVarint(data, (valueDelta << 2) | TOKEN_IRREGULAR);
+    return length + sensorHistory_writeVarint(&data[length], sensorHistory_zigzag(deltaOfDelta));
+}
+
+//! Returns the number of bytes used in a block of a series, including the link
+static uint8_t sensorHistory_blockUsed(sensor_series_t const* series, uint8_t block)
+{
+    return block == series->tailBlock ? series->tailUsed : SENSOR_HISTORY_BLOCK_SIZE;
+}
+
+/*!
+ *  Drops the oldest block of a series, its last sample becomes the head of
+ *  the series. Must be called from within a critical section.
+ *
+ *  \param series Series with at least two blocks
+ */
+static void sensorHistory_dropHead(sensor_series_t* series)
+{
+    uint8_t block = series->headBlock;
+    uint8_t const* data = sensorHistory_blocks[block];
+    uint8_t used = sensorHistory_blockUsed(series, block);
+    uint8_t repeat;
+
+    for (uint8_t offset = 1; offset < used && data[offset] != BLOCK_END;)
+    {
+        offset += sensorHistory_decode(&data[offset], &series->head, &repeat);
+        series->head.time += (uint32_t)series->head.delta * repeat;
+        series->count -= 1 + repeat;
+    }
+
+    series->headBlock = data[0];
+    series->blockCount--;
+    sensorHistory_blocks[block][0] = sensorHistory_freeBlock;
+    sensorHistory_freeBlock = block;
+}
+
+/*!
+ *  Takes a block from the free list. If it is empty, the oldest block of
+ *  the series with the most blocks is dropped first.
+ *  Must be called from within a critical section.
+ *
+ *  \return Index of the block
+ */
+static uint8_t sensorHistory_allocBlock(void)
+{
+    if (sensorHistory_freeBlock == BLOCK_NONE)
+    {
+        // There are more blocks than series, so the longest one has at least two
+        sensor_series_t* longest = &sensorHistory_series[0];
+        for (uint8_t i = 1; i < SENSOR_HISTORY_SERIES_COUNT; i++)
+        {
+            if (sensorHistory_series[i].blockCount > longest->blockCount)
+            {
+                longest = &sensorHistory_series[i];
+            }
+        }
+        sensorHistory_dropHead(longest);
+    }
+
+    uint8_t block = sensorHistory_freeBlock;
+    sensorHistory_freeBlock = sensorHistory_blocks[block][0];
+    sensorHistory_blocks[block][0] = BLOCK_NONE;
+    return block;
+}
+
+/*!
+ *  Appends a token to the tail block of a series, a new block is started if
+ *  it does not fit. Must be called from within a critical section.
+ *
+ *  \return Position of the token within the tail block
+ */
+static uint8_t sensorHistory_write(sensor_series_t* series, uint8_t const* token, uint8_t length)
+{
+    if (series->tailBlock == BLOCK_NONE || series->tailUsed + length > SENSOR_HISTORY_BLOCK_SIZE)
+    {
+        uint8_t block = sensorHistory_allocBlock();
+
+        if (series->tailBlock == BLOCK_NONE)
+        {
+            series->headBlock = block;
+        }
+        else
+        {
+            if (series->tailUsed < SENSOR_HISTORY_BLOCK_SIZE)
+            {
+                sensorHistory_blocks[series->tailBlock][series->tailUsed] = BLOCK_END;
+            }
+            sensorHistory_blocks[series->tailBlock][0] = block;
+        }
+        series->tailBlock = block;
+        series->tailUsed = 1;
+        series->blockCount++;
+    }
+
+    uint8_t offset = series->tailUsed;
+    memcpy(&sensorHistory_blocks[series->tailBlock][offset], token, length);
+    series->tailUsed += length;
+    return offset;
+}
+
+//! Converts a state back to a sample
+static sensor_sample_t sensorHistory_toSample(sensor_series_t const* series, sensor_history_state_t const* state)
+{
+    sensor_sample_t sample;
+    sample.time = (time_t)state->time * SENSOR_HISTORY_TIME_UNIT_MS;
+    sample.value = sensorData_fromFixed(series->paramType, state->value);
+    return sample;
+}
+
+//----------------------------------------------------------------------------
+// Public functions
+//----------------------------------------------------------------------------
+
+/*!
+ *  Appends received sensor data to the series of its handle. The series is
+ *  created on the first value. Takes O(1), apart from dropping old samples
+ *  when the pool is full.
+ *
+ *  \param sensorData Received sensor data with the handle and the fixed point value set
+ *  \return False if the sensor value is not registered
+ */
+bool sensorHistory_append(sensor_data_t const* sensorData)
+{
+    sensor_history_state_t next;
+    next.time = sensorData->sensor_last_update / SENSOR_HISTORY_TIME_UNIT_MS;
+    next.value = sensorData->sensor_fixed_value;
+
+    if (sensorData->sensor_handle >= SENSOR_HISTORY_SERIES_COUNT)
+    {
+        return false;
+    }
+
+    os_enterCriticalSection();
+
+    if (!sensorHistory_initialized)
+    {
+        sensorHistory_init();
+    }
+
+    sensor_series_t* series = &sensorHistory_series[sensorData->sensor_handle];
+
+    if (series->count == 0)
+    {
+        next.delta = 0;
+        series->paramType = sensorData->sensor_data_type;
+        series->count = 1;
+        series->headBlock = BLOCK_NONE;
+        series->tailBlock = BLOCK_NONE;
+        series->runOffset = 0;
+        series->blockCount = 0;
+        series->head = next;
+        series->last = next;
+        sensorRollup_init(&sensorHistory_rollups[series - sensorHistory_series], next.value);
+        sensorRollup_add(&sensorHistory_rollups[series - sensorHistory_series], sensorData->sensor_last_update, next.value);
+        os_leaveCriticalSection();
+        return true;
+    }
+
+    next.delta = next.time - series->last.time;
+
+    uint8_t* run = series->runOffset == 0 ? NULL : &sensorHistory_blocks[series->tailBlock][series->runOffset];
+    if (run != NULL && next.value == series->last.value && next.delta == series->last.delta && (*run >> 2) < SENSOR_HISTORY_MAX_RUN)
+    {
+        // Extend the run at the end of the tail block
+        *run += 1 << 2;
+    }
+    else
+    {
+        uint8_t token[TOKEN_MAX_LENGTH];
+        uint8_t length = sensorHistory_encode(token, &series->last, &next);
+        uint8_t offset = sensorHistory_write(series, token, length);
+        series->runOffset = token[0] == ((1 << 2) | TOKEN_RUN) ? offset : 0;
+    }
+
+    series->last = next;
+    series->count++;
+    sensorRollup_add(&sensorHistory_rollups[series - sensorHistory_series], sensorData->sensor_last_update, next.value);
+
+    os_leaveCriticalSection();
+    return true;
+}
+
+/*!
+ *  Copies the samples of a series that were received within [from, to],
+ *  oldest first.
+ *
+ *  \param address Sender of the values
+ *  \param sensor Sensor type
+ *  \param paramType Parameter type
+ *  \param from Start of the time range in ms
+ *  \param to End of the time range in ms
+ *  \param samples Buffer for the samples
+ *  \param maxSamples Capacity of the buffer
+ *  \return Number of samples copied
+ */
+uint16_t sensorHistory_query(address_t address, sensor_type_t sensor, sensor_parameter_type_t paramType, time_t from, time_t to, sensor_sample_t* samples, uint16_t maxSamples)
+{
+    uint16_t found = 0;
+    uint8_t repeat = 0;
+
+    os_enterCriticalSection();
+
+    sensor_series_t* series = sensorHistory_find(address, sensor, paramType);
+    if (series == NULL || maxSamples == 0)
+    {
+        os_leaveCriticalSection();
+        return 0;
+    }
+
+    sensor_history_state_t state = series->head;
+    uint8_t block = series->headBlock;
+    uint8_t offset = 1;
+
+    // The first sample is the head itself, the tokens describe the following ones
+    for (uint16_t i = 1;; i++)
+    {
+        time_t time = (time_t)state.time * SENSOR_HISTORY_TIME_UNIT_MS;
+        if (time > to)
+        {
+            break;
+        }
+        if (time >= from)
+        {
+            samples[found++] = sensorHistory_toSample(series, &state);
+        }
+        if (found == maxSamples || i == series->count)
+        {
+            break;
+        }
+
+        if (repeat != 0)
+        {
+            state.time += state.delta;
+            repeat--;
+            continue;
+        }
+
+        // Tokens never span blocks, continue with the next one at the end of a block
+        if (offset >= sensorHistory_blockUsed(series, block) || sensorHistory_blocks[block][offset] == BLOCK_END)
+        {
+            block = sensorHistory_blocks[block][0];
+            offset = 1;
+        }
+        offset += sensorHistory_decode(&sensorHistory_blocks[block][offset], &state, &repeat);
+    }
+
+    os_leaveCriticalSection();
+    return found;
+}
+
+/*!
+ *  Returns the newest sample of a series
+ *
+ *  \param sample Receives the sample, stays unchanged if the series is unknown
+ *  \return False if the series is unknown
+ */
+bool sensorHistory_getLatest(address_t address, sensor_type_t sensor, sensor_parameter_type_t paramType, sensor_sample_t* sample)
+{
+    os_enterCriticalSection();
+    sensor_series_t* series = sensorHistory_find(address, sensor, paramType);
+    if (series != NULL)
+    {
+        *sample = sensorHistory_toSample(series, &series->last);
+    }
+    os_leaveCriticalSection();
+
+    return series != NULL;
+}
+
+/*!
+ *  Returns the number of samples of a series
+ *
+ *  \return The number or 0 if the series is unknown
+ */
+uint16_t sensorHistory_getCount(address_t address, sensor_type_t sensor, sensor_parameter_type_t paramType)
+{
+    os_enterCriticalSection();
+    sensor_series_t* series = sensorHistory_find(address, sensor, paramType);
+    uint16_t count = series == NULL ? 0 : series->count;
+    os_leaveCriticalSection();
+
+    return count;
+}
+
+/*!
+ *  Copies the newest rollups of a series, oldest first. Minutes or hours
+ *  without samples are included with count 0.
+ *
+ *  \param address Sender of the values
+ *  \param sensor Sensor type
+ *  \param paramType Parameter type
+ *  \param granularity Minutes or hours
+ *  \param rollups Buffer for the rollups
+ *  \param maxRollups Capacity of the buffer
+ *  \return Number of rollups copied
+ */
+uint8_t sensorHistory_getRollups(address_t address, sensor_type_t sensor, sensor_parameter_type_t paramType, sensor_rollup_granularity_t granularity, sensor_rollup_t* rollups, uint8_t maxRollups)
+{
+    sensor_rollup_entry_t entry;
+
+    os_enterCriticalSection();
+
+    sensor_series_t* series = sensorHistory_find(address, sensor, paramType);
+    if (series == NULL)
+    {
+        os_leaveCriticalSection();
+        return 0;
+    }
+
+    sensor_rollups_t const* seriesRollups = &sensorHistory_rollups[series - sensorHistory_series];
+    uint8_t count = sensorRollup_getCount(seriesRollups, granularity);
+    if (count > maxRollups)
+    {
+        count = maxRollups;
+    }
+
+    // Entries are addressed by age, the newest ones are copied oldest first
+    for (uint8_t i = 0; i < count; i++)
+    {
+        sensor_rollup_t* rollup = &rollups[i];
+        time_t start;
+        sensorRollup_get(seriesRollups, granularity, count - 1 - i, &entry, &start);
+        rollup->start = start;
+        rollup->min = sensorData_fromFixed(paramType, seriesRollups->reference + entry.min);
+        rollup->max = sensorData_fromFixed(paramType, seriesRollups->reference + entry.max);
+        rollup->mean = sensorData_fromFixed(paramType, seriesRollups->reference + entry.mean);
+        rollup->count = entry.count;
+    }
+
+    os_leaveCriticalSection();
+    return count;
+}
+
+/*!
+ *  Drops all series and frees their blocks
+ */
+void sensorHistory_clear(void)
+{
+    os_enterCriticalSection();
+    sensorHistory_init();
+    os_leaveCriticalSection();
+}
+
+/*!
+ *  Prints the series and the usage of the block pool to the terminal
+ */
+void sensorHistory_printStats(void)
+{
+    sensor_series_t series;
+    address_t address;
+    sensor_type_t sensor;
+    sensor_parameter_type_t paramType;
+    uint8_t blocks = 0;
+
+    for (sensor_handle_t handle = 0; sensorRegistry_getKey(handle, &address, &sensor, &paramType); handle++)
+    {
+        os_enterCriticalSection();
+        series = sensorHistory_series[handle];
+        os_leaveCriticalSection();
+
+        if (series.count == 0)
+        {
+            continue;
+        }
+        blocks += series.blockCount;
+
+        unsigned long span = (series.last.time - series.head.time) / (1000 / SENSOR_HISTORY_TIME_UNIT_MS);
+        INFO("History %u/%u/%u: %u samples in %u blocks, %lu s", address, sensor, paramType, series.count, series.blockCount, span);
+    }
+
+    INFO("History: %u of %u blocks used", blocks, SENSOR_HISTORY_BLOCK_COUNT);
+}
@@ -0,0 +1,83 @@
+/*!
+ *  \brief Compressed time series of received sensor values.
+ *
+ *  One series is kept per registered sensor value (see sensorRegistry.h).
+ *  Values are kept as fixed point numbers (see sensorData_getDecimals) and
+ *  stored together with their timestamps as delta encoded, zigzag varint
+ *  tokens in a block pool that is shared by all series. A sample at the
+ *  regular interval costs one byte as long as the value changes by at most
+ *  15 steps of its resolution, repeated values are merged into runs of up to
+ *  SENSOR_HISTORY_MAX_RUN samples per byte.
+ *  When the pool is full, the oldest block of the longest series is dropped.
+ *  Every series also keeps minute and hour rollups (see sensorRollup.h) for
+ *  trends beyond the raw samples.
+ *
+ *  \author   Fachbereich 5 - FH Aachen
+ *  \date     2024
+ *  \version  1.0
+ */
+
+#ifndef SENSOR_HISTORY_H_
+#define SENSOR_HISTORY_H_
+
+#include "sensorData.h"
+#include "sensorRegistry.h"
+#include "sensorRollup.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+//! Number of series that can be kept, one per registered sensor value
+#define SENSOR_HISTORY_SERIES_COUNT SENSOR_REGISTRY_SIZE
+
+//! Size of a block of the pool, including the link to the next block
+#define SENSOR_HISTORY_BLOCK_SIZE 32
+
+//! Number of blocks of the pool
+#define SENSOR_HISTORY_BLOCK_COUNT 24
+
+//! Resolution of the stored timestamps
+#define SENSOR_HISTORY_TIME_UNIT_MS 100
+
+//! Maximum number of repeated samples stored in one byte
+#define SENSOR_HISTORY_MAX_RUN 31
+
+//! A sample of a series
+typedef struct SensorSample
+{
+    time_t time;              //!< Time of reception in ms, rounded down to SENSOR_HISTORY_TIME_UNIT_MS
+    sensor_parameter_t value; //!< Value rounded to the resolution of the series
+} sensor_sample_t;
+
+//! Minimum, maximum and mean of the samples of a minute or hour
+typedef struct SensorRollup
+{
+    time_t start;             //!< Start of the minute or hour in ms
+    sensor_parameter_t min;
+    sensor_parameter_t max;
+    sensor_parameter_t mean;
+    uint16_t count;           //!< Number of samples, the values are invalid if 0
+} sensor_rollup_t;
+
+//! Appends received sensor data to the series of its handle, returns false if the handle is invalid
+bool sensorHistory_append(sensor_data_t const *sensorData);
+
+//! Copies the samples within [from, to] of a series, returns their number
+uint16_t sensorHistory_query(address_t address, sensor_type_t sensor, sensor_parameter_type_t paramType, time_t from, time_t to, sensor_sample_t *samples, uint16_t maxSamples);
+
+//! Returns the newest sample of a series, false if the series is unknown
+bool sensorHistory_getLatest(address_t address, sensor_type_t sensor, sensor_parameter_type_t paramType, sensor_sample_t *sample);
+
+//! Returns the number of samples of a series
+uint16_t sensorHistory_getCount(address_t address, sensor_type_t sensor, sensor_parameter_type_t paramType);
+
+//! Copies the newest rollups of a series oldest first, returns their number
+uint8_t sensorHistory_getRollups(address_t address, sensor_type_t sensor, sensor_parameter_type_t paramType, sensor_rollup_granularity_t granularity, sensor_rollup_t *rollups, uint8_t maxRollups);
+
+//! Drops all series
+void sensorHistory_clear(void);
+
+//! Prints the series and the usage of the block pool to the terminal
+void sensorHistory_printStats(void);
+
+#endif /* SENSOR_HISTORY_H_ */
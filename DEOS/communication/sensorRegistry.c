@@ -0,0 +1,159 @@
+/*!
+ *  \brief Registry of the sensor values known to this node.
+ *
+ *  \author   Fachbereich 5 - FH Aachen
+ *  \date     2024
+ *  \version  1.0
+ */
+
+#include "sensorRegistry.h"
+#include "../os_scheduler.h"
+
+//----------------------------------------------------------------------------
+// Types
+//----------------------------------------------------------------------------
+
+//! Key of a registered sensor value
+typedef struct SensorKey
+{
+    address_t address;
+    sensor_type_t sensor;
+    sensor_parameter_type_t paramType;
+} sensor_key_t;
+
+//----------------------------------------------------------------------------
+// Globals
+//----------------------------------------------------------------------------
+
+//! Keys of the registered sensor values, the handle is the index
+static sensor_key_t sensorRegistry_keys[SENSOR_REGISTRY_SIZE];
+
+//! Number of registered sensor values
+static uint8_t sensorRegistry_count = 0;
+
+//! Hash table of handles, stored plus one so 0 marks a free slot
+static uint8_t sensorRegistry_slots[SENSOR_REGISTRY_SLOT_COUNT];
+
+//----------------------------------------------------------------------------
+// Private functions
+//----------------------------------------------------------------------------
+
+//! Returns the first slot to probe for a key
+static uint8_t sensorRegistry_hash(address_t address, sensor_type_t sensor, sensor_parameter_type_t paramType)
+{
+    uint8_t hash = address;
+    hash = hash * 33 + sensor;
+    hash = hash * 33 + paramType;
+    return (hash ^ (hash >> 4)) & (SENSOR_REGISTRY_SLOT_COUNT - 1);
+}
+
+/*!
+ *  Probes the hash table for a key. As there are more slots than handles,
+ *  every probe sequence ends at a free slot.
+ *  Must be called from within a critical section.
+ *
+ *  \return Slot holding the key's handle or the free slot it belongs to
+ */
+static uint8_t sensorRegistry_probe(address_t address, sensor_type_t sensor, sensor_parameter_type_t paramType)
+{
+    uint8_t slot = sensorRegistry_hash(address, sensor, paramType);
+
+    while (sensorRegistry_slots[slot] != 0)
+    {
+        sensor_key_t* key = &sensorRegistry_keys[sensorRegistry_slots[slot] - 1];
+        if (key->address == address && key->sensor == sensor && key->paramType == paramType)
+        {
+            break;
+        }
+        slot = (slot + 1) & (SENSOR_REGISTRY_SLOT_COUNT - 1);
+    }
+    return slot;
+}
+
+//----------------------------------------------------------------------------
+// Public functions
+//----------------------------------------------------------------------------
+
+/*!
+ *  Returns the handle of a sensor value and registers it, if it is new
+ *
+ *  \param address Sender of the value
+ *  \param sensor Sensor type
+ *  \param paramType Parameter type
+ *  \return The handle or SENSOR_HANDLE_INVALID if the value is new and the registry is full
+ */
+sensor_handle_t sensorRegistry_register(address_t address, sensor_type_t sensor, sensor_parameter_type_t paramType)
+{
+    os_enterCriticalSection();
+
+    uint8_t slot = sensorRegistry_probe(address, sensor, paramType);
+    sensor_handle_t handle = sensorRegistry_slots[slot] - 1;
+
+    if (sensorRegistry_slots[slot] == 0)
+    {
+        handle = SENSOR_HANDLE_INVALID;
+        if (sensorRegistry_count < SENSOR_REGISTRY_SIZE)
+        {
+            handle = sensorRegistry_count++;
+            sensorRegistry_keys[handle].address = address;
+            sensorRegistry_keys[handle].sensor = sensor;
+            sensorRegistry_keys[handle].paramType = paramType;
+            sensorRegistry_slots[slot] = handle + 1;
+        }
+    }
+
+    os_leaveCriticalSection();
+    return handle;
+}
+
+/*!
+ *  Returns the handle of a registered sensor value
+ *
+ *  \param address Sender of the value
+ *  \param sensor Sensor type
+ *  \param paramType Parameter type
+ *  \return The handle or SENSOR_HANDLE_INVALID if the value is not registered
+ */
+sensor_handle_t sensorRegistry_lookup(address_t address, sensor_type_t sensor, sensor_parameter_type_t paramType)
+{
+    os_enterCriticalSection();
+    uint8_t slot = sensorRegistry_slots[sensorRegistry_probe(address, sensor, paramType)];
+    os_leaveCriticalSection();
+
+    return slot == 0 ? SENSOR_HANDLE_INVALID : slot - 1;
+}
+
+/*!
+ *  Returns the key a handle was assigned to
+ *
+ *  \param handle The handle
+ *  \param address Receives the sender of the value
+ *  \param sensor Receives the sensor type
+ *  \param paramType Receives the parameter type
+ *  \return False if the handle is not assigned, the parameters stay unchanged then
+ */
+bool sensorRegistry_getKey(sensor_handle_t handle, address_t* address, sensor_type_t* sensor, sensor_parameter_type_t* paramType)
+{
+    os_enterCriticalSection();
+    bool assigned = handle < sensorRegistry_count;
+    if (assigned)
+    {
+        *address = sensorRegistry_keys[handle].address;
+        *sensor = sensorRegistry_keys[handle].sensor;
+        *paramType = sensorRegistry_keys[handle].paramType;
+    }
+    os_leaveCriticalSection();
+
+    return assigned;
+}
+
+/*!
+ *  Returns the number of registered sensor values. Handles are assigned
+ *  consecutively, so all handles below this number are valid.
+ *
+ *  \return The number of registered sensor values
+ */
+uint8_t sensorRegistry_getCount(void)
+{
+    return sensorRegistry_count;
+}
@@ -0,0 +1,46 @@
+/*!
+ *  \brief Registry of the sensor values known to this node.
+ *
+ *  Every sensor value is identified by the address of its sender, the
+ *  sensor type and the parameter type. The registry assigns each of them a
+ *  handle on first sight, which stays the same until the system restarts.
+ *  Handles are small consecutive numbers, so other modules (sensor history,
+ *  GUI) use them as index into their own tables instead of comparing keys.
+ *  Keys are looked up in an open addressing hash table with linear probing.
+ *
+ *  \author   Fachbereich 5 - FH Aachen
+ *  \date     2024
+ *  \version  1.0
+ */
+
+#ifndef SENSOR_REGISTRY_H_
+#define SENSOR_REGISTRY_H_
+
+#include "sensorData.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+//! Number of sensor values that can be registered, matches the number of GUI elements
+#define SENSOR_REGISTRY_SIZE 6
+
+//! Number of slots of the hash table, a power of two well above SENSOR_REGISTRY_SIZE to keep probe sequences short
+#define SENSOR_REGISTRY_SLOT_COUNT 16
+
+#if SENSOR_REGISTRY_SIZE >= SENSOR_REGISTRY_SLOT_COUNT || (SENSOR_REGISTRY_SLOT_COUNT & (SENSOR_REGISTRY_SLOT_COUNT - 1)) != 0
+#error "SENSOR_REGISTRY_SLOT_COUNT must be a power of two bigger than SENSOR_REGISTRY_SIZE"
+#endif
+
+//! Returns the handle of a sensor value, registering it if it is new. SENSOR_HANDLE_INVALID if the registry is full
+sensor_handle_t sensorRegistry_register(address_t address, sensor_type_t sensor, sensor_parameter_type_t paramType);
+
+//! Returns the handle of a sensor value or SENSOR_HANDLE_INVALID if it is not registered
+sensor_handle_t sensorRegistry_lookup(address_t address, sensor_type_t sensor, sensor_parameter_type_t paramType);
+
+//! Returns the key of a handle, false if the handle is not assigned
+bool sensorRegistry_getKey(sensor_handle_t handle, address_t *address, sensor_type_t *sensor, sensor_parameter_type_t *paramType);
+
+//! Returns the number of registered sensor values
+uint8_t sensorRegistry_getCount(void);
+
+#endif /* SENSOR_REGISTRY_H_ */
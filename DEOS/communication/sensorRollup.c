@@ -0,0 +1,229 @@
+/*!
+ *  \brief Minute and hour rollups (min, max, mean, count) of a sensor series.
+ *
+ *  \author   Fachbereich 5 - FH Aachen
+ *  \date     2024
+ *  \version  1.0
+ */
+
+#include "sensorRollup.h"
+
+#include <string.h>
+
+//----------------------------------------------------------------------------
+// Defines
+//----------------------------------------------------------------------------
+
+//! Length of a minute in ms
+#define ROLLUP_MINUTE_MS 60000UL
+
+//! Length of an hour in ms
+#define ROLLUP_HOUR_MS 3600000UL
+
+//----------------------------------------------------------------------------
+// Private functions
+//----------------------------------------------------------------------------
+
+/*!
+ *  Starts an entry for every minute or hour that passed since the newest
+ *  one, at most one full ring of them
+ *
+ *  \param ring State of the ring
+ *  \param size Number of entries of the ring
+ *  \param passed Number of minutes or hours since the newest entry
+ *  \return Number of entries started, the caller marks them as empty
+ */
+static uint8_t sensorRollup_advance(sensor_rollup_ring_t* ring, uint8_t size, uint32_t passed)
+{
+    if (passed > size)
+    {
+        passed = size;
+    }
+
+    for (uint8_t i = 0; i < passed; i++)
+    {
+        ring->newest = (ring->newest + 1) % size;
+        if (ring->used < size)
+        {
+            ring->used++;
+        }
+    }
+    if (passed > 0)
+    {
+        ring->sum = 0;
+    }
+    return passed;
+}
+
+/*!
+ *  Adds a sample to the newest entry of a ring
+ *
+ *  \param ring State of the ring
+ *  \param count Number of samples of the newest entry, including this one
+ *  \param value Sample relative to the reference value
+ *  \return The mean of the newest entry
+ */
+static int16_t sensorRollup_addToRing(sensor_rollup_ring_t* ring, uint16_t count, int16_t value)
+{
+    if (count == 1 || value < ring->min)
+    {
+        ring->min = value;
+    }
+    if (count == 1 || value > ring->max)
+    {
+        ring->max = value;
+    }
+    ring->sum += value;
+
+    return ring->sum / (int32_t)count;
+}
+
+/*!
+ *  Returns the distance between two values as it is stored in an entry
+ *
+ *  \param from The smaller value
+ *  \param to The bigger value
+ *  \return The distance, clamped to UINT8_MAX
+ */
+static uint8_t sensorRollup_distance(int16_t from, int16_t to)
+{
+    int32_t distance = (int32_t)to - from;
+    return distance > UINT8_MAX ? UINT8_MAX : distance;
+}
+
+//----------------------------------------------------------------------------
+// Public functions
+//----------------------------------------------------------------------------
+
+/*!
+ *  Clears the rollups of a series
+ *
+ *  \param rollups The rollups
+ *  \param reference Value the entries are stored relative to, usually the first sample
+ */
+void sensorRollup_init(sensor_rollups_t* rollups, int32_t reference)
+{
+    memset(rollups, 0, sizeof(sensor_rollups_t));
+    rollups->reference = reference;
+}
+
+/*!
+ *  Adds a sample to the newest minute and hour entry. Takes O(1), apart
+ *  from starting empty entries for minutes or hours without samples.
+ *  Samples older than the newest minute or hour are ignored by its ring.
+ *
+ *  \param rollups The rollups of the series
+ *  \param time Time of the sample in ms
+ *  \param value Fixed point value of the sample
+ */
+void sensorRollup_add(sensor_rollups_t* rollups, time_t time, int32_t value)
+{
+    int32_t offset = value - rollups->reference;
+    int16_t clamped = offset > INT16_MAX ? INT16_MAX : offset < INT16_MIN ? INT16_MIN : (int16_t)offset;
+    uint32_t minute = time / ROLLUP_MINUTE_MS;
+    uint32_t minutesPassed = 1;
+    uint32_t hoursPassed = 1;
+
+    if (rollups->minuteRing.used > 0)
+    {
+        if (minute / 60 < rollups->minute / 60)
+        {
+            return;
+        }
+        hoursPassed = minute / 60 - rollups->minute / 60;
+        minutesPassed = minute < rollups->minute ? 0 : minute - rollups->minute;
+    }
+
+    uint8_t started = sensorRollup_advance(&rollups->hourRing, SENSOR_ROLLUP_HOUR_COUNT, hoursPassed);
+    while (started-- > 0)
+    {
+        rollups->hours[(rollups->hourRing.newest + SENSOR_ROLLUP_HOUR_COUNT - started) % SENSOR_ROLLUP_HOUR_COUNT].count = 0;
+    }
+    sensor_rollup_hour_t* hour = &rollups->hours[rollups->hourRing.newest];
+    if (hour->count < UINT16_MAX)
+    {
+        hour->count++;
+        hour->mean = sensorRollup_addToRing(&rollups->hourRing, hour->count, clamped);
+        hour->below = sensorRollup_distance(rollups->hourRing.min, hour->mean);
+        hour->above = sensorRollup_distance(hour->mean, rollups->hourRing.max);
+    }
+
+    if (minute < rollups->minute)
+    {
+        return;
+    }
+
+    started = sensorRollup_advance(&rollups->minuteRing, SENSOR_ROLLUP_MINUTE_COUNT, minutesPassed);
+    while (started-- > 0)
+    {
+        rollups->minutes[(rollups->minuteRing.newest + SENSOR_ROLLUP_MINUTE_COUNT - started) % SENSOR_ROLLUP_MINUTE_COUNT].count = 0;
+    }
+    sensor_rollup_minute_t* entry = &rollups->minutes[rollups->minuteRing.newest];
+    if (entry->count < UINT8_MAX)
+    {
+        entry->count++;
+        entry->mean = sensorRollup_addToRing(&rollups->minuteRing, entry->count, clamped);
+        entry->below = sensorRollup_distance(rollups->minuteRing.min, entry->mean);
+        entry->above = sensorRollup_distance(entry->mean, rollups->minuteRing.max);
+    }
+    rollups->minute = minute;
+}
+
+/*!
+ *  Returns the number of entries of a granularity
+ *
+ *  \param rollups The rollups of the series
+ *  \param granularity Minutes or hours
+ *  \return Number of entries, including those without samples
+ */
+uint8_t sensorRollup_getCount(sensor_rollups_t const* rollups, sensor_rollup_granularity_t granularity)
+{
+    return granularity == SENSOR_ROLLUP_MINUTE ? rollups->minuteRing.used : rollups->hourRing.used;
+}
+
+/*!
+ *  Returns an entry of a granularity
+ *
+ *  \param rollups The rollups of the series
+ *  \param granularity Minutes or hours
+ *  \param age 0 for the newest entry, 1 for the one before and so on
+ *  \param entry Receives the entry, its values are relative to the reference value
+ *  \param start Receives the start of the entry's minute or hour in ms
+ *  \return False if there is no entry of that age
+ */
+bool sensorRollup_get(sensor_rollups_t const* rollups, sensor_rollup_granularity_t granularity, uint8_t age, sensor_rollup_entry_t* entry, time_t* start)
+{
+    bool minutes = granularity == SENSOR_ROLLUP_MINUTE;
+    sensor_rollup_ring_t const* ring = minutes ? &rollups->minuteRing : &rollups->hourRing;
+    uint8_t size = minutes ? SENSOR_ROLLUP_MINUTE_COUNT : SENSOR_ROLLUP_HOUR_COUNT;
+    uint8_t below;
+    uint8_t above;
+
+    if (age >= ring->used)
+    {
+        return false;
+    }
+
+    uint8_t index = (ring->newest + size - age) % size;
+    if (minutes)
+    {
+        sensor_rollup_minute_t const* minute = &rollups->minutes[index];
+        entry->mean = minute->mean;
+        entry->count = minute->count;
+        below = minute->below;
+        above = minute->above;
+        *start = (rollups->minute - age) * ROLLUP_MINUTE_MS;
+    }
+    else
+    {
+        sensor_rollup_hour_t const* hour = &rollups->hours[index];
+        entry->mean = hour->mean;
+        entry->count = hour->count;
+        below = hour->below;
+        above = hour->above;
+        *start = (rollups->minute / 60 - age) * ROLLUP_HOUR_MS;
+    }
+    entry->min = entry->mean - below;
+    entry->max = entry->mean + above;
+    return true;
+}
@@ -0,0 +1,100 @@
+/*!
+ *  \brief Minute and hour rollups (min, max, mean, count) of a sensor series.
+ *
+ *  The rollups of a series are kept in two ring buffers of fixed size, one
+ *  entry per minute or hour. Every sample updates the newest entry of both
+ *  rings in O(1), a new entry is started when a sample falls into the next
+ *  minute or hour. Minutes or hours without samples are kept as entries
+ *  with count 0, so the entries of a ring are consecutive.
+ *  Values are stored as 16 bit offsets to a reference value of the series,
+ *  offsets outside of that range are clamped. To keep a day of rollups for
+ *  every series, an entry only stores its mean; minimum and maximum are kept
+ *  as distances of up to 255 steps below and above it, larger distances are
+ *  clamped. Minutes count up to 255 samples, further ones are ignored.
+ *
+ *  \author   Fachbereich 5 - FH Aachen
+ *  \date     2024
+ *  \version  1.0
+ */
+
+#ifndef SENSOR_ROLLUP_H_
+#define SENSOR_ROLLUP_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+//! Number of minutes a series keeps rollups for
+#define SENSOR_ROLLUP_MINUTE_COUNT 10
+
+//! Number of hours a series keeps rollups for
+#define SENSOR_ROLLUP_HOUR_COUNT 24
+
+//! Granularity of rollups
+typedef enum SensorRollupGranularity
+{
+    SENSOR_ROLLUP_MINUTE = 0,
+    SENSOR_ROLLUP_HOUR = 1
+} sensor_rollup_granularity_t;
+
+//! Rollup of the samples of one minute or hour, relative to the reference value
+typedef struct SensorRollupEntry
+{
+    int16_t min;
+    int16_t max;
+    int16_t mean;
+    uint16_t count; //!< 0 if there was no sample
+} sensor_rollup_entry_t;
+
+//! Stored rollup of a minute
+typedef struct SensorRollupMinute
+{
+    int16_t mean;
+    uint8_t below; //!< Distance of the minimum to the mean
+    uint8_t above; //!< Distance of the maximum to the mean
+    uint8_t count; //!< 0 if there was no sample
+} sensor_rollup_minute_t;
+
+//! Stored rollup of an hour
+typedef struct SensorRollupHour
+{
+    int16_t mean;
+    uint8_t below; //!< Distance of the minimum to the mean
+    uint8_t above; //!< Distance of the maximum to the mean
+    uint16_t count; //!< 0 if there was no sample
+} sensor_rollup_hour_t;
+
+//! State of a ring of rollups
+typedef struct SensorRollupRing
+{
+    int32_t sum;    //!< Sum of the samples of the newest entry
+    int16_t min;    //!< Minimum of the newest entry
+    int16_t max;    //!< Maximum of the newest entry
+    uint8_t newest; //!< Index of the newest entry
+    uint8_t used;   //!< Number of valid entries
+} sensor_rollup_ring_t;
+
+//! Rollups of a series
+typedef struct SensorRollups
+{
+    int32_t reference; //!< Value the entries are relative to
+    uint32_t minute;   //!< Number of the newest minute since the system start, the newest hour is minute / 60
+    sensor_rollup_ring_t minuteRing;
+    sensor_rollup_ring_t hourRing;
+    sensor_rollup_minute_t minutes[SENSOR_ROLLUP_MINUTE_COUNT];
+    sensor_rollup_hour_t hours[SENSOR_ROLLUP_HOUR_COUNT];
+} sensor_rollups_t;
+
+//! Clears the rollups, values are stored relative to the reference
+void sensorRollup_init(sensor_rollups_t *rollups, int32_t reference);
+
+//! Adds a sample, time in ms
+void sensorRollup_add(sensor_rollups_t *rollups, time_t time, int32_t value);
+
+//! Returns the number of entries of a granularity
+uint8_t sensorRollup_getCount(sensor_rollups_t const *rollups, sensor_rollup_granularity_t granularity);
+
+//! Returns an entry of a granularity (age 0 is the newest one) and its start in ms, false if there is none
+bool sensorRollup_get(sensor_rollups_t const *rollups, sensor_rollup_granularity_t granularity, uint8_t age, sensor_rollup_entry_t *entry, time_t *start);
+
+#endif /* SENSOR_ROLLUP_H_ */
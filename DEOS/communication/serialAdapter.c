@@ -9,8 +9,11 @@
 #include "serialAdapter.h"
 #include "../lib/lcd.h"
 #include "../lib/util.h"
+#include "../lib/terminal.h"
 #include "../os_core.h"
+#include "../os_mempool.h"
 #include "../os_scheduler.h"
+#include "meshAdapter.h"
 #include "rfAdapter.h"
 #include "xbee.h"
 
@@ -27,6 +30,9 @@
 //! Timeout for receiving frames
 #define SERIAL_ADAPTER_READ_TIMEOUT_MS ((time_t)500)
 
+//! Uncomment to dump every sent frame to the terminal (slows down sending considerably)
+// #define SERIAL_ADAPTER_PRINT_FRAMES
+
 //----------------------------------------------------------------------------
 // Forward declarations
 //----------------------------------------------------------------------------
@@ -37,6 +43,12 @@ void serialAdapter_calculateChecksum(checksum_t* checksum, void* data, uint8_t l
 //! Calculates a checksum of the frame
 void serialAdapter_calculateFrameChecksum(checksum_t* checksum, frame_t* frame);
 
+//! Reads the rest of a frame after its start flag into the given buffer
+bool serialAdapter_readFrame(frame_t* frame);
+
+//! Reads bytes into buffer and adds them to the checksum of the frame
+bool serialAdapter_readChecked(frame_t* frame, void* buffer, uint8_t length, checksum_t* checksum, crc16_t* crc);
+
 //! Returns true if timestamp + timeoutMs is a timestamp in the past
 bool serialAdapter_hasTimeout(time_t timestamp, time_t timeoutMs);
 
@@ -56,6 +68,30 @@ bool serialAdapter_hasTimeout(time_t timestamp, time_t timeoutMs)
     return (getSystemTime_ms() - timestamp >= timeoutMs);
 }
 
+/*!
+ *  Returns the length of the footer of the given frame, which depends on
+ *  the start flag of the frame.
+ *
+ *  \param frame Frame with valid start flag
+ *  \return Length of the footer in bytes
+ */
+uint8_t serialAdapter_getFooterLength(frame_t const* frame)
+{
+    return frame->header.startFlag == serialAdapter_startFlag ? COMM_FOOTER_LENGTH : COMM_FOOTER_LENGTH_CRC;
+}
+
+/*!
+ *  Checks whether the frame is a mesh frame, which carries link fields
+ *  between header and inner frame
+ *
+ *  \param frame Frame with valid start flag
+ *  \return True for frames announced by serialAdapter_startFlagMesh
+ */
+static bool serialAdapter_isMeshFrame(frame_t const* frame)
+{
+    return frame->header.startFlag == serialAdapter_startFlagMesh;
+}
+
 /*!
  *  Blocks process until at least one byte is available to be read
  */
@@ -80,35 +116,133 @@ void serialAdapter_init(void)
 }
 
 /*!
- *  Sends a frame with given innerFrame
+ *  Allocates a frame buffer from the frame pool and prepares its header, so
+ *  the payload can be written in place (see FRAME_PAYLOAD). The buffer has to
+ *  be passed to serialAdapter_sendFrame or serialAdapter_freeFrame.
+ *  While the mesh is enabled, a mesh frame is prepared.
  *
  *  \param destAddr where to send the frame to
- *  \param length how many bytes the innerFrame has
- *  \param innerFrame buffer as payload of the frame
+ *  \param command the command of the inner frame
+ *  \return The frame buffer or NULL if all frame buffers are in use
  */
-void serialAdapter_writeFrame(address_t destAddr, inner_frame_length_t length, inner_frame_t* innerFrame)
+frame_t* serialAdapter_allocFrame(address_t destAddr, command_t command)
+{
+    frame_t* frame = os_memPoolAlloc(sizeof(frame_t));
+    if (frame == NULL)
+    {
+        WARN("No free frame buffer");
+        return NULL;
+    }
+
+    if (meshAdapter_enabled)
+    {
+        frame->header.startFlag = serialAdapter_startFlagMesh;
+    }
+    else
+    {
+        frame->header.startFlag = serialAdapter_sendCrc ? serialAdapter_startFlagCrc : serialAdapter_startFlag;
+    }
+    frame->header.srcAddr = serialAdapter_address;
+    frame->header.destAddr = destAddr;
+    frame->header.length = sizeof(command_t);
+    frame->innerFrame.command = command;
+    frame->mesh.hops = 0;
+
+    return frame;
+}
+
+/*!
+ *  Releases a frame buffer without sending it
+ *
+ *  \param frame buffer returned by serialAdapter_allocFrame
+ */
+void serialAdapter_freeFrame(frame_t* frame)
+{
+    os_memPoolFree(frame);
+}
+
+/*!
+ *  Sends a frame that was built in place. Header and inner frame are adjacent
+ *  in the buffer, so they are handed to the XBee in one go. The mesh fields
+ *  of mesh frames are sent in between. The buffer stays valid and can be
+ *  sent again.
+ *
+ *  \param frame buffer returned by serialAdapter_allocFrame
+ *  \param length how many bytes the innerFrame has (command and payload)
+ */
+void serialAdapter_transmitFrame(frame_t* frame, inner_frame_length_t length)
 {
-    // Prepare frame
-    frame_t newFrame;
+    bool mesh = serialAdapter_isMeshFrame(frame);
 
-    newFrame.header.destAddr = destAddr;
-    newFrame.header.length = length;
-    newFrame.header.srcAddr = serialAdapter_address;
-    newFrame.header.startFlag = serialAdapter_startFlag;
+    frame->header.length = length;
 
+    // Forwarded frames keep sequence number and sender
+    if (mesh && frame->mesh.hops == 0)
+    {
+        meshAdapter_prepareFrame(frame);
+    }
 
-    newFrame.footer.checksum = INITIAL_CHECKSUM_VALUE;
+    if (serialAdapter_getFooterLength(frame) == COMM_FOOTER_LENGTH_CRC)
+    {
+        crc16_t crc = crc16_calculate(CRC16_INITIAL_VALUE, &frame->header, sizeof(frame_header_t));
+        if (mesh)
+        {
+            crc = crc16_calculate(crc, &frame->mesh, sizeof(frame_mesh_t));
+        }
+        frame->footer.crc = crc16_calculate(crc, &frame->innerFrame, length);
+    }
+    else
+    {
+        frame->footer.checksum = INITIAL_CHECKSUM_VALUE;
+        serialAdapter_calculateFrameChecksum(&frame->footer.checksum, frame);
+    }
 
-    newFrame.innerFrame = *innerFrame;
+#ifdef SERIAL_ADAPTER_PRINT_FRAMES
+    printFrame(frame, "serialAdapter_transmitFrame");
+#endif
 
-    serialAdapter_calculateFrameChecksum(&newFrame.footer.checksum, &newFrame);
+    if (mesh)
+    {
+        xbee_writeData(&frame->header, sizeof(frame_header_t));
+        xbee_writeData(&frame->mesh, sizeof(frame_mesh_t));
+        xbee_writeData(&frame->innerFrame, length);
+    }
+    else
+    {
+        xbee_writeData(frame, sizeof(frame_header_t) + length);
+    }
+    xbee_writeData(&frame->footer, serialAdapter_getFooterLength(frame));
+}
 
-    printFrame(&newFrame, "serialAdapter_writeFrame");
+/*!
+ *  Sends a frame that was built in place and releases its buffer.
+ *
+ *  \param frame buffer returned by serialAdapter_allocFrame
+ *  \param length how many bytes the innerFrame has (command and payload)
+ */
+void serialAdapter_sendFrame(frame_t* frame, inner_frame_length_t length)
+{
+    serialAdapter_transmitFrame(frame, length);
+    serialAdapter_freeFrame(frame);
+}
 
+/*!
+ *  Sends a frame with given innerFrame
+ *
+ *  \param destAddr where to send the frame to
+ *  \param length how many bytes the innerFrame has
+ *  \param innerFrame buffer as payload of the frame
+ */
+void serialAdapter_writeFrame(address_t destAddr, inner_frame_length_t length, inner_frame_t* innerFrame)
+{
+    frame_t* frame = serialAdapter_allocFrame(destAddr, innerFrame->command);
+    if (frame == NULL)
+    {
+        return;
+    }
 
-    xbee_writeData(&newFrame.header, sizeof(newFrame.header));
-    xbee_writeData(&newFrame.innerFrame, length);
-    xbee_writeData(&newFrame.footer, sizeof(newFrame.footer));
+    memcpy(&frame->innerFrame, innerFrame, length);
+    serialAdapter_sendFrame(frame, length);
 }
 
 /*!
@@ -134,113 +268,174 @@ bool serialAdapter_waitForData(uint16_t byteCount, time_t frameTimestamp)
 }
 
 /*!
- *  Reads incoming data and processes it. Needs to be called periodically.
- *  Don't read from UART in any other process while this is running.
+ *  Reads bytes into a buffer and adds them to the checksum matching the
+ *  format of the frame, so no second pass over the frame is needed.
+ *
+ *  \param frame Frame that is received (its start flag selects the checksum)
+ *  \param buffer Where the bytes are stored
+ *  \param length Number of bytes to read
+ *  \param checksum XOR checksum that is updated
+ *  \param crc CRC-16 that is updated
+ *  \return True on success
  */
-void serialAdapter_worker()
+bool serialAdapter_readChecked(frame_t* frame, void* buffer, uint8_t length, checksum_t* checksum, crc16_t* crc)
 {
-    if (!serialAdapter_waitForData(sizeof(start_flag_t), getSystemTime_ms()))
-    {
-        return;
-    }
-
-    // Parse header one by one, abort if first byte is not part of the start flag
-    uint8_t flag_buffer[sizeof(start_flag_t)];
-
-    if (xbee_readBuffer(&flag_buffer[0], 1) != XBEE_SUCCESS)
+    if (xbee_readBuffer(buffer, length) != XBEE_SUCCESS)
     {
-        return;
+        return false;
     }
 
-    if (flag_buffer[0] != (serialAdapter_startFlag & 0xFF))
+    if (serialAdapter_getFooterLength(frame) == COMM_FOOTER_LENGTH_CRC)
     {
-        printf_P(PSTR("Data is not StartFlag 1.\n"));
-        return;
-
+        *crc = crc16_calculate(*crc, buffer, length);
     }
-    if (xbee_readBuffer(&flag_buffer[1], 1) != XBEE_SUCCESS)
+    else
     {
-        return;
+        serialAdapter_calculateChecksum(checksum, buffer, length);
     }
+    return true;
+}
 
+/*!
+ *  Reads the rest of a frame after its start flag directly into the given
+ *  frame buffer and verifies it. The start flag of the frame has to be set
+ *  already, it determines whether an XOR checksum or a CRC-16 is expected
+ *  and whether mesh fields follow the header.
+ *  The checksum is updated chunk by chunk while the frame is read.
+ *
+ *  \param frame buffer the frame is read into
+ *  \return True if a complete, valid frame for this node was read (mesh frames: for this node as next hop)
+ */
+bool serialAdapter_readFrame(frame_t* frame)
+{
+    checksum_t frame_checksum = INITIAL_CHECKSUM_VALUE;
+    crc16_t frame_crc = CRC16_INITIAL_VALUE;
+    uint8_t footerLength = serialAdapter_getFooterLength(frame);
+    bool mesh = serialAdapter_isMeshFrame(frame);
+    uint8_t meshLength = mesh ? sizeof(frame_mesh_t) : 0;
 
-    if (flag_buffer[1] != ((serialAdapter_startFlag >> 8) & 0xFF)) {
-        printf_P(PSTR("Data is not StartFlag 2.\n"));
-        return;
-    }
+    serialAdapter_calculateChecksum(&frame_checksum, &frame->header.startFlag, sizeof(start_flag_t));
+    frame_crc = crc16_calculate(frame_crc, &frame->header.startFlag, sizeof(start_flag_t));
 
     // Wait for arrival of complete header
-
     if (!serialAdapter_waitForData(sizeof(frame_header_t) - (sizeof(start_flag_t)), getSystemTime_ms()))
     {
-        return;
+        return false;
     }
 
+    // srcAddr, destAddr and length follow the start flag without gap
+    if (!serialAdapter_readChecked(frame, &frame->header.srcAddr, sizeof(frame_header_t) - sizeof(start_flag_t), &frame_checksum, &frame_crc))
+    {
+        return false;
+    }
 
-    frame_t received_frame;
+    if (frame->header.length > COMM_MAX_INNER_FRAME_LENGTH)
+        return false;
 
-    received_frame.header.startFlag = serialAdapter_startFlag;
+    // Wait for mesh fields, complete inner frame and footer
+    if (!serialAdapter_waitForData(meshLength + frame->header.length + footerLength, getSystemTime_ms()))
+    {
+        return false;
+    }
 
-    int err;
-    err = xbee_readBuffer((uint8_t*)&received_frame.header.srcAddr, sizeof(received_frame.header.srcAddr));
-    if (err != XBEE_SUCCESS)
+    // Read mesh fields
+    if (mesh && !serialAdapter_readChecked(frame, &frame->mesh, meshLength, &frame_checksum, &frame_crc))
     {
-        return;
+        return false;
     }
 
-    err = xbee_readBuffer((uint8_t*)&received_frame.header.destAddr, sizeof(received_frame.header.destAddr));
-    if (err != XBEE_SUCCESS)
+    // Read inner frame
+    if (!serialAdapter_readChecked(frame, &frame->innerFrame, frame->header.length, &frame_checksum, &frame_crc))
     {
-        return;
+        return false;
     }
 
-    err = xbee_readBuffer((uint8_t*)&received_frame.header.length, sizeof(received_frame.header.length));
-    if (err != XBEE_SUCCESS)
+    // Read footer
+    if (xbee_readBuffer((uint8_t*)&frame->footer, footerLength) != XBEE_SUCCESS)
     {
-        return;
+        return false;
     }
 
+    // Verify checksum
+    if (footerLength == COMM_FOOTER_LENGTH_CRC ? frame_crc != frame->footer.crc : frame_checksum != frame->footer.checksum)
+        return false;
 
-    if (received_frame.header.length > COMM_MAX_INNER_FRAME_LENGTH)
-        return;
+    // Check if we are addressed by this frame, mesh frames are addressed to the next hop
+    address_t destAddr = mesh ? frame->mesh.nextHop : frame->header.destAddr;
+    return destAddr == ADDRESS_BROADCAST || destAddr == serialAdapter_address;
+}
+
+/*!
+ *  Reads incoming data and processes it. Needs to be called periodically.
+ *  Don't read from UART in any other process while this is running.
+ *  Frames are received into a frame buffer and passed on by reference.
+ *  Frames with XOR checksum, with CRC-16 and mesh frames are accepted, they
+ *  are told apart by their start flag. Mesh frames are passed to the
+ *  meshAdapter, which forwards them and decides whether they are processed.
+ */
+void serialAdapter_worker()
+{
+    meshAdapter_worker();
 
-    // Wait for complete inner frame and footer
-    if (!serialAdapter_waitForData(received_frame.header.length + sizeof(frame_footer_t), getSystemTime_ms()))
+    if (!serialAdapter_waitForData(sizeof(start_flag_t), getSystemTime_ms()))
     {
         return;
     }
 
-    // Read inner frame
-    err = xbee_readBuffer((uint8_t*)&received_frame.innerFrame, received_frame.header.length);
-    if (err != XBEE_SUCCESS)
+    // Parse header one by one, abort if first byte is not part of a start flag
+    uint8_t flag_buffer[sizeof(start_flag_t)];
+
+    if (xbee_readBuffer(&flag_buffer[0], 1) != XBEE_SUCCESS)
     {
         return;
     }
 
-    // Read footer
-    err = xbee_readBuffer((uint8_t*)&received_frame.footer, sizeof(frame_footer_t));
-    if (err != XBEE_SUCCESS)
+    start_flag_t startFlag;
+    if (flag_buffer[0] == (serialAdapter_startFlag & 0xFF))
     {
-        return;
+        startFlag = serialAdapter_startFlag;
     }
+    else if (flag_buffer[0] == (serialAdapter_startFlagCrc & 0xFF))
+    {
+        startFlag = serialAdapter_startFlagCrc;
+    }
+    else if (flag_buffer[0] == (serialAdapter_startFlagMesh & 0xFF))
+    {
+        startFlag = serialAdapter_startFlagMesh;
+    }
+    else
+    {
+        printf_P(PSTR("Data is not StartFlag 1.\n"));
+        return;
 
-
-    // Read checksum
-    checksum_t frame_checksum = INITIAL_CHECKSUM_VALUE;
-    serialAdapter_calculateFrameChecksum(&frame_checksum, &received_frame);
-
+    }
+    if (xbee_readBuffer(&flag_buffer[1], 1) != XBEE_SUCCESS)
+    {
+        return;
+    }
 
 
-    // Verify checksum
-    if (frame_checksum != received_frame.footer.checksum)
+    if (flag_buffer[1] != ((startFlag >> 8) & 0xFF)) {
+        printf_P(PSTR("Data is not StartFlag 2.\n"));
         return;
+    }
 
-    // Check if we are addressed by this frame
-    if (received_frame.header.destAddr != ADDRESS_BROADCAST && received_frame.header.destAddr != serialAdapter_address)
+    frame_t* received_frame = os_memPoolAlloc(sizeof(frame_t));
+    if (received_frame == NULL)
+    {
+        WARN("No free frame buffer, dropping frame");
         return;
+    }
+
+    received_frame->header.startFlag = startFlag;
 
     // Forward to next layer
-    serialAdapter_processFrame(&received_frame);
+    if (serialAdapter_readFrame(received_frame) && (!serialAdapter_isMeshFrame(received_frame) || meshAdapter_receiveFrame(received_frame)))
+    {
+        serialAdapter_processFrame(received_frame);
+    }
+
+    os_memPoolFree(received_frame);
 }
 
 /*!
@@ -306,8 +501,8 @@ void printFrame(frame_t* frame, char* func_name)
     // Print footer and close
     printf_P(
         PSTR("\nFrame Footer:\n"
-            "  └─ Checksum:             0x%02X\n"
+            "  └─ Checksum:             0x%04X\n"
             "================================================\n\n"),
-        frame->footer.checksum);
+        serialAdapter_getFooterLength(frame) == COMM_FOOTER_LENGTH_CRC ? frame->footer.crc : frame->footer.checksum);
 }
 
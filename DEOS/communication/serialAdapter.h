@@ -9,6 +9,7 @@
 #ifndef SERIAL_ADAPTER_H_
 #define SERIAL_ADAPTER_H_
 
+#include "../lib/crc16.h"
 #include "../lib/util.h"
 
 #include <stdbool.h>
@@ -25,6 +26,7 @@ typedef uint8_t checksum_t;
 #define COMM_START_FLAG_LENGTH sizeof(start_flag_t)
 #define COMM_HEADER_LENGTH (COMM_START_FLAG_LENGTH + sizeof(address_t) * 2 + sizeof(inner_frame_length_t))
 #define COMM_FOOTER_LENGTH sizeof(checksum_t)
+#define COMM_FOOTER_LENGTH_CRC sizeof(crc16_t)
 #define COMM_MAX_PAYLOAD_LENGTH 48
 #define COMM_MAX_INNER_FRAME_LENGTH (sizeof(checksum_t) + COMM_MAX_PAYLOAD_LENGTH)
 #define ADDRESS_BROADCAST ((address_t)255)
@@ -47,22 +49,51 @@ typedef struct InnerFrame
 } inner_frame_t;
 
 //! Specification of the footer of the outer communication frame
+//! Frames announced by serialAdapter_startFlagCrc carry a CRC-16 instead of the XOR checksum
 typedef struct FrameFooter
 {
-	checksum_t checksum;
+	union
+	{
+		checksum_t checksum;
+		crc16_t crc;
+	};
 } frame_footer_t;
 
+//! Link fields of frames announced by serialAdapter_startFlagMesh, sent between header and inner frame.
+//! The header of such frames holds the original sender and the final receiver.
+typedef struct FrameMesh
+{
+	address_t prevHop;  //!< Neighbour that sent the frame
+	address_t nextHop;  //!< Neighbour that has to handle the frame or ADDRESS_BROADCAST
+	uint8_t hops;       //!< Hops the frame travelled before it was sent by prevHop
+	uint8_t sequence;   //!< Numbers the frames of the original sender to drop duplicates
+} frame_mesh_t;
+
 //! Specification of a communication frame, that is the outer box for every command
+//! The mesh fields are stored behind the footer, so header and inner frame stay adjacent
 typedef struct Frame
 {
 	frame_header_t header;
 	inner_frame_t innerFrame;
 	frame_footer_t footer;
+	frame_mesh_t mesh;
 } frame_t;
 
+//! Accesses the payload of a frame (buffer) as command struct of the given type
+#define FRAME_PAYLOAD(frame, type) ((type *)(frame)->innerFrame.payload)
+
 //! Start-Flag that announces a new frame
 extern start_flag_t serialAdapter_startFlag;
 
+//! Start-Flag that announces a new frame protected by a CRC-16
+extern start_flag_t serialAdapter_startFlagCrc;
+
+//! Start-Flag that announces a new mesh frame protected by a CRC-16 (see meshAdapter.h)
+extern start_flag_t serialAdapter_startFlagMesh;
+
+//! Whether frames are sent with CRC-16 (both formats are always accepted)
+extern bool serialAdapter_sendCrc;
+
 //! Configuration what address this microcontroller has
 extern address_t serialAdapter_address;
 
@@ -75,9 +106,24 @@ void serialAdapter_init(void);
 //! Reads incoming data and processes it
 void serialAdapter_worker(void);
 
-//! Sends a frame with given innerFrame
+//! Allocates a frame buffer with prepared header, returns NULL if none is available
+frame_t *serialAdapter_allocFrame(address_t destAddr, command_t command);
+
+//! Releases a frame buffer without sending it
+void serialAdapter_freeFrame(frame_t *frame);
+
+//! Sends a frame that was built in place and releases its buffer
+void serialAdapter_sendFrame(frame_t *frame, inner_frame_length_t length);
+
+//! Sends a frame that was built in place and keeps its buffer (e.g. for retransmission)
+void serialAdapter_transmitFrame(frame_t *frame, inner_frame_length_t length);
+
+//! Sends a frame with given innerFrame (copies the innerFrame into a frame buffer)
 void serialAdapter_writeFrame(address_t destAddr, inner_frame_length_t length, inner_frame_t *innerFrame);
 
+//! Returns the length of the footer of the given frame
+uint8_t serialAdapter_getFooterLength(frame_t const *frame);
+
 //! Blocks process until byteCount bytes arrived
 bool serialAdapter_waitForData(uint16_t byteCount, time_t frameTimestamp);
 
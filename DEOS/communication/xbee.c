@@ -10,21 +10,40 @@
 #include "../lib/uart.h"
 #include "../os_scheduler.h"
 #include "rfAdapter.h"
+#include "../lib/terminal.h"
+#include "../lib/util.h"
 #include <string.h>
 
 
 #include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+
+//----------------------------------------------------------------------------
+// Globals
+//----------------------------------------------------------------------------
+
+//! Baudrate the XBee and UART1 currently use
+static xbee_baudrate_t xbee_currentBaudrate = XBEE_DEFAULT_BAUDRATE;
+
+static void xbee_initUart(xbee_baudrate_t baudrate);
 
 //----------------------------------------------------------------------------
 // Your Homework
 //----------------------------------------------------------------------------
 
 /*!
- *  Initializes the XBee
+ *  Initializes the XBee. If XBEE_BAUDRATE differs from the default baudrate,
+ *  the link is switched to it, which takes a few seconds of guard times.
  */
 void xbee_init()
 {
-	uart1_init(UART_BAUD_SELECT(38400, F_CPU));
+	xbee_currentBaudrate = XBEE_DEFAULT_BAUDRATE;
+	xbee_initUart(XBEE_DEFAULT_BAUDRATE);
+
+	if (XBEE_BAUDRATE != XBEE_DEFAULT_BAUDRATE)
+	{
+		xbee_setBaudrate(XBEE_BAUDRATE);
+	}
 }
 
 /*!
@@ -38,17 +57,30 @@ void xbee_write(uint8_t byte)
 }
 
 /*!
- *  Transmits the given data to the XBee
+ *  Transmits the given data to the XBee. While the UART buffer is full the
+ *  calling process is blocked, so other processes can run meanwhile.
  *
  *  \param data buffer with will be sent through UART
  *  \param length size of the buffer
  */
 void xbee_writeData(void *data, uint8_t length)
 {
-	for(int i = 0; i < length;i++)
-	{
-		xbee_write(*(((uint8_t*)data)+i));
-	}
+	uart1_write(data, length);
+}
+
+/*!
+ *  Maps the receive errors of the UART library to the error codes of the XBee layer
+ *
+ *  \param error high byte of uart1_getc or result of uart1_getRxError
+ *  \return XBEE_READ_ERROR on a framing error, XBEE_BUFFER_INCONSISTENCY if bytes were lost, XBEE_SUCCESS otherwise
+ */
+static uint8_t xbee_mapRxError(unsigned int error)
+{
+	if (error & UART_FRAME_ERROR)
+		return XBEE_READ_ERROR;
+	if (error & (UART_OVERRUN_ERROR | UART_BUFFER_OVERFLOW | UART_PARITY_ERROR))
+		return XBEE_BUFFER_INCONSISTENCY;
+	return XBEE_SUCCESS;
 }
 
 /*
@@ -61,45 +93,14 @@ uint8_t xbee_read(uint8_t *byte)
 {
 	//we are assuming that "int" from the uart library is implemented as uint16_t, kinda ugly ngl
 	uint16_t temp = (uint16_t)uart1_getc();
-	
-	switch((temp >> 8) & 0xFF)
-	{
-		case 0:
-		{
-			*byte = (uint8_t)temp;
-			return XBEE_SUCCESS;
-		}
-		break;
-		
-		case UART_OVERRUN_ERROR:
-		{
-			*byte = (uint8_t)temp;
-			return XBEE_BUFFER_INCONSISTENCY;
-		}
-		break;
-		
-		case UART_BUFFER_OVERFLOW:
-		{
-			*byte = (uint8_t)temp;
-			return XBEE_BUFFER_INCONSISTENCY;
-		}
-		break;
-		
-		case UART_FRAME_ERROR:
-		{
-			return XBEE_READ_ERROR;
-		}
-		break;
-		
-		case UART_NO_DATA:
-		{
-			return XBEE_DATA_MISSING;
-		}
-		break;
-		default:
-			break;
-	}
-	return 255;
+
+	if (temp & UART_NO_DATA)
+		return XBEE_DATA_MISSING;
+
+	uint8_t err = xbee_mapRxError(temp & 0xFF00);
+	if (err != XBEE_READ_ERROR)
+		*byte = (uint8_t)temp;
+	return err;
 }
 
 
@@ -116,6 +117,7 @@ uint16_t xbee_getNumberOfBytesReceived()
 
 /*!
  *  Receives `length` bytes and writes them to `buffer`. Make sure there are enough bytes to be read
+ *  The bytes are copied out of the UART buffer in one go.
  *
  *	\param message_buffer Buffer where to store received bytes
  *  \param buffer_size Amount of bytes that need to be received
@@ -125,14 +127,190 @@ uint8_t xbee_readBuffer(uint8_t *buffer, uint8_t length)
 {
 	if (xbee_getNumberOfBytesReceived() < length)
 		return XBEE_DATA_MISSING;
-	
-	for (uint8_t i = 0; i < length; i++)
+
+	uart1_read(buffer, length);
+
+	return xbee_mapRxError(uart1_getRxError());
+}
+
+//----------------------------------------------------------------------------
+// Link configuration
+//----------------------------------------------------------------------------
+
+/*!
+ *  Returns the baudrate in bps
+ *
+ *  \param baudrate ATBD parameter of the baudrate
+ *  \return Baudrate in bps
+ */
+static uint32_t xbee_toBps(xbee_baudrate_t baudrate)
+{
+	switch (baudrate)
 	{
-		// Copy received data into destination buffer
-		uint8_t err = xbee_read(&buffer[i]);
-		if (err != XBEE_SUCCESS)
-			return err; // Early return if an error occurs
+	case XBEE_BAUD_57600:
+		return 57600;
+	case XBEE_BAUD_115200:
+		return 115200;
+	case XBEE_BAUD_230400:
+		return 230400;
+	default:
+		return 38400;
 	}
+}
 
-	return XBEE_SUCCESS;
+/*!
+ *  Initializes UART1 with the UBRR setting that comes closest to the baudrate.
+ *  Bytes that are still in the receive buffer are dropped.
+ *
+ *  \param baudrate Baudrate the XBee runs at
+ */
+static void xbee_initUart(xbee_baudrate_t baudrate)
+{
+	int16_t error;
+	unsigned int setting = uart_selectBaudrate(xbee_toBps(baudrate), &error);
+
+	uart1_waitTxDrained();
+	uart1_init(setting);
+
+	// The datasheet recommends at most 2 %, the 2.1 % of 115200 baud at 16 MHz still work in practice
+	if (error > 25 || error < -25)
+	{
+		WARN("UART1 at %lu baud is off by %d per mille", (unsigned long)xbee_toBps(baudrate), error);
+	}
+}
+
+/*!
+ *  Waits for the "OK" the XBee answers in command mode
+ *
+ *  \param timeoutMs How long to wait for the answer
+ *  \return true if the XBee answered "OK", false on timeout or any other answer
+ */
+static bool xbee_awaitOk(uint16_t timeoutMs)
+{
+	char line[3];
+	uint8_t length = 0;
+	time_t start = getSystemTime_ms();
+
+	while (getSystemTime_ms() - start < timeoutMs)
+	{
+		unsigned int received = uart1_getc();
+		if (received & UART_NO_DATA)
+			continue;
+
+		char character = (char)received;
+		if (character == '\r')
+			return length == 2 && line[0] == 'O' && line[1] == 'K';
+		if (length < sizeof(line))
+			line[length++] = character;
+	}
+	return false;
+}
+
+/*!
+ *  Enters the command mode of the XBee. UART1 must not be used by anyone else meanwhile.
+ *
+ *  \return true if the XBee answered at the current baudrate of UART1
+ */
+static bool xbee_enterCommandMode()
+{
+	delayMs(XBEE_GUARD_TIME_MS);
+	while (!(uart1_getc() & UART_NO_DATA));
+
+	uart1_puts_P("+++");
+	return xbee_awaitOk(XBEE_GUARD_TIME_MS + XBEE_AT_TIMEOUT_MS);
+}
+
+/*!
+ *  Sends an AT command to the XBee in command mode
+ *
+ *  \param command Name of the command in program memory, e.g. PSTR("BD")
+ *  \param parameter Single character parameter or 0 if the command has none
+ *  \return true if the XBee accepted the command
+ */
+static bool xbee_sendAtCommand(const char *command, char parameter)
+{
+	uart1_puts_P("AT");
+	uart1_puts_p(command);
+	if (parameter)
+		uart1_putc(parameter);
+	uart1_putc('\r');
+	return xbee_awaitOk(XBEE_AT_TIMEOUT_MS);
+}
+
+/*!
+ *  Checks that the XBee answers at the current baudrate of UART1
+ *
+ *  \return true if the XBee answered
+ */
+static bool xbee_handshake()
+{
+	if (!xbee_enterCommandMode())
+		return false;
+	xbee_sendAtCommand(PSTR("CN"), 0);
+	return true;
+}
+
+/*!
+ *  Switches the XBee and UART1 to another baudrate. The XBee is configured via
+ *  AT commands, then both sides have to complete a handshake at the new
+ *  baudrate. If the XBee does not follow, UART1 falls back to the previous
+ *  baudrate. The setting is not written to the XBee (ATWR), so a power cycle
+ *  always brings it back to XBEE_DEFAULT_BAUDRATE.
+ *
+ *  Blocks for a few seconds of guard times, bytes received meanwhile are
+ *  dropped. Call it before the rfAdapter worker runs.
+ *
+ *  \param baudrate The new baudrate
+ *  \return XBEE_SUCCESS or XBEE_LINK_ERROR if the link still runs at (or could not be restored to) the previous baudrate
+ */
+uint8_t xbee_setBaudrate(xbee_baudrate_t baudrate)
+{
+	if (baudrate == xbee_currentBaudrate)
+		return XBEE_SUCCESS;
+
+	xbee_baudrate_t previous = xbee_currentBaudrate;
+
+	if (xbee_enterCommandMode())
+	{
+		bool accepted = xbee_sendAtCommand(PSTR("BD"), '0' + baudrate);
+
+		// The new baudrate takes effect when the command mode is left, the answer may already use it
+		xbee_sendAtCommand(PSTR("CN"), 0);
+
+		if (!accepted)
+		{
+			WARN("XBee does not support %lu baud", (unsigned long)xbee_toBps(baudrate));
+			return XBEE_LINK_ERROR;
+		}
+	}
+
+	// This also finds an XBee that still runs at the baudrate since before a reset of the microcontroller
+	xbee_initUart(baudrate);
+	if (xbee_handshake())
+	{
+		xbee_currentBaudrate = baudrate;
+		INFO("XBee link runs at %lu baud", (unsigned long)xbee_toBps(baudrate));
+		return XBEE_SUCCESS;
+	}
+
+	xbee_initUart(previous);
+	if (xbee_handshake())
+	{
+		WARN("XBee did not follow to %lu baud, staying at %lu baud", (unsigned long)xbee_toBps(baudrate), (unsigned long)xbee_toBps(previous));
+	}
+	else
+	{
+		WARN("XBee not reachable, power cycle it to restore %lu baud", (unsigned long)xbee_toBps(previous));
+	}
+	return XBEE_LINK_ERROR;
+}
+
+/*!
+ *  Returns the baudrate the link currently runs at
+ *
+ *  \return ATBD parameter of the baudrate
+ */
+xbee_baudrate_t xbee_getBaudrate()
+{
+	return xbee_currentBaudrate;
 }
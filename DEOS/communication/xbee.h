@@ -12,10 +12,40 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#include "../lib/uart_config.h"
+
 #define XBEE_SUCCESS 0
 #define XBEE_BUFFER_INCONSISTENCY (1 << 0)
 #define XBEE_READ_ERROR (1 << 1)
 #define XBEE_DATA_MISSING (1 << 2)
+#define XBEE_LINK_ERROR (1 << 3)
+
+//! Baudrates of the link to the XBee, the values are the parameters of the ATBD command
+typedef enum XbeeBaudrate
+{
+	XBEE_BAUD_38400 = 5,
+	XBEE_BAUD_57600 = 6,
+	XBEE_BAUD_115200 = 7,
+	XBEE_BAUD_230400 = 8
+} xbee_baudrate_t;
+
+//! Baudrate the XBee modules are configured with (ttConfigXbee), used after a reset
+#define XBEE_DEFAULT_BAUDRATE XBEE_BAUD_38400
+
+//! Baudrate xbee_init switches the link to, the gateway needs the higher throughput
+#ifndef XBEE_BAUDRATE
+#if UART_PROFILE == UART_PROFILE_GATEWAY
+#define XBEE_BAUDRATE XBEE_BAUD_115200
+#else
+#define XBEE_BAUDRATE XBEE_DEFAULT_BAUDRATE
+#endif
+#endif
+
+//! Silence the XBee needs before and after "+++" to enter the command mode (ATGT)
+#define XBEE_GUARD_TIME_MS 1000
+
+//! Time the XBee gets to answer an AT command
+#define XBEE_AT_TIMEOUT_MS 200
 
 //! Initializes the UART connection
 void xbee_init();
@@ -35,4 +65,10 @@ uint8_t xbee_readBuffer(uint8_t *buffer, uint8_t length);
 //! Returns current filling of the buffer in byte
 uint16_t xbee_getNumberOfBytesReceived();
 
+//! Switches the XBee and UART1 to another baudrate, falls back to the previous one if the XBee does not follow
+uint8_t xbee_setBaudrate(xbee_baudrate_t baudrate);
+
+//! Returns the baudrate the link currently runs at
+xbee_baudrate_t xbee_getBaudrate();
+
 #endif /* XBEE_H_ */
\ No newline at end of file
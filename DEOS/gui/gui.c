@@ -9,15 +9,20 @@
 #include <stddef.h>
 #include <stdbool.h>
 
+#include "../tlcd/tlcd_button.h"
 #include "../tlcd/tlcd_core.h"
+#include "../tlcd/tlcd_event_parser.h"
+#include "../tlcd/tlcd_font.h"
 #include "../tlcd/tlcd_graphic.h"
 #include "../os_scheduler.h"
+#include "../os_mempool.h"
 #include "stdlib.h"
 #include "time.h"
 #include "string.h"
 #include "../lib/terminal.h"
+#include "../communication/sensorRegistry.h"
+#include "../lib/fixed_point.h"
 
-#define GUI_ELEMENT_CONTAINER_SIZE 6 // Amount of GUI Elements allowed
 
 #define SENSOR_DATA_UPDATE_TIMEOUT_MS 8000
 
@@ -63,34 +68,94 @@
 #define GRID_CELL_CONTENT_END_Y (uint16_t)(GRID_CELL_END_Y - GRID_CELL_INNER_VER_PADDING)
 
 
+#define GUI_FONT TLCD_FONT_7X12 // Font of all texts, selected in init_gui(), tlcd_font.h measures texts with it
+_Static_assert(TLCD_FONT_IS_FIXED_WIDTH(GUI_FONT), "Texts are centered with tlcd_measureString(), which is exact for fixed-width fonts only");
+#define GUI_TEXT_SIZE_MAX 2 // Biggest text size a value is drawn with, smaller ones are used if the value does not fit
+
 #define TEXT_HEIGHT 20
 #define TEXT_START_X_OFFSET 3
 #define TEXT_START_Y_OFFSET 
 
+#define GRID_CELL_BAND_WIDTH 4 // Number of rectangles forming the colored band around the value
+#define GRID_CELL_TEXT_START_X (uint16_t)(GRID_CELL_START_X + 2 + GRID_CELL_BAND_WIDTH + 1) // Start X of the area inside the band
+#define GRID_CELL_TEXT_END_X (uint16_t)(GRID_CELL_END_X - 2 - GRID_CELL_BAND_WIDTH - 1)     // End X of the area inside the band
+
+#define GRID_CELL_TIMEOUT_SYMBOL_START_X (uint16_t)(GRID_CELL_CONTENT_END_X - 6)
+#define GRID_CELL_TIMEOUT_SYMBOL_START_Y (uint16_t)(GRID_CELL_CONTENT_START_Y - GRID_CELL_INNER_VER_PADDING - GRID_CELL_TIMEOUT_SYMBOL_HEIGHT)
+#define GRID_CELL_TIMEOUT_SYMBOL_END_X (uint16_t)(GRID_CELL_CONTENT_END_X)
+#define GRID_CELL_TIMEOUT_SYMBOL_END_Y (uint16_t)(GRID_CELL_CONTENT_START_Y - GRID_CELL_INNER_VER_PADDING + GRID_CELL_TIMEOUT_SYMBOL_HEIGHT)
+
+#define GUI_WIDGET_TEXT_LENGTH 12 // Longest value text retained for a cell, longer ones are shown as "ERR"
+
+#define BAND_NONE 0 // band_color of elements without a colored band, color 0 is not used for drawing
+
+#define GRID_CELL_CHART_STEP (uint16_t)((GRID_CELL_CONTENT_END_X - GRID_CELL_CONTENT_START_X) / (QUEUE_SIZE - 1)) // Distance between two samples of a trend chart
+#define GRID_CELL_CHART_X(slot) (uint16_t)(GRID_CELL_CONTENT_START_X + (slot) * GRID_CELL_CHART_STEP)
+
+#define GUI_TOUCH_POLL_MS 100 // Interval touch events are read in, tapping a cell switches between value and trend chart
+
+#if GRID_ROW_COUNT * GRID_COLUMN_COUNT > 8
+#error "gui_toggled_cells holds one bit per grid cell"
+#endif
+
+#define CLOCK_FIELD_COUNT 5 // Years, days, hours, minutes and seconds of the running time in the status bar
+
 int current_top_row = 0;
 
 static bool grid[GRID_ROW_COUNT][GRID_COLUMN_COUNT];
 
+typedef struct
+{
+    int32_t low; // value at the bottom of the chart
+    int32_t high; // value at the top of the chart
+    uint8_t cursor; // slot of the newest sample
+    uint16_t last_y; // y of the newest sample
+    uint16_t previous_y; // y of the sample before the newest one
+} gui_chart_state_t; // scale and write position of a trend chart
+
+typedef struct
+{
+    uint8_t ui_state; // ui_state the cell was rendered with, 0 if nothing is drawn
+    union
+    {
+        char text[GUI_WIDGET_TEXT_LENGTH + 1]; // ui_state 1: value text as it was drawn, empty if none is drawn
+        gui_chart_state_t chart; // ui_state 2
+    };
+    uint8_t text_size; // text size the value was drawn with
+    uint8_t band_color; // color of the band around the value, BAND_NONE if none is drawn
+    bool timeout_symbol; // whether the hourglass is drawn
+} gui_widget_state_t; // last rendered look of a grid cell, so updates only send the TLCD commands for what changed
+
+static gui_widget_state_t gui_widget_states[GRID_ROW_COUNT][GRID_COLUMN_COUNT]; // kept outside gui_element_container_t, which fills a pool block
+static uint8_t gui_toggled_cells = 0; // one bit per cell (row * GRID_COLUMN_COUNT + column) that was tapped since the last check
+
+static const uint16_t clock_field_x[CLOCK_FIELD_COUNT + 1] = {TLCD_WIDTH - 336, TLCD_WIDTH - 273, TLCD_WIDTH - 210, TLCD_WIDTH - 147, TLCD_WIDTH - 70, TLCD_WIDTH}; // Start X of the slot of every field, each slot holds its text in GUI_FONT plus a space, the last slot ends at the display border
+static const char* const clock_field_format[CLOCK_FIELD_COUNT] = {"Years:%02d", "Days:%03d", "Hours:%02d", "Minutes:%02d", "Seconds:%02d"};
+static int16_t clock_fields[CLOCK_FIELD_COUNT]; // Fields of the running time as they were drawn, -1 if not drawn yet
+
 #define SENSOR_ELEMENT_BUFFER_SIZE 10 // Amount of SensorData allowed to be cached
 
 int sensor_element_buffer_count = 0; // Amount of SensorData in the sensor_element_buffer
-sensor_data_t sensor_element_buffer[SENSOR_ELEMENT_BUFFER_SIZE]; // Buffers incoming SensorData to be processed later by the gui_worker
+sensor_data_t* sensor_element_buffer[SENSOR_ELEMENT_BUFFER_SIZE]; // Buffers incoming SensorData (pool blocks) to be processed later by the gui_worker
+uint8_t sensor_element_buffer_index[SENSOR_REGISTRY_SIZE]; // Position + 1 of the cached record of each sensor handle, 0 if none is cached
 
 void enqueue_sensor_data_into_buffer(sensor_data_t* data)
 {
+    if (data->sensor_handle >= SENSOR_REGISTRY_SIZE)
+    {
+        printf_P(PSTR("enqueue_sensor_data_into_buffer() received an unregistered sensor\n\n"));
+        return;
+    }
+
     os_enterCriticalSection();
 
-    for (int i = 0; i < sensor_element_buffer_count; i++) // override prior data of this sensor still cached
+    uint8_t position = sensor_element_buffer_index[data->sensor_handle];
+    if (position != 0) // override prior data of this sensor still cached
     {
-        if (sensor_element_buffer[i].sensor_src_address == data->sensor_src_address && sensor_element_buffer[i].sensor_type == data->sensor_type && sensor_element_buffer[i].sensor_data_type == data->sensor_data_type)
-        {
-            sensor_element_buffer[i] = *data;
-            // DEBUG("enqueue_sensor_data_into_buffer() overwrote previously buffered sensor data\n");
-            // DEBUG("enqueue_sensor_data_into_buffer() at %d is now:\n", i);
-            // print_sensor_data(&sensor_element_buffer[i]);
-            os_leaveCriticalSection();
-            return;
-        }
+        *sensor_element_buffer[position - 1] = *data;
+        // DEBUG("enqueue_sensor_data_into_buffer() overwrote previously buffered sensor data\n");
+        os_leaveCriticalSection();
+        return;
     }
 
     if (sensor_element_buffer_count == SENSOR_ELEMENT_BUFFER_SIZE)
@@ -101,8 +166,19 @@ void enqueue_sensor_data_into_buffer(sensor_data_t* data)
     }
 
 
-    sensor_element_buffer[sensor_element_buffer_count] = *data;
+    sensor_data_t* record = os_memPoolAlloc(sizeof(sensor_data_t));
+    if (record == NULL)
+    {
+        os_leaveCriticalSection();
+        printf_P(PSTR("enqueue_sensor_data_into_buffer() found no free pool block\n\n"));
+        return;
+    }
+    *record = *data;
+    os_memPoolSetOwner(record, INVALID_PROCESS); // the buffer owns the record until the gui_worker frees it
+
+    sensor_element_buffer[sensor_element_buffer_count] = record;
     sensor_element_buffer_count++;
+    sensor_element_buffer_index[data->sensor_handle] = sensor_element_buffer_count;
 
     // DEBUG("enqueue_sensor_data_into_buffer() sensor_element_buffer_count: %d\n", sensor_element_buffer_count);
     // DEBUG("enqueue_sensor_data_into_buffer() at %d is now:\n", 0);
@@ -113,32 +189,32 @@ void enqueue_sensor_data_into_buffer(sensor_data_t* data)
 /**
  * Updates the sensor data for a GUI element.
  *
- * This function checks if the provided sensor_data's fValue is less than the
+ * This function checks if the provided fixed point sensor_data is less than the
  * gui_element's current minimum value or greater than its current maximum value.
  * If so, it updates the respective min_value or max_value in the gui_element.
  * Additionally, it pushes the sensor_data into the sensor_data_queue and increments
  * the queue count.
  *
  * @param gui_element Pointer to the GUI element container to be updated.
- * @param sensor_data Pointer to the sensor data containing the new value.
+ * @param sensor_data The new value with sensorData_getDecimals() decimals.
  */
-void update_sensor_data(gui_element_container_t* gui_element, sensor_parameter_t* sensor_data)
+void update_sensor_data(gui_element_container_t* gui_element, int32_t sensor_data)
 {
-    if (sensor_value_is_smaller(sensor_data, &gui_element->min_value, gui_element->sensor_data_type))
+    if (sensor_data < gui_element->min_value)
     {
-        gui_element->min_value = *sensor_data;
+        gui_element->min_value = sensor_data;
     }
-    else if (sensor_value_is_greater(sensor_data, &gui_element->max_value, gui_element->sensor_data_type))
+    if (sensor_data > gui_element->max_value)
     {
-        gui_element->max_value = *sensor_data;
+        gui_element->max_value = sensor_data;
     }
 
-    queue_push(&gui_element->sensor_data_queue, *sensor_data);
+    queue_push(&gui_element->sensor_data_queue, sensor_data);
 }
 // Called when data from a new sensor was cached and will be added as a gui_element
 // Returns true if the element was added successfully, false if there was no space in the grid
 // Will add a new gui_element to the sensor_gui_elements array, so update_sensor_data() should not be called for this sensor_element
-bool add_gui_element(gui_element_container_t sensor_gui_elements[16], uint8_t* sensor_gui_elements_count, sensor_data_t* sensor_element)
+bool add_gui_element(gui_element_container_t* sensor_gui_elements[GUI_ELEMENT_CONTAINER_SIZE], uint8_t* sensor_gui_elements_count, sensor_data_t* sensor_element)
 {
     os_enterCriticalSection();
 
@@ -158,40 +234,50 @@ bool add_gui_element(gui_element_container_t sensor_gui_elements[16], uint8_t* s
         {
             if (!grid[row][column])
             {
-                grid[row][column] = true;
+                gui_element_container_t* new_sensor_gui_element = os_memPoolAlloc(sizeof(gui_element_container_t));
+                if (new_sensor_gui_element == NULL)
+                {
+                    os_leaveCriticalSection();
+                    WARN("add_gui_element() found no free pool block");
+                    return false;
+                }
 
-                gui_element_container_t new_sensor_gui_element;
+                grid[row][column] = true;
 
-                new_sensor_gui_element.sensor_src_address = sensor_element->sensor_src_address;
-                new_sensor_gui_element.sensor_data_type = sensor_element->sensor_data_type;
-                new_sensor_gui_element.sensor_type = sensor_element->sensor_type;
-                queue_init(&new_sensor_gui_element.sensor_data_queue);
-                queue_push(&new_sensor_gui_element.sensor_data_queue, sensor_element->sensor_data_value);
-                new_sensor_gui_element.sensor_last_update = getSystemTime_ms();
+                new_sensor_gui_element->sensor_src_address = sensor_element->sensor_src_address;
+                new_sensor_gui_element->sensor_data_type = sensor_element->sensor_data_type;
+                new_sensor_gui_element->sensor_type = sensor_element->sensor_type;
+                queue_init(&new_sensor_gui_element->sensor_data_queue);
+                queue_push(&new_sensor_gui_element->sensor_data_queue, sensor_element->sensor_fixed_value);
+                new_sensor_gui_element->sensor_last_update = getSystemTime_ms();
 
-                new_sensor_gui_element.min_value.fValue = 0.0;
-                new_sensor_gui_element.max_value.fValue = 0.0;
+                // The first value is the minimum and maximum so far, 0 would be wrong for ranges not containing it
+                new_sensor_gui_element->min_value = sensor_element->sensor_fixed_value;
+                new_sensor_gui_element->max_value = sensor_element->sensor_fixed_value;
 
-                new_sensor_gui_element.row1 = row;
-                new_sensor_gui_element.column1 = column;
-                new_sensor_gui_element.row2 = row;
-                new_sensor_gui_element.column2 = column;
+                new_sensor_gui_element->row1 = row;
+                new_sensor_gui_element->column1 = column;
+                new_sensor_gui_element->row2 = row;
+                new_sensor_gui_element->column2 = column;
 
-                new_sensor_gui_element.ui_state = 1;
-                new_sensor_gui_element.timeout_flag = false;
+                new_sensor_gui_element->ui_state = GUI_ELEMENT_DEFAULT_UI_STATE;
+                new_sensor_gui_element->timeout_flag = false;
+                memset(&gui_widget_states[row][column], 0, sizeof(gui_widget_state_t)); // nothing is drawn in the cell yet
 
                 sensor_gui_elements[*sensor_gui_elements_count] = new_sensor_gui_element; // add new element to the container
                 (*sensor_gui_elements_count)++;
 
                 INFO("add_gui_element() added element at row: %d, column: %d", row, column);
-                // print_gui_element(&new_sensor_gui_element);
+                // print_gui_element(new_sensor_gui_element);
                 os_leaveCriticalSection();
 
                 char buffer[50];  // Buffer to store the formatted string
 
-                gui_element_container_t* gui_element = &new_sensor_gui_element;
+                gui_element_container_t* gui_element = new_sensor_gui_element;
+                tlcd_addButton(GRID_CELL_START_X, GRID_CELL_START_Y, GRID_CELL_END_X, GRID_CELL_END_Y, 0, row * GRID_COLUMN_COUNT + column); // invisible, tapping the cell toggles the trend chart
                 // Format the string with the hex value and float value
-                sprintf(buffer, "Address: %d, Sensor: %d", new_sensor_gui_element.sensor_src_address, new_sensor_gui_element.sensor_type);
+                sprintf(buffer, "Address: %d, Sensor: %d", new_sensor_gui_element->sensor_src_address, new_sensor_gui_element->sensor_type);
+                buffer[tlcd_fitString(GUI_FONT, 1, buffer, GRID_CELL_END_X - GRID_CELL_START_X - TEXT_START_X_OFFSET)] = '\0'; // cut off what would run into the next cell
                 tlcd_drawString(GRID_CELL_START_X + TEXT_START_X_OFFSET, GRID_CELL_START_Y, buffer);
                 memset(buffer, 0, sizeof(buffer));
                 return true;
@@ -210,140 +296,301 @@ void drawHourglass(int startX, int startY, int endX, int endY) {
     tlcd_drawLine(endX, startY, startX, endY);
 }
 
-// called when sensor_data is already cached to update an existing gui_element with either real data or to mark it as outdated
-void update_gui_element(gui_element_container_t* gui_element, bool real_update)
+// draws or removes the timeout symbol of an element, if it is not already in that state
+void render_timeout_symbol(gui_element_container_t* gui_element, bool timed_out)
 {
-    if (!real_update)
+    gui_widget_state_t* state = &gui_widget_states[gui_element->row1][gui_element->column1];
+
+    if (state->timeout_symbol == timed_out)
+    {
+        return;
+    }
+    state->timeout_symbol = timed_out;
+
+    if (timed_out)
     {
         //draw triangle by lines
-        drawHourglass(GRID_CELL_CONTENT_END_X - 6, GRID_CELL_CONTENT_START_Y - GRID_CELL_INNER_VER_PADDING - GRID_CELL_TIMEOUT_SYMBOL_HEIGHT, GRID_CELL_CONTENT_END_X, GRID_CELL_CONTENT_START_Y - GRID_CELL_INNER_VER_PADDING + GRID_CELL_TIMEOUT_SYMBOL_HEIGHT);
+        drawHourglass(GRID_CELL_TIMEOUT_SYMBOL_START_X, GRID_CELL_TIMEOUT_SYMBOL_START_Y, GRID_CELL_TIMEOUT_SYMBOL_END_X, GRID_CELL_TIMEOUT_SYMBOL_END_Y);
+    }
+    else
+    {
+        tlcd_clearArea(GRID_CELL_TIMEOUT_SYMBOL_START_X, GRID_CELL_TIMEOUT_SYMBOL_START_Y, GRID_CELL_TIMEOUT_SYMBOL_END_X, GRID_CELL_TIMEOUT_SYMBOL_END_Y);
+    }
+}
 
-        printf("update_gui_element() WRITTEN TIMEOUT SYMBOL\n");
+// draws the colored band around the value of an element, the four rectangles overwrite a band of another color
+void draw_band(gui_element_container_t* gui_element, uint8_t color)
+{
+    tlcd_changeLineColor(color);
+    for (uint8_t i = 1; i <= GRID_CELL_BAND_WIDTH; i++)
+    {
+        tlcd_drawRectangle(GRID_CELL_START_X + 2 + i, GRID_CELL_CONTENT_START_Y + i, GRID_CELL_END_X - 2 - i, GRID_CELL_CONTENT_END_Y + i);
+    }
+    tlcd_changeLineColor(COLOR_BLACK);
+}
+
+// clears the content of a cell and its retained state if it was rendered with another ui_state, the timeout symbol stays
+void prepare_gui_element(gui_element_container_t* gui_element, uint8_t ui_state)
+{
+    gui_widget_state_t* state = &gui_widget_states[gui_element->row1][gui_element->column1];
+
+    if (state->ui_state == ui_state)
+    {
         return;
-        //tlcd_changeLineColor(COLOR_GREY);
     }
-    else // real update
+    if (state->ui_state != 0)
     {
-        gui_element->timeout_flag = false;
-        gui_element->sensor_last_update = getSystemTime_ms();
-        //tlcd_changeLineColor(COLOR_RED);
-        tlcd_clearArea(GRID_CELL_START_X, GRID_CELL_CONTENT_START_Y - GRID_CELL_INNER_VER_PADDING - GRID_CELL_TIMEOUT_SYMBOL_HEIGHT, GRID_CELL_END_X, GRID_CELL_CONTENT_END_Y);
+        tlcd_clearArea(GRID_CELL_START_X + 3, GRID_CELL_CONTENT_START_Y, GRID_CELL_END_X - 3, GRID_CELL_CONTENT_END_Y + GRID_CELL_BAND_WIDTH);
     }
 
-    sensor_parameter_t data;
+    bool timeout_symbol = state->timeout_symbol;
+    memset(state, 0, sizeof(gui_widget_state_t));
+    state->timeout_symbol = timeout_symbol;
+    state->ui_state = ui_state;
+}
 
-    if (!queue_peek_newest_data(&gui_element->sensor_data_queue, &data))
+// computes the rectangle a value text covers when it is centered in the content area of a cell
+void value_text_rect(gui_element_container_t* gui_element, uint8_t text_size, const char* text, uint16_t* x1, uint16_t* y1, uint16_t* x2, uint16_t* y2)
+{
+    uint16_t width = tlcd_measureString(GUI_FONT, text_size, text);
+    uint16_t height = tlcd_getFontHeight(GUI_FONT, text_size);
+
+    *x1 = GRID_CELL_CONTENT_START_X + (GRID_CELL_CONTENT_END_X - GRID_CELL_CONTENT_START_X + 1 - width) / 2;
+    *y1 = GRID_CELL_CONTENT_START_Y + (GRID_CELL_CONTENT_END_Y - GRID_CELL_CONTENT_START_Y + 1 - height) / 2;
+    *x2 = *x1 + width - 1;
+    *y2 = *y1 + height - 1;
+}
+
+// returns the biggest text size a value text fits into the content area of a cell with, 0 if it does not fit at all
+uint8_t fit_text_size(gui_element_container_t* gui_element, const char* text)
+{
+    uint8_t text_size = GUI_TEXT_SIZE_MAX;
+
+    while (text_size > 0 && tlcd_measureString(GUI_FONT, text_size, text) > GRID_CELL_CONTENT_END_X - GRID_CELL_CONTENT_START_X + 1)
+    {
+        text_size--;
+    }
+    return text_size;
+}
+
+/*
+compares the wanted look of an element with the one it was last rendered with and only sends the TLCD commands for the parts that changed
+- band_color: color of the band around the value, BAND_NONE for no band
+- text_size: text size the value is drawn with
+- text: value text, at most GUI_WIDGET_TEXT_LENGTH characters that fit into the cell with text_size
+the text is positioned with the font metrics, so only the rectangle the old text covered is cleared
+*/
+void render_gui_element(gui_element_container_t* gui_element, uint8_t band_color, uint8_t text_size, const char* text)
+{
+    gui_widget_state_t* state = &gui_widget_states[gui_element->row1][gui_element->column1];
+
+    prepare_gui_element(gui_element, 1);
+
+    if (band_color != state->band_color)
     {
-        WARN("update_gui_element() TEMP String length out of bounds");
-        tlcd_changeTextSize(2);
-        char buffer[5];  // Buffer to store the formatted string
-        memset(buffer, 0, sizeof(buffer));
-        strcat(buffer, "ERR");
-        tlcd_drawStringInArea(GRID_CELL_CONTENT_START_X, GRID_CELL_CONTENT_START_Y, GRID_CELL_CONTENT_END_X, GRID_CELL_CONTENT_END_Y, buffer);
+        if (band_color == BAND_NONE)
+        {
+            // removing the band also removes the text inside of it
+            tlcd_clearArea(GRID_CELL_START_X + 3, GRID_CELL_CONTENT_START_Y + 1, GRID_CELL_END_X - 3, GRID_CELL_CONTENT_END_Y + GRID_CELL_BAND_WIDTH);
+            state->text[0] = '\0';
+        }
+        else
+        {
+            draw_band(gui_element, band_color);
+        }
+        state->band_color = band_color;
+    }
+
+    if (text_size != state->text_size || strcmp(text, state->text) != 0)
+    {
+        uint16_t x1, y1, x2, y2;
+
+        if (state->text[0] != '\0')
+        {
+            value_text_rect(gui_element, state->text_size, state->text, &x1, &y1, &x2, &y2);
+            tlcd_clearArea(x1, y1, x2, y2);
+        }
+        value_text_rect(gui_element, text_size, text, &x1, &y1, &x2, &y2);
+        tlcd_changeTextSize(text_size);
+        tlcd_drawString(x1, y1, text);
         tlcd_changeTextSize(1);
+
+        strcpy(state->text, text);
+        state->text_size = text_size;
+    }
+}
+
+// returns the y of a value in the trend chart of an element
+uint16_t chart_value_y(gui_element_container_t* gui_element, gui_chart_state_t* chart, int32_t value)
+{
+    return GRID_CELL_CONTENT_END_Y - (uint16_t)((value - chart->low) * (GRID_CELL_CONTENT_END_Y - GRID_CELL_CONTENT_START_Y) / (chart->high - chart->low));
+}
+
+/*
+draws the queued values of an element as a trend chart (ui_state 2)
+- the chart is written like a sweep: every sample takes the next of QUEUE_SIZE slots, wrapping around to the left border
+- a new sample clears the segment of the oldest sample in its slot, starting at the column of the previous sample,
+  redraws the segment into the previous sample that lost that column and draws the segment to the new sample,
+  so it costs at most three TLCD commands no matter how many samples are shown
+- the whole chart is only redrawn if a value leaves the scale
+*/
+void render_trend_chart(gui_element_container_t* gui_element)
+{
+    gui_widget_state_t* state = &gui_widget_states[gui_element->row1][gui_element->column1];
+    gui_chart_state_t* chart = &state->chart;
+    data_queue_t* queue = &gui_element->sensor_data_queue;
+    int32_t value;
+
+    if (!queue_peek_newest_data(queue, &value))
+    {
+        return;
+    }
+
+    if (state->ui_state == 2 && value >= chart->low && value <= chart->high)
+    {
+        uint8_t previous = chart->cursor;
+        uint16_t y = chart_value_y(gui_element, chart, value);
+        chart->cursor = (chart->cursor + 1) % QUEUE_SIZE;
+
+        if (chart->cursor == 0) // no segment across the wrap around, only the column of the oldest sample is cleared
+        {
+            tlcd_clearArea(GRID_CELL_CHART_X(0), GRID_CELL_CONTENT_START_Y, GRID_CELL_CHART_X(0), GRID_CELL_CONTENT_END_Y);
+            tlcd_drawPoint(GRID_CELL_CHART_X(0), y);
+        }
+        else
+        {
+            // the old segment also covers the column of the previous sample, so that column is cleared and redrawn as well
+            tlcd_clearArea(GRID_CELL_CHART_X(previous), GRID_CELL_CONTENT_START_Y, GRID_CELL_CHART_X(chart->cursor), GRID_CELL_CONTENT_END_Y);
+            if (previous == 0)
+            {
+                tlcd_drawPoint(GRID_CELL_CHART_X(0), chart->last_y);
+            }
+            else
+            {
+                tlcd_drawLine(GRID_CELL_CHART_X(previous - 1), chart->previous_y, GRID_CELL_CHART_X(previous), chart->last_y);
+            }
+            tlcd_drawLine(GRID_CELL_CHART_X(previous), chart->last_y, GRID_CELL_CHART_X(chart->cursor), y);
+        }
+        chart->previous_y = chart->last_y;
+        chart->last_y = y;
+        return;
+    }
+
+    // (re)scale to the queued values with some room above and below, then redraw them from the left border
+    bool rescale = state->ui_state == 2;
+    prepare_gui_element(gui_element, 2);
+    if (rescale)
+    {
+        tlcd_clearArea(GRID_CELL_START_X + 3, GRID_CELL_CONTENT_START_Y, GRID_CELL_END_X - 3, GRID_CELL_CONTENT_END_Y + GRID_CELL_BAND_WIDTH);
+    }
+
+    int32_t low = value;
+    int32_t high = value;
+    for (int i = 0; i < queue->count; i++)
+    {
+        queue_peek_element(queue, &value, i);
+        low = value < low ? value : low;
+        high = value > high ? value : high;
+    }
+    int32_t margin = (high - low) / 4;
+    if (margin == 0)
+    {
+        margin = 1;
+    }
+    chart->low = low - margin;
+    chart->high = high + margin;
+
+    for (int i = 0; i < queue->count; i++)
+    {
+        queue_peek_element(queue, &value, i);
+        uint16_t y = chart_value_y(gui_element, chart, value);
+        if (i == 0)
+        {
+            tlcd_drawPoint(GRID_CELL_CHART_X(0), y);
+        }
+        else
+        {
+            tlcd_drawLine(GRID_CELL_CHART_X(i - 1), chart->last_y, GRID_CELL_CHART_X(i), y);
+        }
+        chart->cursor = i;
+        chart->previous_y = chart->last_y;
+        chart->last_y = y;
+    }
+}
+
+// draws the newest value of an element in its ui_state
+// the look of the element is computed from its newest value, render_gui_element() then only draws what differs from the display
+void draw_gui_element(gui_element_container_t* gui_element)
+{
+    if (gui_element->ui_state == 2)
+    {
+        render_trend_chart(gui_element);
         return;
     }
 
-    char buffer[50];  // Buffer to store the formatted string
+    int32_t data; // fixed point value, see sensorData_getDecimals()
 
+    if (!queue_peek_newest_data(&gui_element->sensor_data_queue, &data))
+    {
+        WARN("draw_gui_element() TEMP String length out of bounds");
+        render_gui_element(gui_element, BAND_NONE, 2, "ERR");
+        return;
+    }
 
+    char buffer[FIXED_POINT_MAX_LENGTH + 5];  // Buffer to store the formatted string, the longest suffix has 4 characters
+    uint8_t decimals = sensorData_getDecimals(gui_element->sensor_data_type);
+    uint8_t band_color = BAND_NONE;
     int length = 0;
 
+    if (gui_element->ui_state != 1)
+    {
+        WARN("draw_gui_element() unknown ui_state");
+        return;
+    }
+
     switch (gui_element->sensor_data_type)
     {
         case PARAM_CO2_PPM: //ALSO TEST CASE
         {
-            switch (gui_element->ui_state)
+            length = fixedPoint_format(buffer, data, decimals, 0, " PPM");
+            if (data > 1400)
             {
-                case 1:
-                {
-                    sprintf(buffer, "%u", (unsigned int)data.uValue);
-                    if (data.uValue > 1400)
-                    {
-                        tlcd_changeLineColor(COLOR_RED);
-                    }
-                    else if (data.uValue > 1000)
-                    {
-                        tlcd_changeLineColor(COLOR_ORANGE);
-                    }
-                    else
-                    {
-                        tlcd_changeLineColor(COLOR_GREEN);
-                    }
-                    tlcd_drawRectangle(GRID_CELL_START_X + 2 + 1, GRID_CELL_CONTENT_START_Y + 1, GRID_CELL_END_X - 2 - 1, GRID_CELL_CONTENT_END_Y + 1);
-                    tlcd_drawRectangle(GRID_CELL_START_X + 2 + 2, GRID_CELL_CONTENT_START_Y + 2, GRID_CELL_END_X - 2 - 2, GRID_CELL_CONTENT_END_Y + 2);
-                    tlcd_drawRectangle(GRID_CELL_START_X + 2 + 3, GRID_CELL_CONTENT_START_Y + 3, GRID_CELL_END_X - 2 - 3, GRID_CELL_CONTENT_END_Y + 3);
-                    tlcd_drawRectangle(GRID_CELL_START_X + 2 + 4, GRID_CELL_CONTENT_START_Y + 4, GRID_CELL_END_X - 2 - 4, GRID_CELL_CONTENT_END_Y + 4);
-                    tlcd_changeLineColor(COLOR_BLACK);
-
-                    strcat(buffer, " ");
-                    strcat(buffer, "PPM");
-                    length = strlen(buffer);
-                }
-                break;
-                case 2:
-                {
-
-                }
-                break;
-                default:
-                    WARN("update_gui_element() unknown ui_state");
-                    return;
+                band_color = COLOR_RED;
+            }
+            else if (data > 1000)
+            {
+                band_color = COLOR_ORANGE;
+            }
+            else
+            {
+                band_color = COLOR_GREEN;
             }
         }
         break;
 
-        case PARAM_TEMPERATURE_CELSIUS:
+        case PARAM_TEMPERATURE_CELSIUS: // one decimal, 300 is 30.0 *C
         {
-            switch (gui_element->ui_state)
-            {
-                case 1:
-                {
-                    sprintf(buffer, "%.1f", data.fValue);
-
-                    if (data.fValue >= 30.0)
-                    {
-                        tlcd_changeLineColor(COLOR_RED);
-                        //make border
-                    }
-                    else if (data.fValue >= 25.0)
-                    {
-                        tlcd_changeLineColor(COLOR_ORANGE);
-                    }
-                    else if (data.fValue < 16.0)
-                    {
-                        tlcd_changeLineColor(COLOR_LIGHT_BLUE);
-                    }
-                    else if (data.fValue < 12.0)
-                    {
-                        tlcd_changeLineColor(COLOR_BLUE);
-                    }
-                    else
-                    {
-                        tlcd_changeLineColor(COLOR_GREEN);
-                    }
-
-                    tlcd_drawRectangle(GRID_CELL_START_X + 2 + 1, GRID_CELL_CONTENT_START_Y + 1, GRID_CELL_END_X - 2 - 1, GRID_CELL_CONTENT_END_Y + 1);
-                    tlcd_drawRectangle(GRID_CELL_START_X + 2 + 2, GRID_CELL_CONTENT_START_Y + 2, GRID_CELL_END_X - 2 - 2, GRID_CELL_CONTENT_END_Y + 2);
-                    tlcd_drawRectangle(GRID_CELL_START_X + 2 + 3, GRID_CELL_CONTENT_START_Y + 3, GRID_CELL_END_X - 2 - 3, GRID_CELL_CONTENT_END_Y + 3);
-                    tlcd_drawRectangle(GRID_CELL_START_X + 2 + 4, GRID_CELL_CONTENT_START_Y + 4, GRID_CELL_END_X - 2 - 4, GRID_CELL_CONTENT_END_Y + 4);
-
-                    tlcd_changeLineColor(COLOR_BLACK);
-
-                    strcat(buffer, " ");
-                    strcat(buffer, "*");
-                    strcat(buffer, "C");
-                    length = strlen(buffer);
-                }
-                break;
-                case 2:
-                {
+            length = fixedPoint_format(buffer, data, decimals, 0, " *C");
 
-                }
-                break;
-                default:
-                    WARN("update_gui_element() unknown ui_state");
-                    return;
+            if (data >= 300)
+            {
+                band_color = COLOR_RED;
+            }
+            else if (data >= 250)
+            {
+                band_color = COLOR_ORANGE;
+            }
+            else if (data < 120)
+            {
+                band_color = COLOR_BLUE;
+            }
+            else if (data < 160)
+            {
+                band_color = COLOR_LIGHT_BLUE;
+            }
+            else
+            {
+                band_color = COLOR_GREEN;
             }
         }
         break;
@@ -351,168 +598,101 @@ void update_gui_element(gui_element_container_t* gui_element, bool real_update)
         case PARAM_LIGHT_INTENSITY_PERCENT:
         case PARAM_HUMIDITY_PERCENT:
         {
-            switch (gui_element->ui_state)
-            {
-                case 1:
-                {
-                    sprintf(buffer, "%.1f", data.fValue);
-
-                    strcat(buffer, " ");
-                    strcat(buffer, "\%");
-                    length = strlen(buffer);
-                }
-                break;
-                case 2:
-                {
-
-                }
-                break;
-                default:
-                    WARN("update_gui_element() unknown ui_state");
-                    return;
-            }
+            length = fixedPoint_format(buffer, data, decimals, 0, " %");
         }
         break;
 
         case PARAM_PRESSURE_PASCAL:
         {
-            switch (gui_element->ui_state)
-            {
-                case 1:
-                {
-                    sprintf(buffer, "%.1f", data.fValue);
-                    strcat(buffer, " ");
-                    strcat(buffer, "hPa");
-                    length = strlen(buffer);
-                }
-                break;
-                case 2:
-                {
-
-                }
-                break;
-                default:
-                    WARN("update_gui_element() unknown ui_state");
-                    return;
-            }
+            length = fixedPoint_format(buffer, data, decimals, 0, " hPa");
         }
         break;
 
-        case PARAM_E_CO2_PPM:
+        case PARAM_E_CO2_PPM: // one decimal, 20000 is 2000.0 PPM
         {
-            switch (gui_element->ui_state)
-            {
-                case 1:
-                {
-                    sprintf(buffer, "%.1f", data.fValue);
-
-                    strcat(buffer, " ");
-                    strcat(buffer, "PPM");
-                    length = strlen(buffer);
-
-                    if (data.fValue > 2000)
-                    {
-                        tlcd_changeLineColor(COLOR_RED);
-                    }
-                    else if (data.fValue > 1500)
-                    {
-                        tlcd_changeLineColor(COLOR_ORANGE);
-                    }
-                    else
-                    {
-                        tlcd_changeLineColor(COLOR_GREEN);
-                    }
-
-                    tlcd_drawRectangle(GRID_CELL_START_X + 2 + 1, GRID_CELL_CONTENT_START_Y + 1, GRID_CELL_END_X - 2 - 1, GRID_CELL_CONTENT_END_Y + 1);
-                    tlcd_drawRectangle(GRID_CELL_START_X + 2 + 2, GRID_CELL_CONTENT_START_Y + 2, GRID_CELL_END_X - 2 - 2, GRID_CELL_CONTENT_END_Y + 2);
-                    tlcd_drawRectangle(GRID_CELL_START_X + 2 + 3, GRID_CELL_CONTENT_START_Y + 3, GRID_CELL_END_X - 2 - 3, GRID_CELL_CONTENT_END_Y + 3);
-                    tlcd_drawRectangle(GRID_CELL_START_X + 2 + 4, GRID_CELL_CONTENT_START_Y + 4, GRID_CELL_END_X - 2 - 4, GRID_CELL_CONTENT_END_Y + 4);
-                    tlcd_changeLineColor(COLOR_BLACK);
-                }
-                break;
-                case 2:
-                {
+            length = fixedPoint_format(buffer, data, decimals, 0, " PPM");
 
-                }
-                break;
-                default:
-                    WARN("update_gui_element() unknown ui_state");
-                    return;
+            if (data > 20000)
+            {
+                band_color = COLOR_RED;
+            }
+            else if (data > 15000)
+            {
+                band_color = COLOR_ORANGE;
+            }
+            else
+            {
+                band_color = COLOR_GREEN;
             }
         }
         break;
 
         case PARAM_TVOC_PPB:
         {
-            switch (gui_element->ui_state)
-            {
-                case 1:
-                {
-                    sprintf(buffer, "%u", (unsigned int)data.uValue);
-
-                    strcat(buffer, " ");
-                    strcat(buffer, "PPB");
-                    length = strlen(buffer);
-
-                    if (data.uValue > 1200)
-                    {
-                        tlcd_changeLineColor(COLOR_RED);
-                    }
-                    else if (data.uValue > 550)
-                    {
-                        tlcd_changeLineColor(COLOR_ORANGE);
-                    }
-                    else
-                    {
-                        tlcd_changeLineColor(COLOR_GREEN);
-                    }
-
-                    tlcd_drawRectangle(GRID_CELL_START_X + 2 + 1, GRID_CELL_CONTENT_START_Y + 1, GRID_CELL_END_X - 2 - 1, GRID_CELL_CONTENT_END_Y + 1);
-                    tlcd_drawRectangle(GRID_CELL_START_X + 2 + 2, GRID_CELL_CONTENT_START_Y + 2, GRID_CELL_END_X - 2 - 2, GRID_CELL_CONTENT_END_Y + 2);
-                    tlcd_drawRectangle(GRID_CELL_START_X + 2 + 3, GRID_CELL_CONTENT_START_Y + 3, GRID_CELL_END_X - 2 - 3, GRID_CELL_CONTENT_END_Y + 3);
-                    tlcd_drawRectangle(GRID_CELL_START_X + 2 + 4, GRID_CELL_CONTENT_START_Y + 4, GRID_CELL_END_X - 2 - 4, GRID_CELL_CONTENT_END_Y + 4);
-                    tlcd_changeLineColor(COLOR_BLACK);
-                }
-                break;
-                case 2:
-                {
+            length = fixedPoint_format(buffer, data, decimals, 0, " PPB");
 
-                }
-                break;
-                default:
-                    WARN("update_gui_element() unknown ui_state");
-                    return;
+            if (data > 1200)
+            {
+                band_color = COLOR_RED;
+            }
+            else if (data > 550)
+            {
+                band_color = COLOR_ORANGE;
+            }
+            else
+            {
+                band_color = COLOR_GREEN;
             }
         }
         break;
         default:
+            buffer[0] = '\0';
             break;
     }
 
-    if (length <= 8)
+    uint8_t text_size = length <= GUI_WIDGET_TEXT_LENGTH ? fit_text_size(gui_element, buffer) : 0;
+    if (text_size > 0)
     {
-        tlcd_changeTextSize(2);
+        render_gui_element(gui_element, band_color, text_size, buffer);
     }
-    else if (length <= 12)
+    else
     {
-        tlcd_changeTextSize(1);
+        WARN("draw_gui_element() TEMP String length out of bounds");
+        render_gui_element(gui_element, band_color, GUI_TEXT_SIZE_MAX, "ERR");
     }
-    else
+}
+
+// called when sensor_data is already cached to update an existing gui_element with either real data or to mark it as outdated
+void update_gui_element(gui_element_container_t* gui_element, bool real_update)
+{
+    if (!real_update)
     {
-        WARN("update_gui_element() TEMP String length out of bounds");
-        tlcd_changeTextSize(2);
-        memset(buffer, 0, sizeof(buffer));
-        strcat(buffer, "ERR");
-        tlcd_drawStringInArea(GRID_CELL_CONTENT_START_X, GRID_CELL_CONTENT_START_Y, GRID_CELL_CONTENT_END_X, GRID_CELL_CONTENT_END_Y, buffer);
-        tlcd_changeTextSize(1);
+        render_timeout_symbol(gui_element, true);
+        printf("update_gui_element() WRITTEN TIMEOUT SYMBOL\n");
         return;
     }
 
-    tlcd_drawStringInArea(GRID_CELL_CONTENT_START_X, GRID_CELL_CONTENT_START_Y, GRID_CELL_CONTENT_END_X, GRID_CELL_CONTENT_END_Y, buffer);
-    tlcd_changeTextSize(1);
+    gui_element->timeout_flag = false;
+    gui_element->sensor_last_update = getSystemTime_ms();
+    render_timeout_symbol(gui_element, false);
+
+    draw_gui_element(gui_element);
 }
 
-void init_gui(gui_element_container_t sensor_gui_elements[GUI_ELEMENT_CONTAINER_SIZE])
+// switches an element between showing its newest value (ui_state 1) and a trend chart (ui_state 2) and redraws it
+void toggle_gui_element(gui_element_container_t* gui_element)
+{
+    gui_element->ui_state = gui_element->ui_state == 2 ? 1 : 2;
+    draw_gui_element(gui_element);
+}
+
+// touch button callback of the cells, marks the cell to be toggled by the gui_worker
+void gui_cell_pressed(uint8_t cell, uint16_t x, uint16_t y)
+{
+    gui_toggled_cells |= (1 << cell);
+}
+
+void init_gui(gui_element_container_t* sensor_gui_elements[GUI_ELEMENT_CONTAINER_SIZE])
 {
     // 1 is the BG color from the Device
 
@@ -536,13 +716,17 @@ void init_gui(gui_element_container_t sensor_gui_elements[GUI_ELEMENT_CONTAINER_
     printf_P(PSTR("Clearing Display\n"));
     delayMs(2000);
 
-   // tlcd_setFontZoom(1, 1);
+    tlcd_setButtonCallback(gui_cell_pressed);
+
+    tlcd_changeFont(GUI_FONT);
+    tlcd_changeTextSize(1);
     tlcd_changePenSize(1);
 
     // create TLCD_WIDTH x 22 StatusBar
     tlcd_drawLine(0, GRID_STATUSBAR_HEIGHT, TLCD_WIDTH, GRID_STATUSBAR_HEIGHT);
 
-    tlcd_drawString(TLCD_WIDTH - 380, 0, "Running for:");
+    tlcd_drawString(clock_field_x[0] - tlcd_measureString(GUI_FONT, 1, "Running for: "), 0, "Running for:");
+    memset(clock_fields, 0xFF, sizeof(clock_fields)); // -1, so update_clock() draws every field once
 
     // create grid 400x200 adding outer padding
     // tlcd_drawBox(GRID_OUTER_HOR_PADDING, GRID_OUTER_VER_PADDING + GRID_STATUSBAR_HEIGHT - 1, TLCD_WIDTH - GRID_OUTER_HOR_PADDING, TLCD_HEIGHT - GRID_OUTER_VER_PADDING, COLOR_GREY);
@@ -550,7 +734,7 @@ void init_gui(gui_element_container_t sensor_gui_elements[GUI_ELEMENT_CONTAINER_
 
 void update_clock()
 {
-    char buffer[50];  // Buffer to store the formatted string
+    char buffer[16];  // Buffer to store the formatted field
     time_t local_system_time = getSystemTime_ms();
     time_t seconds = local_system_time / 1000;
     time_t minutes = seconds / 60;
@@ -558,45 +742,27 @@ void update_clock()
     time_t days = hours / 24;
     time_t years = days / 365;
 
-    seconds %= 60;
-    minutes %= 60;
-    hours %= 24;
-    days %= 365;
-
-    static time_t last_second = 0;
-    static time_t last_minute = 0;
-    static time_t last_hour = 0;
-    static time_t last_day = 0;
-    static time_t last_year = 0;
+    int16_t fields[CLOCK_FIELD_COUNT] = {years, days % 365, hours % 24, minutes % 60, seconds % 60};
 
-    if (seconds != last_second)
-    {
-        last_second = seconds;
-        tlcd_clearArea(TLCD_WIDTH - 18, 0, TLCD_WIDTH, GRID_STATUSBAR_HEIGHT - 2);
-    }
-    if (minutes != last_minute)
-    {
-        last_minute = minutes;
-        tlcd_clearArea(TLCD_WIDTH - 90, 0, TLCD_WIDTH - 72, GRID_STATUSBAR_HEIGHT - 2);
-    }
-    if (hours != last_hour)
-    {
-        last_hour = hours;
-        tlcd_clearArea(TLCD_WIDTH - 156, 0, TLCD_WIDTH - 142, GRID_STATUSBAR_HEIGHT - 2);
-    }
-    if (days != last_day)
+    // only the fields that changed since the last call are cleared and redrawn, usually just the seconds
+    for (uint8_t i = 0; i < CLOCK_FIELD_COUNT; i++)
     {
-        last_day = days;
-        tlcd_clearArea(TLCD_WIDTH - 220, 0, TLCD_WIDTH - 198, GRID_STATUSBAR_HEIGHT - 2);
-    }
-    if (years != last_year)
-    {
-        last_year = years;
-        tlcd_clearArea(TLCD_WIDTH - 274, 0, TLCD_WIDTH - 258, GRID_STATUSBAR_HEIGHT - 2);
-    }
+        if (fields[i] == clock_fields[i])
+        {
+            continue;
+        }
+        clock_fields[i] = fields[i];
 
-    sprintf(buffer, "Years:%02d Days:%03d Hours:%02d Minutes:%02d Seconds:%02d", (int)years, (int)days, (int)hours, (int)minutes, (int)seconds);
-    tlcd_drawString(TLCD_WIDTH - 310, 0, buffer);
+        // every field is formatted with a fixed number of digits, so the new text covers the old one and only its own rectangle is cleared
+        sprintf(buffer, clock_field_format[i], (int)fields[i]);
+        uint16_t width = tlcd_measureString(GUI_FONT, 1, buffer);
+        if (width > clock_field_x[i + 1] - clock_field_x[i])
+        {
+            width = clock_field_x[i + 1] - clock_field_x[i];
+        }
+        tlcd_clearArea(clock_field_x[i], 0, clock_field_x[i] + width - 1, tlcd_getFontHeight(GUI_FONT, 1) - 1);
+        tlcd_drawString(clock_field_x[i], 0, buffer);
+    }
 }
 
 /*
@@ -612,13 +778,15 @@ this function is the main worker function of the GUI layer
 void gui_worker()
 {
     DEBUG("STACK_SIZE_PROC: %d", STACK_SIZE_PROC);
-    DEBUG("Array requires %d bytes", sizeof(gui_element_container_t) * GUI_ELEMENT_CONTAINER_SIZE);
+    DEBUG("Elements require %d bytes of pool memory", sizeof(gui_element_container_t) * GUI_ELEMENT_CONTAINER_SIZE);
 
 
     uint8_t sensor_gui_elements_count = 0; // Amount of GUI Elements currently displayed
-    gui_element_container_t sensor_gui_elements[GUI_ELEMENT_CONTAINER_SIZE]; // Array of GUI Elements currently displayed
+    gui_element_container_t* sensor_gui_elements[GUI_ELEMENT_CONTAINER_SIZE]; // GUI Elements currently displayed (pool blocks)
+    gui_element_container_t* sensor_gui_elements_by_handle[SENSOR_REGISTRY_SIZE] = {NULL}; // GUI Element of each sensor handle, NULL if it is not displayed
     time_t local_system_time = getSystemTime_ms();
     time_t last_update = local_system_time;
+    time_t last_touch_poll = local_system_time;
 
     init_gui(sensor_gui_elements);
 
@@ -629,6 +797,22 @@ void gui_worker()
     {
         local_system_time = getSystemTime_ms();
 
+        if ((local_system_time - last_touch_poll) > GUI_TOUCH_POLL_MS)
+        {
+            // the button callback only marks the tapped cells, they are switched here in the process of the gui_worker
+            tlcd_event_worker();
+            tlcd_event_dispatch();
+            for (int i = 0; i < sensor_gui_elements_count; i++)
+            {
+                if (gui_toggled_cells & (1 << (sensor_gui_elements[i]->row1 * GRID_COLUMN_COUNT + sensor_gui_elements[i]->column1)))
+                {
+                    toggle_gui_element(sensor_gui_elements[i]);
+                }
+            }
+            gui_toggled_cells = 0;
+            last_touch_poll = local_system_time;
+        }
+
         os_enterCriticalSection();
 
         if ((local_system_time - last_update) > 1000)
@@ -638,10 +822,10 @@ void gui_worker()
             for (int i = 0; i < sensor_gui_elements_count; i++)
             {
                 // DEBUG("Checking if sensor_gui_elements[%d] needs to be timedout", i);
-                if (!sensor_gui_elements[i].timeout_flag && (local_system_time - sensor_gui_elements[i].sensor_last_update) > SENSOR_DATA_UPDATE_TIMEOUT_MS)
+                if (!sensor_gui_elements[i]->timeout_flag && (local_system_time - sensor_gui_elements[i]->sensor_last_update) > SENSOR_DATA_UPDATE_TIMEOUT_MS)
                 {
-                    sensor_gui_elements[i].timeout_flag = true;
-                    update_gui_element(&sensor_gui_elements[i], false);
+                    sensor_gui_elements[i]->timeout_flag = true;
+                    update_gui_element(sensor_gui_elements[i], false);
                     DEBUG("sensor_gui_elements[%d] was timedout\n\n", i);
                 }
             }
@@ -655,38 +839,41 @@ void gui_worker()
             continue;
         }
 
-        // save local copy of sensor_element_buffer
+        // take over the buffered records, only the pointers are copied
         int local_sensor_element_buffer_count = sensor_element_buffer_count; //copy of global sensor_element_buffer_count
-        sensor_data_t local_sensor_element_buffer[SENSOR_ELEMENT_BUFFER_SIZE]; // copy of global sensor_element_buffer
+        sensor_data_t* local_sensor_element_buffer[SENSOR_ELEMENT_BUFFER_SIZE]; // records handed over by sensor_element_buffer
         memcpy(local_sensor_element_buffer, sensor_element_buffer, sizeof sensor_element_buffer);
 
         // Clear sensor_element_buffer
         memset(sensor_element_buffer, 0, sizeof sensor_element_buffer);
+        memset(sensor_element_buffer_index, 0, sizeof sensor_element_buffer_index);
         sensor_element_buffer_count = 0;
 
         os_leaveCriticalSection();
 
         for (int i = 0; i < local_sensor_element_buffer_count; i++) // iterate all updating data elements
         {
-            bool found = false;
-            for (int j = 0; j < sensor_gui_elements_count; j++) // possibly find the updating data in the present elements
+            // the handle identifies address, sensor type and parameter type, so two parameters of one node get separate elements
+            sensor_handle_t handle = local_sensor_element_buffer[i]->sensor_handle;
+            gui_element_container_t* gui_element = sensor_gui_elements_by_handle[handle];
+
+            if (gui_element != NULL)
             {
-                if (local_sensor_element_buffer[i].sensor_src_address == sensor_gui_elements[j].sensor_src_address) // comparing sensor_address and sensor_data_type
-                {
-                    update_sensor_data(&sensor_gui_elements[j], &local_sensor_element_buffer[i].sensor_data_value);             // update min max values
-                    update_gui_element(&sensor_gui_elements[j], true);                                                       // update GUI element
-                    found = true;
-                    DEBUG("sensor_gui_elements[%d] was updated\n\n", j);
-                    break;
-                }
+                update_sensor_data(gui_element, local_sensor_element_buffer[i]->sensor_fixed_value); // update min max values
+                update_gui_element(gui_element, true);                                               // update GUI element
+                DEBUG("GUI element of sensor handle %d was updated\n\n", handle);
             }
-            if (!found) // sensor was not yet added to the GUI, we gotta do that now
+            else // sensor was not yet added to the GUI, we gotta do that now
             {
-                DEBUG("Sensor %d was not yet added to the GUI\n", local_sensor_element_buffer[i].sensor_src_address);
-                if (!add_gui_element(sensor_gui_elements, &sensor_gui_elements_count, &local_sensor_element_buffer[i]))
-                    continue;                                                                  // we couldn't add it and add_gui_element() printed an Error for us
-                update_gui_element(&sensor_gui_elements[sensor_gui_elements_count - 1], true); // -1 as we successfully added it before to the last position in the array
+                DEBUG("Sensor %d was not yet added to the GUI\n", local_sensor_element_buffer[i]->sensor_src_address);
+                if (add_gui_element(sensor_gui_elements, &sensor_gui_elements_count, local_sensor_element_buffer[i]))
+                {
+                    sensor_gui_elements_by_handle[handle] = sensor_gui_elements[sensor_gui_elements_count - 1]; // -1 as we successfully added it before to the last position in the array
+                    update_gui_element(sensor_gui_elements_by_handle[handle], true);
+                }
+                // else we couldn't add it and add_gui_element() printed an Error for us
             }
+            os_memPoolFree(local_sensor_element_buffer[i]);
         }
     }
 }
@@ -697,8 +884,8 @@ void print_gui_element(gui_element_container_t* gui_element)
     printf_P(PSTR("{\nsensor_src_address: %d\n"), gui_element->sensor_src_address);
     printf_P(PSTR("sensor_data_type: %d\n"), gui_element->sensor_data_type);
     printf_P(PSTR("sensor_last_update: %d\n"), gui_element->sensor_last_update);
-    printf_P(PSTR("min_value: %d\n"), gui_element->min_value);
-    printf_P(PSTR("max_value: %d\n"), gui_element->max_value);
+    printf_P(PSTR("min_value: %ld\n"), gui_element->min_value);
+    printf_P(PSTR("max_value: %ld\n"), gui_element->max_value);
     printf_P(PSTR("row1: %d\n"), gui_element->row1);
     printf_P(PSTR("column1: %d\n"), gui_element->column1);
     printf_P(PSTR("row2: %d\n"), gui_element->row2);
@@ -21,6 +21,12 @@
 #define COLOR_GREEN 8 //green as initialized in init_gui()
 
 #define BACKGROUND_COLOR COLOR_WHITE
+
+#define GUI_ELEMENT_CONTAINER_SIZE 6 // Amount of GUI Elements allowed
+
+#ifndef GUI_ELEMENT_DEFAULT_UI_STATE
+#define GUI_ELEMENT_DEFAULT_UI_STATE 1 //ui_state of new elements: 1 shows the newest value, 2 a trend chart of the queued values, tapping a cell switches it
+#endif
 // #define TEXT_COLOR COLOR_BLACK
 
 
@@ -31,13 +37,13 @@ typedef struct
     sensor_type_t sensor_type;
     data_queue_t sensor_data_queue;
     time_t sensor_last_update;
-    sensor_parameter_t min_value;
-    sensor_parameter_t max_value;
+    int32_t min_value; //fixed point, see sensorData_getDecimals()
+    int32_t max_value; //fixed point, see sensorData_getDecimals()
     int row1; //which row the element starts | 0-3
     int column1; //which column the element starts | 0-3
     int row2; //which row the element ends | 0-3
     int column2; //which column the element ends | 0-3
-    uint8_t ui_state; //state describing how the element is displayed, dependend on the sensor_data_type
+    uint8_t ui_state; //state describing how the element is displayed: 1 value (look dependend on the sensor_data_type), 2 trend chart
     bool timeout_flag;
 } gui_element_container_t; //describes the GUI element that a single sensor/device combination occupies
 
@@ -57,4 +63,15 @@ void enqueue_sensor_data_into_buffer(sensor_data_t* data);
 //prints the gui element to the terminal
 void print_gui_element(gui_element_container_t* gui_element);
 
+//sets up colors, font and status bar of the display, called by gui_worker()
+void init_gui(gui_element_container_t* sensor_gui_elements[GUI_ELEMENT_CONTAINER_SIZE]);
+//adds an element for a new sensor in the first free grid cell, returns false if there is none
+bool add_gui_element(gui_element_container_t* sensor_gui_elements[GUI_ELEMENT_CONTAINER_SIZE], uint8_t* sensor_gui_elements_count, sensor_data_t* sensor_element);
+//queues a new fixed point value of an element and updates its minimum and maximum
+void update_sensor_data(gui_element_container_t* gui_element, int32_t sensor_data);
+//redraws an element with its newest value (real_update) or marks it as outdated
+void update_gui_element(gui_element_container_t* gui_element, bool real_update);
+//switches an element between showing its newest value and a trend chart
+void toggle_gui_element(gui_element_container_t* gui_element);
+
 #endif /* GUI_H_ */
\ No newline at end of file
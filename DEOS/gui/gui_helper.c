@@ -14,7 +14,7 @@ bool queue_is_empty(const data_queue_t* queue)
 }
 
 // Add a new element to the Queue
-void queue_push(data_queue_t* queue, sensor_parameter_t value)
+void queue_push(data_queue_t* queue, int32_t value)
 {
 
     queue->data[queue->head] = value;
@@ -38,7 +38,7 @@ void queue_init(data_queue_t* queue)
     queue->count = 0;
 }
 
-bool queue_peek_element(const data_queue_t* queue, sensor_parameter_t* data, int pos)
+bool queue_peek_element(const data_queue_t* queue, int32_t* data, int pos)
 {
     if (pos < 0 || pos >= queue->count) {
         return false;
@@ -49,7 +49,7 @@ bool queue_peek_element(const data_queue_t* queue, sensor_parameter_t* data, int
     return true;
 }
 
-bool queue_peek_oldest_data(data_queue_t* queue, sensor_parameter_t* value)
+bool queue_peek_oldest_data(data_queue_t* queue, int32_t* value)
 {
     if (queue_is_empty(queue))
     {
@@ -60,7 +60,7 @@ bool queue_peek_oldest_data(data_queue_t* queue, sensor_parameter_t* value)
 }
 
 
-bool queue_peek_newest_data(data_queue_t* queue, sensor_parameter_t* value)
+bool queue_peek_newest_data(data_queue_t* queue, int32_t* value)
 {
     if (queue_is_empty(queue))
     {
@@ -69,110 +69,3 @@ bool queue_peek_newest_data(data_queue_t* queue, sensor_parameter_t* value)
     *value = queue->data[(queue->head + QUEUE_SIZE - 1) % QUEUE_SIZE];
     return true;
 }
-
-bool sensor_value_is_smaller(sensor_parameter_t* value1, sensor_parameter_t* value2, sensor_parameter_type_t sensor_data_type)
-{
-    switch (sensor_data_type)
-    {
-
-        case PARAM_TEMPERATURE_CELSIUS:
-        {
-            return value1->fValue < value2->fValue;
-        }
-        break;
-        case PARAM_HUMIDITY_PERCENT:
-        {
-            return value1->uValue < value2->uValue;
-        }
-        break;
-        case PARAM_LIGHT_INTENSITY_PERCENT:
-        {
-            return value1->fValue < value2->fValue;
-        }
-        break;
-        case PARAM_ALTITUDE_M:
-        {
-            return value1->uValue < value2->uValue;
-        }
-        break;
-        case PARAM_PRESSURE_PASCAL:
-        {
-            return value1->fValue < value2->fValue;
-        }
-        break;
-        case PARAM_E_CO2_PPM:
-        {
-            return value1->uValue < value2->uValue;
-        }
-        break;
-        case PARAM_TVOC_PPB:
-        {
-            return value1->uValue < value2->uValue;
-        }
-        break;
-        case PARAM_CO2_PPM:
-        {
-            return value1->uValue < value2->uValue;
-        }
-        break;
-
-        default:
-            break;
-    }
-    printf_P("ERROR: sensor_value_is_smaller: Unknown sensor data type\n");
-    return false;
-}
-
-
-bool sensor_value_is_greater(sensor_parameter_t* value1, sensor_parameter_t* value2, sensor_parameter_type_t sensor_data_type)
-{
-    switch (sensor_data_type)
-    {
-
-        case PARAM_TEMPERATURE_CELSIUS:
-        {
-            return value1->fValue > value2->fValue;
-        }
-        break;
-        case PARAM_HUMIDITY_PERCENT:
-        {
-            return value1->uValue > value2->uValue;
-        }
-        break;
-        case PARAM_LIGHT_INTENSITY_PERCENT:
-        {
-            return value1->fValue > value2->fValue;
-        }
-        break;
-        case PARAM_ALTITUDE_M:
-        {
-            return value1->uValue > value2->uValue;
-        }
-        break;
-        case PARAM_PRESSURE_PASCAL:
-        {
-            return value1->fValue > value2->fValue;
-        }
-        break;
-        case PARAM_E_CO2_PPM:
-        {
-            return value1->uValue > value2->uValue;
-        }
-        break;
-        case PARAM_TVOC_PPB:
-        {
-            return value1->uValue > value2->uValue;
-        }
-        break;
-        case PARAM_CO2_PPM:
-        {
-            return value1->uValue > value2->uValue;
-        }
-        break;
-
-        default:
-            break;
-    }
-    printf_P("sensor_value_is_greater: Unknown sensor data type\n");
-    return false;
-}
\ No newline at end of file
@@ -18,7 +18,7 @@
 
 typedef struct
 {
-    sensor_parameter_t data[QUEUE_SIZE];
+    int32_t data[QUEUE_SIZE]; //fixed point values, see sensorData_getDecimals()
     int head;
     int tail;
     int count;
@@ -30,18 +30,15 @@ void queue_init(data_queue_t* queue);
 bool queue_is_empty(const data_queue_t* queue);
 
 // Add a new element to the Queue
-void queue_push(data_queue_t* queue, sensor_parameter_t value);
+void queue_push(data_queue_t* queue, int32_t value);
 
 // peek the oldest element and remove it
-sensor_parameter_t queue_pop(data_queue_t* queue);
+int32_t queue_pop(data_queue_t* queue);
 
-bool queue_peek_element(const data_queue_t* queue, sensor_parameter_t* data, int pos);
+bool queue_peek_element(const data_queue_t* queue, int32_t* data, int pos);
 
-bool queue_peek_oldest_data(data_queue_t* queue, sensor_parameter_t* value);
-bool queue_peek_newest_data(data_queue_t* queue, sensor_parameter_t* value);
-
-bool sensor_value_is_smaller(sensor_parameter_t* value1, sensor_parameter_t* value2, sensor_parameter_type_t sensor_data_type);
-bool sensor_value_is_greater(sensor_parameter_t* value1, sensor_parameter_t* value2, sensor_parameter_type_t sensor_data_type);
+bool queue_peek_oldest_data(data_queue_t* queue, int32_t* value);
+bool queue_peek_newest_data(data_queue_t* queue, int32_t* value);
 
 
 #endif /* GUI_HELPER_H_ */
\ No newline at end of file
@@ -0,0 +1,291 @@
+/*! \file
+ *  \brief Interrupt driven TWI (I2C) master with a queue of transactions.
+ *
+ *  \author   Fachbereich 5 - FH Aachen
+ *  \date     2024
+ *  \version  1.0
+ */
+
+#include "twi.h"
+#include "../os_scheduler.h"
+
+#include <avr/interrupt.h>
+#include <avr/io.h>
+#include <stddef.h>
+#include <util/twi.h>
+
+//! TWCR to continue with the next step, the interrupt stays enabled
+#define TWI_CONTINUE ((1 << TWEN) | (1 << TWIE) | (1 << TWINT))
+
+//----------------------------------------------------------------------------
+// Globals
+//----------------------------------------------------------------------------
+
+//! Queued transactions, the first one is on the bus
+static twi_transaction_t *twi_queue[TWI_QUEUE_SIZE];
+
+//! Index of the transaction on the bus
+static uint8_t twi_queueHead;
+
+//! Number of queued transactions
+static volatile uint8_t twi_queueCount;
+
+//! Processes waiting for a transaction to complete
+static wait_queue_t twi_waitQueue;
+
+//----------------------------------------------------------------------------
+// Private functions
+//----------------------------------------------------------------------------
+
+/*!
+ *  Sends the start condition of the first queued transaction. Waits for a
+ *  stop condition that is still being sent, as TWSTA would be ignored then.
+ *  Must be called with interrupts disabled.
+ */
+static void twi_startNext(void)
+{
+	twi_queue[twi_queueHead]->index = 0;
+	while (TWCR & (1 << TWSTO));
+	TWCR = TWI_CONTINUE | (1 << TWSTA);
+}
+
+/*!
+ *  Completes the transaction on the bus, wakes the waiting processes and
+ *  releases the bus or passes it on to the next transaction.
+ *  Called from the ISR.
+ *
+ *  \param status Result of the transaction
+ *  \param stop True to send a stop condition, false if the bus is already released
+ */
+static void twi_complete(twi_status_t status, bool stop)
+{
+	twi_transaction_t *transaction = twi_queue[twi_queueHead];
+
+	twi_queueHead = (twi_queueHead + 1) % TWI_QUEUE_SIZE;
+	twi_queueCount--;
+
+	transaction->status = status;
+	if (transaction->callback != NULL)
+	{
+		transaction->callback(transaction);
+	}
+	os_signal(&twi_waitQueue);
+
+	if (twi_queueCount > 0)
+	{
+		// With TWSTA and TWSTO both set, the TWI sends a stop and then a start
+		twi_queue[twi_queueHead]->index = 0;
+		TWCR = TWI_CONTINUE | (1 << TWSTA) | (stop ? (1 << TWSTO) : 0);
+	}
+	else
+	{
+		TWCR = TWI_CONTINUE | (stop ? (1 << TWSTO) : 0);
+	}
+}
+
+/*!
+ *  Acknowledges the next byte only if more bytes are to be read, so the
+ *  device stops sending after the last one
+ *
+ *  \param transaction The transaction on the bus
+ */
+static void twi_receiveNext(twi_transaction_t *transaction)
+{
+	if (transaction->index + 1 < transaction->readLength)
+	{
+		TWCR = TWI_CONTINUE | (1 << TWEA);
+	}
+	else
+	{
+		TWCR = TWI_CONTINUE;
+	}
+}
+
+//----------------------------------------------------------------------------
+// Interrupt
+//----------------------------------------------------------------------------
+
+/*!
+ *  Runs the next step of the transaction on the bus, depending on the
+ *  status the TWI reports after every start condition and byte.
+ */
+ISR(TWI_vect)
+{
+	// A bus error while idle has no transaction to complete, a stop releases the TWI
+	if (twi_queueCount == 0)
+	{
+		TWCR = TWI_CONTINUE | (1 << TWSTO);
+		return;
+	}
+
+	twi_transaction_t *transaction = twi_queue[twi_queueHead];
+
+	switch (TW_STATUS)
+	{
+	case TW_START:
+		// Only reading transactions skip the write part
+		TWDR = (transaction->address << 1) | (transaction->writeLength > 0 || transaction->readLength == 0 ? TW_WRITE : TW_READ);
+		TWCR = TWI_CONTINUE;
+		break;
+
+	case TW_REP_START:
+		transaction->index = 0;
+		TWDR = (transaction->address << 1) | TW_READ;
+		TWCR = TWI_CONTINUE;
+		break;
+
+	case TW_MT_SLA_ACK:
+	case TW_MT_DATA_ACK:
+		if (transaction->index < transaction->writeLength)
+		{
+			TWDR = transaction->writeData[transaction->index++];
+			TWCR = TWI_CONTINUE;
+		}
+		else if (transaction->readLength > 0)
+		{
+			TWCR = TWI_CONTINUE | (1 << TWSTA);
+		}
+		else
+		{
+			twi_complete(TWI_DONE, true);
+		}
+		break;
+
+	case TW_MT_SLA_NACK:
+	case TW_MR_SLA_NACK:
+		twi_complete(TWI_NACK_ADDRESS, true);
+		break;
+
+	case TW_MT_DATA_NACK:
+		twi_complete(TWI_NACK_DATA, true);
+		break;
+
+	case TW_MR_SLA_ACK:
+		twi_receiveNext(transaction);
+		break;
+
+	case TW_MR_DATA_ACK:
+		transaction->readData[transaction->index++] = TWDR;
+		twi_receiveNext(transaction);
+		break;
+
+	case TW_MR_DATA_NACK:
+		transaction->readData[transaction->index++] = TWDR;
+		twi_complete(TWI_DONE, true);
+		break;
+
+	case TW_MT_ARB_LOST:
+		// The bus already belongs to the other master, so no stop condition
+		twi_complete(TWI_ARBITRATION_LOST, false);
+		break;
+
+	default:
+		// TW_BUS_ERROR, a stop resets the TWI without touching the bus
+		twi_complete(TWI_BUS_ERROR, true);
+		break;
+	}
+}
+
+//----------------------------------------------------------------------------
+// Public functions
+//----------------------------------------------------------------------------
+
+/*!
+ *  Initializes the TWI hardware. SCL and SDA need external pull-up resistors.
+ */
+void twi_init(void)
+{
+	TWSR = 0;                                  // No prescaler
+	TWBR = ((F_CPU / TWI_SCL_CLOCK) - 16) / 2; // Must be > 10 for stable operation
+	TWCR = (1 << TWEN) | (1 << TWIE);
+}
+
+/*!
+ *  Queues a transaction and starts it if the bus is idle. The transaction
+ *  must not be changed until it completed.
+ *
+ *  \param transaction The transaction, the fields up to callback must be set
+ *  \return False if the queue is full, the transaction is not queued then
+ */
+bool twi_submit(twi_transaction_t *transaction)
+{
+	uint8_t sreg = SREG;
+	cli();
+
+	bool const queued = twi_queueCount < TWI_QUEUE_SIZE;
+	if (queued)
+	{
+		transaction->status = TWI_PENDING;
+		twi_queue[(twi_queueHead + twi_queueCount) % TWI_QUEUE_SIZE] = transaction;
+		if (twi_queueCount++ == 0)
+		{
+			twi_startNext();
+		}
+	}
+
+	SREG = sreg;
+	return queued;
+}
+
+/*!
+ *  Checks whether a transaction completed
+ *
+ *  \param transaction A submitted transaction
+ *  \return True if the status of the transaction is final
+ */
+bool twi_isDone(const twi_transaction_t *transaction)
+{
+	return transaction->status != TWI_PENDING;
+}
+
+/*!
+ *  Blocks until a transaction completed, other processes run meanwhile
+ *
+ *  \param transaction A submitted transaction
+ *  \return The status of the transaction
+ */
+twi_status_t twi_wait(const twi_transaction_t *transaction)
+{
+	cli();
+	while (!twi_isDone(transaction))
+	{
+		os_waitOn(&twi_waitQueue);
+		cli();
+	}
+	sei();
+
+	return transaction->status;
+}
+
+/*!
+ *  Writes and then reads bytes of a device. Waits for a free place in the
+ *  queue and for the completion of the transfer.
+ *
+ *  \param address 7 bit address of the device
+ *  \param writeData Bytes sent first
+ *  \param writeLength Number of bytes to send, 0 to only read
+ *  \param readData Receives the bytes read afterwards
+ *  \param readLength Number of bytes to read, 0 to only write
+ *  \return The status of the transfer
+ */
+twi_status_t twi_transfer(uint8_t address, const uint8_t *writeData, uint8_t writeLength, uint8_t *readData, uint8_t readLength)
+{
+	twi_transaction_t transaction = {
+		.address = address,
+		.writeData = writeData,
+		.writeLength = writeLength,
+		.readData = readData,
+		.readLength = readLength,
+		.callback = NULL,
+	};
+
+	cli();
+	while (!twi_submit(&transaction))
+	{
+		os_waitOn(&twi_waitQueue);
+		cli();
+	}
+	sei();
+
+	return twi_wait(&transaction);
+}
@@ -0,0 +1,75 @@
+/*! \file
+ *  \brief Interrupt driven TWI (I2C) master with a queue of transactions.
+ *
+ *  A transaction writes some bytes to a device and then reads some bytes
+ *  back after a repeated start, either part may be empty. Transactions are
+ *  queued with twi_submit() and processed one after the other by the TWI
+ *  interrupt, so the submitting process can compute or wait with
+ *  twi_wait() while the bus is busy. The transaction and its buffers are
+ *  owned by the caller and must stay valid until it completed.
+ *
+ *  Do not mix this driver with the polled one in i2cmaster.h, both use the
+ *  same TWI hardware.
+ *
+ *  \author   Fachbereich 5 - FH Aachen
+ *  \date     2024
+ *  \version  1.0
+ */
+
+#ifndef TWI_H_
+#define TWI_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+//! Clock of SCL in Hz
+#define TWI_SCL_CLOCK 100000UL
+
+//! Number of transactions that can be queued, including the one on the bus
+#define TWI_QUEUE_SIZE 4
+
+//! State of a transaction
+typedef enum TwiStatus
+{
+	TWI_PENDING,          //!< Queued or on the bus
+	TWI_DONE,             //!< All bytes were written and read
+	TWI_NACK_ADDRESS,     //!< No device answered to the address
+	TWI_NACK_DATA,        //!< The device did not acknowledge a written byte
+	TWI_ARBITRATION_LOST, //!< Another master took the bus
+	TWI_BUS_ERROR,        //!< Illegal start or stop condition on the bus
+} twi_status_t;
+
+typedef struct TwiTransaction twi_transaction_t;
+
+//! Called from the TWI interrupt when a transaction completed, must be short
+typedef void (*twi_callback_t)(twi_transaction_t *transaction);
+
+//! Transfer with a device, status and index are set by the driver
+struct TwiTransaction
+{
+	uint8_t address;              //!< 7 bit address of the device
+	const uint8_t *writeData;     //!< Bytes sent first
+	uint8_t writeLength;          //!< Number of bytes to send, 0 to only read
+	uint8_t *readData;            //!< Receives the bytes read afterwards
+	uint8_t readLength;           //!< Number of bytes to read, 0 to only write
+	twi_callback_t callback;      //!< Called on completion, may be NULL
+	volatile twi_status_t status; //!< Result, TWI_PENDING until completed
+	uint8_t index;                //!< Next byte to write or read
+};
+
+//! Initializes the TWI hardware, must be called before the first transaction
+void twi_init(void);
+
+//! Queues a transaction, returns false if the queue is full
+bool twi_submit(twi_transaction_t *transaction);
+
+//! Checks whether a transaction completed
+bool twi_isDone(const twi_transaction_t *transaction);
+
+//! Blocks until a transaction completed and returns its status, other processes run meanwhile
+twi_status_t twi_wait(const twi_transaction_t *transaction);
+
+//! Writes and then reads bytes of a device, blocks until the transfer completed
+twi_status_t twi_transfer(uint8_t address, const uint8_t *writeData, uint8_t writeLength, uint8_t *readData, uint8_t readLength);
+
+#endif /* TWI_H_ */
@@ -1,36 +1,50 @@
 /*! \file
- *  \brief Handles button presses and releases (pin change interrupt).
+ *  \brief Handles button presses and releases (ADC conversion complete interrupt).
  *
  *  \author   Fachbereich 5 - FH Aachen
  *  \date     2024
  *  \version  1.0
  */
 #include "buttons.h"
+#include "../os_scheduler.h"
 #include "util.h"
 
+#include <avr/interrupt.h>
 #include <avr/io.h>
 #include <stdbool.h>
 
+//! Debounced button that is currently pressed
+static volatile button_t buttons_state = BTN_NONE;
+
+//! Button the latest samples showed, it replaces buttons_state once it was sampled often enough
+static button_t buttons_candidate = BTN_NONE;
+
+//! Number of consecutive samples of buttons_candidate
+static uint8_t buttons_samples;
+
+//! Queued press and release events
+static button_event_t buttons_events[BUTTONS_EVENT_QUEUE_SIZE];
+
+//! Index of the oldest event
+static uint8_t buttons_eventHead;
+
+//! Number of queued events
+static volatile uint8_t buttons_eventCount;
+
+//! Number of events dropped because the queue was full
+static uint16_t buttons_droppedCount;
+
+//! Processes waiting for a change of the pressed button
+static wait_queue_t buttons_waitQueue;
+
 /*!
- *  Read the button that is currently pressed
+ *  Returns the button of a value of the resistor ladder
  *
- *  \return the button that is currently pressed
+ *  \param value The 10 bit value of ADC0
+ *  \return The button
  */
-button_t buttons_read()
+static button_t buttons_classify(uint16_t value)
 {
-	uint16_t value;
-	
-	// Pin ADC0 (PF0) must be configured as input
-	cbi(DDRF, PF0);
-	
-	// Read the value from the ADC
-	ADMUX = (1 << REFS0);												// Select Vref=AVcc and select ADC0 (default is ADC0 when ADMUX lower bits are 0000)
-	ADCSRA = (1 << ADEN) | (1 << ADPS2) | (1 << ADPS1) | (1 << ADPS0);	// Enable ADC and set prescaler to 128
-	ADCSRA |= (1 << ADSC);												// Start conversion
-	while (ADCSRA & (1 << ADSC));										// Wait until conversion is complete
-	value = ADC;														// ADC is a 10-bit register, so you get a value between 0 and 1023
-
-	// Return the button that was pressed
 	if (value < 66)
 		return BTN_RIGHT;
 	else if (value < 219)
@@ -45,6 +59,91 @@ button_t buttons_read()
 		return BTN_NONE;
 }
 
+/*!
+ *  Queues an event, called from the ISR
+ *
+ *  \param button The button
+ *  \param pressed True for a press, false for a release
+ */
+static void buttons_pushEvent(button_t button, bool pressed)
+{
+	if (buttons_eventCount == BUTTONS_EVENT_QUEUE_SIZE)
+	{
+		buttons_droppedCount++;
+		return;
+	}
+
+	button_event_t *event = &buttons_events[(buttons_eventHead + buttons_eventCount) % BUTTONS_EVENT_QUEUE_SIZE];
+	event->button = button;
+	event->pressed = pressed;
+	buttons_eventCount++;
+}
+
+/*!
+ *  ISR that debounces every conversion of ADC0. A different button only
+ *  counts once BUTTONS_DEBOUNCE_SAMPLES consecutive samples showed it,
+ *  then its release and press events are queued and waiting processes
+ *  are woken.
+ */
+ISR(ADC_vect)
+{
+	button_t const sample = buttons_classify(ADC);
+
+	if (sample == buttons_state)
+	{
+		buttons_samples = 0;
+		return;
+	}
+	if (sample != buttons_candidate)
+	{
+		buttons_candidate = sample;
+		buttons_samples = 1;
+		return;
+	}
+	if (++buttons_samples < BUTTONS_DEBOUNCE_SAMPLES)
+	{
+		return;
+	}
+
+	if (buttons_state != BTN_NONE)
+	{
+		buttons_pushEvent(buttons_state, false);
+	}
+	if (sample != BTN_NONE)
+	{
+		buttons_pushEvent(sample, true);
+	}
+	buttons_state = sample;
+	buttons_samples = 0;
+	os_signal(&buttons_waitQueue);
+}
+
+/*!
+ *  Starts sampling the buttons. The compare match of timer 0, which
+ *  counts the system time, triggers a conversion of ADC0 every
+ *  millisecond, so no CPU time is spent before the conversion is done.
+ */
+void buttons_init(void)
+{
+	// Pin ADC0 (PF0) must be configured as input
+	cbi(DDRF, PF0);
+	cbi(PORTF, PF0);
+
+	ADMUX = (1 << REFS0);								 // Select Vref=AVcc and select ADC0 (default is ADC0 when ADMUX lower bits are 0000)
+	ADCSRB = (ADCSRB & ~((1 << ADTS2) | (1 << ADTS1) | (1 << ADTS0))) | (1 << ADTS1) | (1 << ADTS0); // Auto trigger on timer 0 compare match A
+	ADCSRA = (1 << ADEN) | (1 << ADATE) | (1 << ADIE) | (1 << ADPS2) | (1 << ADPS1) | (1 << ADPS0); // Enable ADC with interrupt and auto trigger, prescaler 128
+}
+
+/*!
+ *  Read the button that is currently pressed
+ *
+ *  \return the debounced button that is currently pressed
+ */
+button_t buttons_read()
+{
+	return buttons_state;
+}
+
 /*!
  *  Check if button got pressed.
  *
@@ -68,20 +167,83 @@ bool buttons_released(button_t button)
 }
 
 /*!
- *  Blocks until button got pressed
+ *  Blocks until button got pressed, other processes run meanwhile
  *	\param button button to wait for
  */
 void buttons_waitForPressed(button_t button)
 {
-	while (!buttons_pressed(button));
+	cli();
+	while (!buttons_pressed(button))
+	{
+		os_waitOn(&buttons_waitQueue);
+		cli();
+	}
+	sei();
 }
 
 /*!
- *  Blocks until button got released
+ *  Blocks until button got released, other processes run meanwhile
  *
  * \param button button to wait for
  */
 void buttons_waitForReleased(button_t button)
 {
-	while (!buttons_released(button));
-}
\ No newline at end of file
+	cli();
+	while (!buttons_released(button))
+	{
+		os_waitOn(&buttons_waitQueue);
+		cli();
+	}
+	sei();
+}
+
+/*!
+ *  Takes the oldest press or release event from the queue
+ *
+ *  \param event Receives the event
+ *  \return False if no event is queued, event stays unchanged then
+ */
+bool buttons_popEvent(button_event_t *event)
+{
+	uint8_t sreg = SREG;
+	cli();
+
+	bool const queued = buttons_eventCount > 0;
+	if (queued)
+	{
+		*event = buttons_events[buttons_eventHead];
+		buttons_eventHead = (buttons_eventHead + 1) % BUTTONS_EVENT_QUEUE_SIZE;
+		buttons_eventCount--;
+	}
+
+	SREG = sreg;
+	return queued;
+}
+
+/*!
+ *  Blocks until a press or release event is queued and takes it
+ *
+ *  \param event Receives the event
+ */
+void buttons_waitForEvent(button_event_t *event)
+{
+	cli();
+	while (buttons_eventCount == 0)
+	{
+		os_waitOn(&buttons_waitQueue);
+		cli();
+	}
+	sei();
+
+	buttons_popEvent(event);
+}
+
+/*!
+ *  Returns the number of events dropped because the queue was full
+ *
+ *  \return The number of dropped events
+ */
+uint16_t buttons_getDroppedCount(void)
+{
+	return buttons_droppedCount;
+}
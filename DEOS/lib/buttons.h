@@ -1,5 +1,10 @@
 /*! \file
- *  \brief Handles button presses and releases (pin change interrupt).
+ *  \brief Handles button presses and releases (ADC conversion complete interrupt).
+ *
+ *  The buttons form a resistor ladder on ADC0. Timer 0 triggers a
+ *  conversion every millisecond in hardware, the ADC interrupt classifies
+ *  the value, debounces it and queues press and release events. While the
+ *  pressed button does not change, the interrupt returns right away.
  *
  *  \author   Fachbereich 5 - FH Aachen
  *  \date     2024
@@ -9,6 +14,13 @@
 #define _BUTTONS_H_
 
 #include <stdbool.h>
+#include <stdint.h>
+
+//! Number of consecutive samples (one per ms) a new button value has to stay the same to count
+#define BUTTONS_DEBOUNCE_SAMPLES 20
+
+//! Number of press and release events that can be queued, further events are dropped
+#define BUTTONS_EVENT_QUEUE_SIZE 8
 
 typedef enum Button
 {
@@ -20,7 +32,17 @@ typedef enum Button
 	BTN_NONE
 } button_t;
 
-//! Read the button that is currently pressed
+//! Press or release of a button
+typedef struct ButtonEvent
+{
+	button_t button;
+	bool pressed; //!< True if the button was pressed, false if it was released
+} button_event_t;
+
+//! Starts sampling the buttons, must be called after initSystemTime() as timer 0 triggers the conversions
+void buttons_init(void);
+
+//! Read the debounced button that is currently pressed
 button_t buttons_read();
 
 //* Check if button got pressed.
@@ -35,4 +57,13 @@ void buttons_waitForPressed(button_t button);
 //! Blocks until button got released
 void buttons_waitForReleased(button_t button);
 
-#endif
\ No newline at end of file
+//! Takes the oldest event from the queue, returns false if there is none
+bool buttons_popEvent(button_event_t *event);
+
+//! Blocks until there is an event and takes it from the queue
+void buttons_waitForEvent(button_event_t *event);
+
+//! Returns the number of events dropped because the queue was full
+uint16_t buttons_getDroppedCount(void);
+
+#endif
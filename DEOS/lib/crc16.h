@@ -0,0 +1,33 @@
+/*! \file
+ *  \brief CRC-16/CCITT checksums.
+ *
+ *  CRC-16/CCITT-FALSE (polynomial 0x1021, initial value 0xFFFF, no reflection,
+ *  no final XOR). The checksum can be calculated incrementally, i.e. the
+ *  result of one call is passed as crc to the next call.
+ *
+ *  \author   Fachbereich 5 - FH Aachen
+ *  \date     2024
+ *  \version  1.0
+ */
+
+#ifndef _CRC16_H
+#define _CRC16_H
+
+#include <stdint.h>
+
+//! Type of a CRC-16 checksum
+typedef uint16_t crc16_t;
+
+//! Initial value of a CRC-16/CCITT calculation
+#define CRC16_INITIAL_VALUE ((crc16_t)0xFFFF)
+
+//! Adds one byte to the checksum using the lookup table in program memory
+crc16_t crc16_update(crc16_t crc, uint8_t data);
+
+//! Adds one byte to the checksum bit by bit (slower, no table needed)
+crc16_t crc16_updateBitwise(crc16_t crc, uint8_t data);
+
+//! Adds a buffer to the checksum using the lookup table in program memory
+crc16_t crc16_calculate(crc16_t crc, void const *data, uint8_t length);
+
+#endif
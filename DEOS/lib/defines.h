@@ -13,6 +13,7 @@
 #define _DEFINES_H
 
 #include "atmega2560constants.h"
+#include "uart_config.h"
 
 //----------------------------------------------------------------------------
 // Programming reliefs
@@ -62,7 +63,12 @@
 //----------------------------------------------------------------------------
 
 //! Offset needed before the Stack starts, because global variables are put on the low addresses of the SRAM
-#define STACK_OFFSET 1400
+//! This also includes the memory pools (see os_mempool.h, MEMPOOL_TOTAL_SIZE) that are placed directly behind the global variables
+//! and the UART buffers, whose size depends on the chosen profile (see uart_config.h)
+//! and the block pool and rollups of the sensor history (see sensorHistory.h) and the sensor registry,
+//! as well as the rendered state of the GUI cells (see gui.c) and the touch buttons with their grid (see tlcd_button.h)
+//! and the frame buffer and command queue of the character LCD (see lcd.c), the button events (see buttons.c) and the TWI transaction queue (see twi.c)
+#define STACK_OFFSET (5305 + UART_BUFFER_TOTAL_SIZE)
 
 //! The stack size available for initialization and globals
 #define STACK_SIZE_MAIN 32
@@ -72,6 +78,9 @@
 //! The stack size of a process
 #define STACK_SIZE_PROC ((AVR_MEMORY_SRAM - STACK_OFFSET - STACK_SIZE_MAIN - STACK_SIZE_ISR) / MAX_NUMBER_OF_PROCESSES)
 
+//! The smallest stack size of a process that still leaves room for the saved context and nested calls with terminal output
+#define STACK_SIZE_PROC_MIN 256
+
 //! The bottom of the main stack. That is the highest address.
 #define BOTTOM_OF_MAIN_STACK (AVR_SRAM_LAST)
 //! The bottom of the scheduler-stack. That is the highest address.
@@ -85,4 +94,8 @@
 #error "Stack sizes exceed available SRAM"
 #endif
 
+#if STACK_SIZE_PROC < STACK_SIZE_PROC_MIN
+#error "Stack size of a process too small, shrink the UART profile or the buffers included in STACK_OFFSET"
+#endif
+
 #endif
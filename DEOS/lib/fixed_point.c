@@ -0,0 +1,126 @@
+/*!
+ *  \brief Formatting of fixed point numbers without the float support of printf.
+ *
+ *  \author   Fachbereich 5 - FH Aachen
+ *  \date     2024
+ *  \version  1.0
+ */
+
+#include "fixed_point.h"
+
+#include <string.h>
+
+/*!
+ *  Returns the factor between a value and its fixed point number
+ *
+ *  \param decimals Number of decimals, at most FIXED_POINT_MAX_DECIMALS
+ *  \return 10^decimals
+ */
+uint32_t fixedPoint_scale(uint8_t decimals)
+{
+    uint32_t scale = 1;
+    while (decimals-- > 0)
+    {
+        scale *= 10;
+    }
+    return scale;
+}
+
+/*!
+ *  Converts a float to a fixed point number
+ *
+ *  \param value The value
+ *  \param decimals Number of decimals that are kept
+ *  \return The value times 10^decimals, rounded half away from zero
+ */
+int32_t fixedPoint_fromFloat(float value, uint8_t decimals)
+{
+    float scaled = value * fixedPoint_scale(decimals);
+    return (int32_t)(scaled < 0 ? scaled - 0.5f : scaled + 0.5f);
+}
+
+/*!
+ *  Converts a fixed point number to a float
+ *
+ *  \param value The fixed point number
+ *  \param decimals Number of decimals of the number
+ *  \return The value
+ */
+float fixedPoint_toFloat(int32_t value, uint8_t decimals)
+{
+    return (float)value / fixedPoint_scale(decimals);
+}
+
+/*!
+ *  Writes a fixed point number as decimal string, e.g. 215 with one decimal
+ *  and suffix " *C" as "21.5 *C". Numbers below one get a leading zero,
+ *  "-0.5" for -5. The digits are produced with 32 bit divisions only while
+ *  the remaining value needs them, the rest uses the much cheaper 16 bit
+ *  division of the AVR.
+ *
+ *  \param buffer Receives the string, must hold the bigger of width and FIXED_POINT_MAX_LENGTH + strlen(suffix) plus the terminator
+ *  \param value The fixed point number
+ *  \param decimals Number of decimals of the number, at most FIXED_POINT_MAX_DECIMALS
+ *  \param width Minimum length, shorter strings are padded with spaces on the left. 0 for no padding
+ *  \param suffix Appended to the number, e.g. a unit. May be NULL
+ *  \return Length of the string without the terminator
+ */
+uint8_t fixedPoint_format(char* buffer, int32_t value, uint8_t decimals, uint8_t width, const char* suffix)
+{
+    char digits[FIXED_POINT_MAX_LENGTH]; // in reverse order
+    uint8_t count = 0;
+    uint32_t magnitude = value < 0 ? -(uint32_t)value : (uint32_t)value;
+
+    if (decimals > FIXED_POINT_MAX_DECIMALS)
+    {
+        decimals = FIXED_POINT_MAX_DECIMALS;
+    }
+
+    // one division per digit, the remainder is taken from the quotient
+    while (magnitude > UINT16_MAX)
+    {
+        uint32_t quotient = magnitude / 10;
+        digits[count++] = '0' + (uint8_t)(magnitude - quotient * 10);
+        magnitude = quotient;
+    }
+    uint16_t small = magnitude;
+    do
+    {
+        uint16_t quotient = small / 10;
+        digits[count++] = '0' + (uint8_t)(small - quotient * 10);
+        small = quotient;
+    } while (small != 0);
+
+    // leading zeros up to the one before the decimal point
+    while (count <= decimals)
+    {
+        digits[count++] = '0';
+    }
+
+    uint8_t suffixLength = suffix == NULL ? 0 : strlen(suffix);
+    uint8_t length = (value < 0) + count + (decimals > 0) + suffixLength;
+    uint8_t padding = width > length ? width - length : 0;
+
+    memset(buffer, ' ', padding);
+    char* position = buffer + padding;
+
+    if (value < 0)
+    {
+        *position++ = '-';
+    }
+    while (count > 0)
+    {
+        if (count == decimals)
+        {
+            *position++ = '.';
+        }
+        *position++ = digits[--count];
+    }
+    if (suffixLength > 0)
+    {
+        memcpy(position, suffix, suffixLength);
+    }
+    position[suffixLength] = '\0';
+
+    return padding + length;
+}
@@ -0,0 +1,37 @@
+/*!
+ *  \brief Formatting of fixed point numbers without the float support of printf.
+ *
+ *  A fixed point number is an int32_t holding the value multiplied by
+ *  10^decimals, e.g. 21.5 with one decimal is stored as 215. Formatting only
+ *  needs integer divisions, so the float version of vfprintf
+ *  (-Wl,-u,vfprintf -lprintf_flt) does not have to be linked.
+ *
+ *  \author   Fachbereich 5 - FH Aachen
+ *  \date     2024
+ *  \version  1.0
+ */
+
+#ifndef FIXED_POINT_H_
+#define FIXED_POINT_H_
+
+#include <stdint.h>
+
+//! Maximum number of decimals, 10^9 is the biggest power of ten that fits into an int32_t
+#define FIXED_POINT_MAX_DECIMALS 9
+
+//! Maximum length of a formatted number without suffix and padding: sign, 10 digits and the decimal point
+#define FIXED_POINT_MAX_LENGTH 12
+
+//! Returns 10^decimals, the factor between a value and its fixed point number
+uint32_t fixedPoint_scale(uint8_t decimals);
+
+//! Converts a float to a fixed point number, rounded half away from zero
+int32_t fixedPoint_fromFloat(float value, uint8_t decimals);
+
+//! Converts a fixed point number to a float
+float fixedPoint_toFloat(int32_t value, uint8_t decimals);
+
+//! Writes a fixed point number followed by a suffix, right aligned to a width, and returns the length
+uint8_t fixedPoint_format(char *buffer, int32_t value, uint8_t decimals, uint8_t width, const char *suffix);
+
+#endif /* FIXED_POINT_H_ */
@@ -1,14 +1,36 @@
 #include "lcd.h"
 #include "../os_scheduler.h"
+#include <avr/interrupt.h>
 #include <avr/pgmspace.h>
 #include <stdio.h>
+#include <string.h>
+
+//! Marks that the DDRAM address of the display is not known, so the next write has to set it
+#define LCD_ADDRESS_UNKNOWN 0xFF
+
+//! DDRAM address of a cell of the frame buffer
+#define LCD_ADDRESS(cell) ((cell) / LCD_COLS * 0x40 + (cell) % LCD_COLS)
+
+//! Ticks to wait after clear and home, which take 1.52ms instead of 37us
+#define LCD_LONG_COMMAND_TICKS (1600 / LCD_TICK_US)
+
+//! Steps of the transfer of a byte, one per timer tick
+typedef enum
+{
+	LCD_STEP_IDLE,        //!< The previous byte is executed, the next one may start
+	LCD_STEP_HIGH_NIBBLE, //!< EN is high with the high nibble on the data pins
+	LCD_STEP_LOW_NIBBLE,  //!< EN is high with the low nibble on the data pins
+	LCD_STEP_WAIT,        //!< A long command is executed
+} lcd_step_t;
+
+static void lcd_putChar(char character);
 
 //----------------------------------------------------------------------------
 // Configuration of stdio.h
 //----------------------------------------------------------------------------
 int lcd_stdioPutChar(char c, FILE *stream)
 {
-	lcd_writeChar(c);
+	lcd_putChar(c);
 	return 0;
 }
 
@@ -24,6 +46,7 @@ void lcd_printf_p(const char *fmt, ...)
 	vfprintf_P(&lcd_stdout, fmt, args);
 	stdout->flags &= ~__SPGM;
 	va_end(args);
+	lcd_flush();
 }
 
 FILE lcd_stdout = FDEV_SETUP_STREAM(lcd_stdioPutChar, NULL, _FDEV_SETUP_WRITE);
@@ -40,6 +63,46 @@ FILE lcd_stdout = FDEV_SETUP_STREAM(lcd_stdioPutChar, NULL, _FDEV_SETUP_WRITE);
  */
 uint8_t charCtr;
 
+//! Frame buffer with the characters as the processes wrote them, lcd_flush() sends them to the display
+static char lcd_buffer[LCD_ROWS * LCD_COLS];
+
+//! Characters as the display shows them
+static char lcd_shown[LCD_ROWS * LCD_COLS];
+
+//! DDRAM address the display writes the next character to or LCD_ADDRESS_UNKNOWN
+static uint8_t lcd_address;
+
+//! Whether the cursor is shown, lcd_flush() moves it to the write position then
+static bool lcd_cursorShown;
+
+//! Commands and raw characters waiting to be sent before the frame buffer
+static struct
+{
+	uint8_t byte;
+	bool data;
+} lcd_queue[LCD_QUEUE_SIZE];
+
+//! Index of the oldest entry of lcd_queue
+static uint8_t lcd_queueHead;
+
+//! Number of entries of lcd_queue
+static volatile uint8_t lcd_queueCount;
+
+//! Step of the byte that is being sent
+static lcd_step_t lcd_step = LCD_STEP_IDLE;
+
+//! The byte that is being sent
+static uint8_t lcd_byte;
+
+//! Whether lcd_byte is a character or a command
+static bool lcd_byteIsData;
+
+//! Ticks left in LCD_STEP_WAIT
+static uint8_t lcd_waitTicks;
+
+//! Cell of the frame buffer to compare first, the one after the last sent cell
+static uint8_t lcd_nextCell;
+
 /*!
  *  Send a pulse to the EN pin to latch data/command.
  */
@@ -54,13 +117,12 @@ static void lcd_enablePulse(void)
 }
 
 /*!
- *  Send a nibble (4 bits) to the LCD.
+ *  Put a nibble (4 bits) on the data pins without latching it.
  *
- *  \param nibble  The 4-bit data to send (lower nibble ignored)
+ *  \param nibble  The 4-bit data to put (upper nibble ignored)
  */
-static void lcd_sendNibble(uint8_t nibble)
+static void lcd_setNibble(uint8_t nibble)
 {
-	os_enterCriticalSection();
 	if (nibble & 0x01)
 		LCD_D4_HIGH();
 	else
@@ -77,11 +139,213 @@ static void lcd_sendNibble(uint8_t nibble)
 		LCD_D7_HIGH();
 	else
 		LCD_D7_LOW();
+}
 
+/*!
+ *  Send a nibble (4 bits) to the LCD and wait until it is executed.
+ *  Only used while initializing, afterwards the timer sends the nibbles.
+ *
+ *  \param nibble  The 4-bit data to send (upper nibble ignored)
+ */
+static void lcd_sendNibble(uint8_t nibble)
+{
+	os_enterCriticalSection();
+	lcd_setNibble(nibble);
 	lcd_enablePulse();
 	os_leaveCriticalSection();
 }
 
+/*!
+ *  Send a command while initializing and wait until it is executed.
+ *
+ *  \param cmd  The command byte to send
+ */
+static void lcd_sendInitCommand(uint8_t cmd)
+{
+	LCD_RS_LOW(); // Command mode
+	lcd_sendNibble(cmd >> 4);
+	lcd_sendNibble(cmd);
+	_delay_us(40); // Most commands take < 37µs
+}
+
+/*!
+ *  Chooses the next byte to send: queued commands and characters first,
+ *  then the cells of the frame buffer that differ from the display, then
+ *  the address of the shown cursor. The DDRAM address is only set if a
+ *  changed cell does not follow the previously written one, so a changed
+ *  run of characters costs one address command. Unchanged cells cost
+ *  nothing.
+ *
+ *  \param byte  Receives the byte
+ *  \return 0 if there is nothing to send, 1 for a command, 2 for a character
+ */
+static uint8_t lcd_nextByte(uint8_t *byte)
+{
+	if (lcd_queueCount > 0)
+	{
+		*byte = lcd_queue[lcd_queueHead].byte;
+		bool const data = lcd_queue[lcd_queueHead].data;
+		lcd_queueHead = (lcd_queueHead + 1) % LCD_QUEUE_SIZE;
+		lcd_queueCount--;
+
+		// Entry mode, display control and function set keep the address, anything else may move it
+		if (data && lcd_address != LCD_ADDRESS_UNKNOWN)
+		{
+			lcd_address++;
+		}
+		else if (!data && (*byte < LCD_CMD_ENTRY_MODE_SET || (*byte >= LCD_CMD_CURSOR_SHIFT && *byte < LCD_CMD_FUNCTION_SET) || *byte >= LCD_CMD_SET_CGRAM_ADDR))
+		{
+			lcd_address = LCD_ADDRESS_UNKNOWN;
+		}
+		return data ? 2 : 1;
+	}
+
+	for (uint8_t i = 0; i < LCD_ROWS * LCD_COLS; i++)
+	{
+		uint8_t const cell = (lcd_nextCell + i) % (LCD_ROWS * LCD_COLS);
+		if (lcd_buffer[cell] == lcd_shown[cell])
+		{
+			continue;
+		}
+		if (lcd_address != LCD_ADDRESS(cell))
+		{
+			lcd_address = LCD_ADDRESS(cell);
+			*byte = LCD_CMD_SET_DDRAM_ADDR | lcd_address;
+			return 1;
+		}
+		// A character written meanwhile differs from lcd_shown again and is sent later
+		*byte = lcd_shown[cell] = lcd_buffer[cell];
+		lcd_address++;
+		lcd_nextCell = cell + 1;
+		return 2;
+	}
+
+	// The cursor shows where the next character will be written
+	uint8_t const cursor = charCtr < LCD_ROWS * LCD_COLS ? charCtr : 0;
+	if (lcd_cursorShown && lcd_address != LCD_ADDRESS(cursor))
+	{
+		lcd_address = LCD_ADDRESS(cursor);
+		*byte = LCD_CMD_SET_DDRAM_ADDR | lcd_address;
+		return 1;
+	}
+	return 0;
+}
+
+/*!
+ *  Advances the transfer to the display by one step. A byte takes three
+ *  steps: raising EN with the high nibble, latching it and raising EN with
+ *  the low nibble, latching that. As steps are LCD_TICK_US apart, EN stays
+ *  high long enough and the next byte starts after the execution time.
+ *
+ *  \return False if there is nothing left to send
+ */
+static bool lcd_tick(void)
+{
+	switch (lcd_step)
+	{
+		case LCD_STEP_HIGH_NIBBLE:
+			LCD_EN_LOW();
+			lcd_setNibble(lcd_byte);
+			LCD_EN_HIGH();
+			lcd_step = LCD_STEP_LOW_NIBBLE;
+			return true;
+
+		case LCD_STEP_LOW_NIBBLE:
+			LCD_EN_LOW();
+			if (!lcd_byteIsData && lcd_byte < LCD_CMD_ENTRY_MODE_SET)
+			{
+				lcd_waitTicks = LCD_LONG_COMMAND_TICKS;
+				lcd_step = LCD_STEP_WAIT;
+			}
+			else
+			{
+				lcd_step = LCD_STEP_IDLE;
+			}
+			return true;
+
+		case LCD_STEP_WAIT:
+			if (--lcd_waitTicks == 0)
+			{
+				lcd_step = LCD_STEP_IDLE;
+			}
+			return true;
+
+		case LCD_STEP_IDLE:
+			break;
+	}
+
+	uint8_t const kind = lcd_nextByte(&lcd_byte);
+	if (kind == 0)
+	{
+		return false;
+	}
+
+	lcd_byteIsData = kind == 2;
+	if (lcd_byteIsData)
+		LCD_RS_HIGH(); // Data mode
+	else
+		LCD_RS_LOW(); // Command mode
+	lcd_setNibble(lcd_byte >> 4);
+	LCD_EN_HIGH();
+	lcd_step = LCD_STEP_HIGH_NIBBLE;
+	return true;
+}
+
+/*!
+ *  ISR that sends the next step to the display, it disables itself once
+ *  the display shows the frame buffer and the queue is empty
+ */
+ISR(TIMER3_COMPA_vect)
+{
+	if (!lcd_tick())
+	{
+		cbi(TIMSK3, OCIE3A);
+	}
+}
+
+/*!
+ *  Starts the transfer of what the display does not show yet. With
+ *  interrupts disabled (while booting or after an error) the timer cannot
+ *  do that, so the transfer is done right away, waiting for every step.
+ */
+static void lcd_startTransfer(void)
+{
+	if (gbi(SREG, 7))
+	{
+		sbi(TIMSK3, OCIE3A);
+		return;
+	}
+
+	while (lcd_tick())
+	{
+		_delay_us(LCD_TICK_US);
+	}
+}
+
+/*!
+ *  Queues a byte that is sent before the frame buffer.
+ *
+ *  \param byte  The byte
+ *  \param data  True for a character, false for a command
+ */
+static void lcd_enqueue(uint8_t byte, bool data)
+{
+	while (lcd_queueCount == LCD_QUEUE_SIZE)
+	{
+		lcd_startTransfer(); // The timer empties the queue
+	}
+
+	uint8_t sreg = SREG;
+	cli();
+	uint8_t const tail = (lcd_queueHead + lcd_queueCount) % LCD_QUEUE_SIZE;
+	lcd_queue[tail].byte = byte;
+	lcd_queue[tail].data = data;
+	lcd_queueCount++;
+	SREG = sreg;
+
+	lcd_startTransfer();
+}
+
 /*!
  *  Initialize the LCD in 4-bit mode.
  */
@@ -111,25 +375,66 @@ void lcd_init(void)
 
 	lcd_sendNibble(0x02); // Function set: 4-bit mode
 
-	lcd_sendCommand(LCD_CMD_FUNCTION_SET | LCD_4BIT_MODE | LCD_2LINE | LCD_5x8DOTS);
-	lcd_sendCommand((LCD_CMD_DISPLAY_CONTROL | LCD_DISPLAY_ON) & ~LCD_CURSOR_ON & ~LCD_BLINK_ON);
-	lcd_sendCommand(LCD_CMD_CLEAR_DISPLAY);
-	lcd_sendCommand(LCD_CMD_ENTRY_MODE_SET | 0x02); // Increment cursor, no display shift
+	lcd_sendInitCommand(LCD_CMD_FUNCTION_SET | LCD_4BIT_MODE | LCD_2LINE | LCD_5x8DOTS);
+	lcd_sendInitCommand((LCD_CMD_DISPLAY_CONTROL | LCD_DISPLAY_ON) & ~LCD_CURSOR_ON & ~LCD_BLINK_ON);
+	lcd_sendInitCommand(LCD_CMD_CLEAR_DISPLAY);
+	_delay_ms(2); // Clearing the display requires a delay
+	lcd_sendInitCommand(LCD_CMD_ENTRY_MODE_SET | 0x02); // Increment cursor, no display shift
 
 	_delay_ms(5);
+
+	// Timer 3 ticks every LCD_TICK_US in CTC mode, its interrupt is only enabled while there is something to send
+	TCCR3A = 0x00;
+	TCCR3B = (1 << WGM32) | (1 << CS31); // /8 prescaler
+	OCR3A = (F_CPU / 8 / 1000000UL) * LCD_TICK_US - 1;
+	cbi(TIMSK3, OCIE3A);
+	lcd_step = LCD_STEP_IDLE;
+	lcd_queueCount = 0;
+
+	// The cleared display shows spaces and writes to address 0 next
+	memset(lcd_buffer, ' ', sizeof(lcd_buffer));
+	memset(lcd_shown, ' ', sizeof(lcd_shown));
+	lcd_address = 0;
+	lcd_cursorShown = false;
+	charCtr = 0;
 	os_leaveCriticalSection();
 }
 
 /*!
- *  Clear the display and set the cursor to the home position.
+ *  Lets the display catch up with the frame buffer. Only the cells that
+ *  differ from the display are sent (see lcd_nextByte()), in the
+ *  background by the timer interrupt, so this returns right away.
+ */
+void lcd_flush(void)
+{
+	lcd_startTransfer();
+}
+
+/*!
+ *  Returns whether the display still has to catch up with the frame buffer
+ *  or queued commands.
+ *
+ *  \return True while the timer sends to the display
+ */
+bool lcd_isBusy(void)
+{
+	return gbi(TIMSK3, OCIE3A);
+}
+
+/*!
+ *  Clear the frame buffer, set the cursor to the home position and let the
+ *  display follow. Cells are compared again when the timer sends them, so
+ *  after a clear followed by a rewrite only the cells not yet sent that
+ *  still differ are sent.
  */
 void lcd_clear(void)
 {
 	os_enterCriticalSection();
 	charCtr = 0;
-	lcd_sendCommand(LCD_CMD_CLEAR_DISPLAY);
-	_delay_ms(2); // Clearing the display requires a delay
+	memset(lcd_buffer, ' ', sizeof(lcd_buffer));
 	os_leaveCriticalSection();
+
+	lcd_flush();
 }
 
 /*!
@@ -137,10 +442,7 @@ void lcd_clear(void)
  */
 void lcd_home(void)
 {
-	os_enterCriticalSection();
-	lcd_sendCommand(LCD_CMD_RETURN_HOME);
-	_delay_ms(2); // Returning home requires a delay
-	os_leaveCriticalSection();
+	lcd_goto(0, 0);
 }
 
 /*!
@@ -148,6 +450,7 @@ void lcd_home(void)
  */
 void lcd_displayOn(void)
 {
+	lcd_cursorShown = false;
 	lcd_sendCommand((LCD_CMD_DISPLAY_CONTROL | LCD_DISPLAY_ON) & ~LCD_CURSOR_ON & ~LCD_BLINK_ON);
 }
 
@@ -156,6 +459,7 @@ void lcd_displayOn(void)
  */
 void lcd_displayOff(void)
 {
+	lcd_cursorShown = false;
 	lcd_sendCommand(LCD_CMD_DISPLAY_CONTROL & ~LCD_DISPLAY_ON & ~LCD_CURSOR_ON & ~LCD_BLINK_ON);
 }
 
@@ -164,7 +468,9 @@ void lcd_displayOff(void)
  */
 void lcd_cursorOn(void)
 {
+	lcd_cursorShown = true;
 	lcd_sendCommand((LCD_CMD_DISPLAY_CONTROL | LCD_DISPLAY_ON | LCD_CURSOR_ON) & ~LCD_BLINK_ON);
+	lcd_flush();
 }
 
 /*!
@@ -172,6 +478,7 @@ void lcd_cursorOn(void)
  */
 void lcd_cursorOff(void)
 {
+	lcd_cursorShown = false;
 	lcd_sendCommand((LCD_CMD_DISPLAY_CONTROL | LCD_DISPLAY_ON) & ~LCD_CURSOR_ON & ~LCD_BLINK_ON);
 }
 
@@ -180,7 +487,9 @@ void lcd_cursorOff(void)
  */
 void lcd_blinkOn(void)
 {
+	lcd_cursorShown = true;
 	lcd_sendCommand(LCD_CMD_DISPLAY_CONTROL | LCD_DISPLAY_ON | LCD_CURSOR_ON | LCD_BLINK_ON);
+	lcd_flush();
 }
 
 /*!
@@ -188,11 +497,14 @@ void lcd_blinkOn(void)
  */
 void lcd_blinkOff(void)
 {
+	lcd_cursorShown = true;
 	lcd_sendCommand((LCD_CMD_DISPLAY_CONTROL | LCD_DISPLAY_ON | LCD_CURSOR_ON) & ~LCD_BLINK_ON);
+	lcd_flush();
 }
 
 /*!
- *  Set the cursor to the specified position.
+ *  Set the cursor to the specified position. Only the write position in
+ *  the frame buffer moves, the display follows with the next lcd_flush().
  *
  *  \param row  The row position (0 or 1 for a 2-line display)
  *  \param col  The column position (0-indexed)
@@ -204,7 +516,6 @@ void lcd_goto(uint8_t row, uint8_t col)
 		row = 1; // We only support two lines
 
 	os_enterCriticalSection();
-	lcd_sendCommand(LCD_CMD_SET_DDRAM_ADDR | (col + 0x40 * row));
 	charCtr = row * 16 + col;
 	os_leaveCriticalSection();
 }
@@ -221,8 +532,9 @@ void lcd_writeString(char *string)
 
 	while ((c = *(string++)) != '\0')
 	{
-		lcd_writeChar(c);
+		lcd_putChar(c);
 	}
+	lcd_flush();
 
 	os_leaveCriticalSection();
 }
@@ -246,67 +558,52 @@ void lcd_writeProgString(char const *string)
 
 	while ((c = (char)pgm_read_byte(string++)) != '\0')
 	{
-		lcd_writeChar(c);
+		lcd_putChar(c);
 	}
+	lcd_flush();
 
 	os_leaveCriticalSection();
 }
 
 /*!
- *  Send a command to the LCD.
+ *  Send a command to the LCD. It is queued and sent in the background
+ *  before any change of the frame buffer.
  *
  *  \param cmd  The command byte to send
  */
 void lcd_sendCommand(uint8_t cmd)
 {
-	os_enterCriticalSection();
-
-	LCD_RS_LOW(); // Command mode
-	lcd_sendNibble(cmd >> 4);
-	lcd_sendNibble(cmd);
-	_delay_us(40); // Most commands take < 37µs
-
-	os_leaveCriticalSection();
+	lcd_enqueue(cmd, false);
 }
 
 /*!
- *  Send data (a character) to the LCD.
+ *  Send data (a character) to the LCD. This bypasses the frame buffer,
+ *  the next lcd_flush() does not know about the character.
  *
  *  \param data  The data byte to send
  */
 void lcd_sendData(uint8_t data)
 {
-	os_enterCriticalSection();
-
-	LCD_RS_HIGH(); // Data mode
-	lcd_sendNibble(data >> 4);
-	lcd_sendNibble(data);
-	_delay_us(40); // Most characters take < 37µs
-
-	os_leaveCriticalSection();
+	lcd_enqueue(data, true);
 }
 
 /*!
- *  LCD draw char
+ *  Write a character into the frame buffer without sending it
+ *
+ *  \param character The character
  */
-void lcd_writeChar(char character)
+static void lcd_putChar(char character)
 {
-	os_enterCriticalSection();
-
 	if (character == '\n')
 	{
 		charCtr = (charCtr & LCD_COLS) + LCD_COLS; // <16 -> 16, <32 -> 32
+		return;
 	}
 
-	// Perform line-break if necessary
-	if (charCtr == LCD_COLS)
-	{
-		lcd_line2();
-	}
-	else if (charCtr == 2 * LCD_COLS)
+	// Start over on a cleared screen after the last cell, the second line follows the first one directly
+	if (charCtr >= 2 * LCD_COLS)
 	{
 		lcd_clear();
-		lcd_line1();
 	}
 
 	// Check for non-ASCII characters the LCD knows
@@ -341,29 +638,47 @@ void lcd_writeChar(char character)
             break;
     }
 
-	// Draw character
-	lcd_sendData(character);
-	charCtr++;
+	lcd_buffer[charCtr++] = character;
+}
 
+/*!
+ *  LCD draw char
+ */
+void lcd_writeChar(char character)
+{
+	os_enterCriticalSection();
+	lcd_putChar(character);
+	lcd_flush();
 	os_leaveCriticalSection();
 }
 
 /*!
- *  Writes a hexadecimal half-byte (one nibble)
+ *  Writes a hexadecimal half-byte (one nibble) into the frame buffer
  *
  *  \param number  The number to be written.
  */
-void lcd_writeHexNibble(uint8_t number)
+static void lcd_putHexNibble(uint8_t number)
 {
-	os_enterCriticalSection();
-
 	// get low and high nibble
 	uint8_t const low = number & 0xF;
 
 	if (low < 10)
-		lcd_writeChar(low + '0'); // write as ASCII number
+		lcd_putChar(low + '0'); // write as ASCII number
 	else
-		lcd_writeChar(low - 10 + 'A'); // write as ASCII letter
+		lcd_putChar(low - 10 + 'A'); // write as ASCII letter
+}
+
+/*!
+ *  Writes a hexadecimal half-byte (one nibble)
+ *
+ *  \param number  The number to be written.
+ */
+void lcd_writeHexNibble(uint8_t number)
+{
+	os_enterCriticalSection();
+
+	lcd_putHexNibble(number);
+	lcd_flush();
 
 	os_leaveCriticalSection();
 }
@@ -377,8 +692,9 @@ void lcd_writeHexByte(uint8_t number)
 {
 	os_enterCriticalSection();
 
-	lcd_writeHexNibble(number >> 4);
-	lcd_writeHexNibble(number & 0xF);
+	lcd_putHexNibble(number >> 4);
+	lcd_putHexNibble(number & 0xF);
+	lcd_flush();
 
 	os_leaveCriticalSection();
 }
@@ -392,8 +708,11 @@ void lcd_writeHexWord(uint16_t number)
 {
 	os_enterCriticalSection();
 
-	lcd_writeHexByte(number >> 8);
-	lcd_writeHexByte(number);
+	lcd_putHexNibble(number >> 12);
+	lcd_putHexNibble(number >> 8);
+	lcd_putHexNibble(number >> 4);
+	lcd_putHexNibble(number);
+	lcd_flush();
 
 	os_leaveCriticalSection();
 }
@@ -417,9 +736,10 @@ void lcd_writeHex(uint16_t number)
 		print |= number >> nib;
 		if (print)
 		{
-			lcd_writeHexNibble(number >> nib);
+			lcd_putHexNibble(number >> nib);
 		}
 	}
+	lcd_flush();
 
 	os_leaveCriticalSection();
 }
@@ -447,8 +767,9 @@ void lcd_writeDec(uint16_t number)
 		uint8_t const digit = number / pos;
 		number -= digit * pos;
 		if (print |= digit)
-			lcd_writeChar(digit + '0');
+			lcd_putChar(digit + '0');
 	} while (pos /= 10);
+	lcd_flush();
 
 	os_leaveCriticalSection();
 }
@@ -470,8 +791,9 @@ void lcd_drawBar(uint8_t percent)
 	// draw bars
 	for (i = 0; i < val; i += 100)
 	{
-		lcd_writeChar(LCD_CHAR_BAR);
+		lcd_putChar(LCD_CHAR_BAR);
 	}
+	lcd_flush();
 
 	os_leaveCriticalSection();
 }
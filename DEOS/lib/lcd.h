@@ -76,6 +76,12 @@ void lcd_printf_p(const char *fmt, ...);
 #define LCD_ROWS /*   */ 2
 #define LCD_COLS /*   */ 16
 
+//! Time in us between two steps of the timer that sends to the LCD, must exceed the 37us a byte takes to execute
+#define LCD_TICK_US 50
+
+//! Number of commands and raw characters that can wait to be sent, characters written to the frame buffer need no entry
+#define LCD_QUEUE_SIZE 8
+
 //! Character that looks like filled rectangle
 #define LCD_CHAR_BAR 0xFF
 
@@ -84,9 +90,15 @@ void lcd_printf_p(const char *fmt, ...);
 //! Initialize the LCD in 4-bit mode
 void lcd_init(void);
 
-//! Clear the display and set the cursor to the home position
+//! Clear the frame buffer and the display and set the cursor to the home position
 void lcd_clear(void);
 
+//! Start sending the cells of the frame buffer that differ from the display in the background
+void lcd_flush(void);
+
+//! Whether the display still has to catch up with the frame buffer
+bool lcd_isBusy(void);
+
 //! Set the cursor to the home position
 void lcd_home(void);
 
@@ -111,10 +123,10 @@ void lcd_blinkOff(void);
 //! Set the cursor to a specific position
 void lcd_goto(uint8_t row, uint8_t col);
 
-//! Send a nibble to the LCD
+//! Queue a command for the LCD
 void lcd_sendCommand(uint8_t cmd);
 
-//! Send a nibble to the LCD
+//! Queue a character for the LCD, bypassing the frame buffer
 void lcd_sendData(uint8_t data);
 
 bool lcd_shift(uint8_t item, uint8_t direction);
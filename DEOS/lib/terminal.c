@@ -46,6 +46,20 @@ void terminal_log_printf_p(const char *prefix, const char *fmt, ...)
 
 FILE mystdout = FDEV_SETUP_STREAM(stdio_put_char, NULL, _FDEV_SETUP_WRITE);
 
+//----------------------------------------------------------------------------
+// Commands
+//----------------------------------------------------------------------------
+
+//! A command that can be triggered from the terminal by a single key
+typedef struct TerminalCommand
+{
+    char key;
+    terminal_command_t* command;
+} terminal_command_entry_t;
+
+terminal_command_entry_t terminal_commands[TERMINAL_MAX_COMMANDS];
+uint8_t terminal_commandCount = 0;
+
 //----------------------------------------------------------------------------
 // USB port
 //----------------------------------------------------------------------------
@@ -252,4 +266,76 @@ void terminal_writeProgString(const char *pstr)
 void terminal_newLine()
 {
     terminal_writeChar('\n');
-}
\ No newline at end of file
+}
+
+/*!
+ *  Registers a command that is executed by terminal_processCommands when the
+ *  key is received from the terminal. Registering a key again replaces its command.
+ *
+ *  \param key  The key that triggers the command
+ *  \param command  The function to execute
+ *  \return False if there is no free slot
+ */
+bool terminal_registerCommand(char key, terminal_command_t* command)
+{
+    for (uint8_t i = 0; i < terminal_commandCount; i++)
+    {
+        if (terminal_commands[i].key == key)
+        {
+            terminal_commands[i].command = command;
+            return true;
+        }
+    }
+
+    if (terminal_commandCount >= TERMINAL_MAX_COMMANDS)
+    {
+        return false;
+    }
+
+    terminal_commands[terminal_commandCount].key = key;
+    terminal_commands[terminal_commandCount].command = command;
+    terminal_commandCount++;
+    return true;
+}
+
+/*!
+ *  Executes the commands whose keys were received from the terminal since the
+ *  last call. Returns immediately if nothing was received, so it can be called
+ *  in the loop of a worker process.
+ */
+void terminal_processCommands()
+{
+    while (gbi(UCSR2A, RXC2))
+    {
+        char key = UDR2;
+        bool found = false;
+
+        if (key == '\r' || key == '\n')
+        {
+            continue;
+        }
+
+        for (uint8_t i = 0; i < terminal_commandCount; i++)
+        {
+            if (terminal_commands[i].key == key)
+            {
+                terminal_commands[i].command();
+                found = true;
+                break;
+            }
+        }
+
+        if (!found)
+        {
+            os_enterCriticalSection();
+            terminal_writeProgString(PSTR("[WARN]  Unknown command, available:"));
+            for (uint8_t i = 0; i < terminal_commandCount; i++)
+            {
+                terminal_writeChar(' ');
+                terminal_writeChar(terminal_commands[i].key);
+            }
+            terminal_newLine();
+            os_leaveCriticalSection();
+        }
+    }
+}
@@ -7,6 +7,7 @@
 #ifndef TERMINAL_H_
 #define TERMINAL_H_
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 
@@ -53,4 +54,16 @@ void terminal_newLine();
 //! Write a formatted string to the terminal with a prefix
 void terminal_log_printf_p(const char* prefix, const char* fmt, ...);
 
+//! Maximum number of commands that can be registered
+#define TERMINAL_MAX_COMMANDS 4
+
+//! Type of a function that is executed when its key is received from the terminal
+typedef void terminal_command_t(void);
+
+//! Registers a command that is executed when the key is received
+bool terminal_registerCommand(char key, terminal_command_t* command);
+
+//! Executes the commands received since the last call, does not wait for input
+void terminal_processCommands();
+
 #endif /* TERMINAL_H_ */
\ No newline at end of file
@@ -44,6 +44,10 @@ LICENSE:
 #include <avr/interrupt.h>
 #include <avr/pgmspace.h>
 #include "uart.h"
+#include "../os_scheduler.h"
+#include "terminal.h"
+#include <stdlib.h>
+#include <string.h>
 
 
 /*
@@ -71,6 +75,12 @@ LICENSE:
 #error TX1 buffer size is not a power of 2
 #endif
 
+/* blocked writers are woken when the TX1 buffer has drained to this filling */
+#define UART1_TX_WAKEUP_LEVEL ( UART1_TX_BUFFER_SIZE / 2 )
+
+/* keeps the compiler from moving buffer accesses behind the index update */
+#define UART_MEMORY_BARRIER()  __asm__ __volatile__ ("" ::: "memory")
+
 #define UART2_RX_BUFFER_MASK ( UART2_RX_BUFFER_SIZE - 1)
 #define UART2_TX_BUFFER_MASK ( UART2_TX_BUFFER_SIZE - 1)
 
@@ -437,58 +447,207 @@ LICENSE:
 
 /*
  *  module global variables
+ *  a port only gets the buffers and indices it is configured for
  */
-static volatile unsigned char UART0_TxBuf[UART0_TX_BUFFER_SIZE];
+#if UART0_RX_BUFFER_SIZE > 256
+typedef uint16_t uart0_rx_index_t;
+#else
+typedef unsigned char uart0_rx_index_t;
+#endif
+#if UART0_TX_BUFFER_SIZE > 256
+typedef uint16_t uart0_tx_index_t;
+#else
+typedef unsigned char uart0_tx_index_t;
+#endif
+
+#if UART0_RX_BUFFER_SIZE > 0
+#define UART0_RX_ENABLE (_BV(UART0_BIT_RXCIE)|(1<<UART0_BIT_RXEN))
 static volatile unsigned char UART0_RxBuf[UART0_RX_BUFFER_SIZE];
-static volatile unsigned char UART0_TxHead;
-static volatile unsigned char UART0_TxTail;
-static volatile unsigned char UART0_RxHead;
-static volatile unsigned char UART0_RxTail;
+static volatile uart0_rx_index_t UART0_RxHead;
+static volatile uart0_rx_index_t UART0_RxTail;
 static volatile unsigned char UART0_LastRxError;
+#else
+#define UART0_RX_ENABLE 0
+#endif
+
+#if UART0_TX_BUFFER_SIZE > 0
+#define UART0_TX_ENABLE (1<<UART0_BIT_TXEN)
+static volatile unsigned char UART0_TxBuf[UART0_TX_BUFFER_SIZE];
+static volatile uart0_tx_index_t UART0_TxHead;
+static volatile uart0_tx_index_t UART0_TxTail;
+#else
+#define UART0_TX_ENABLE 0
+#endif
+
+#if UART0_RX_BUFFER_SIZE > 0 || UART0_TX_BUFFER_SIZE > 0
+static volatile uart_stats_t UART0_Stats;
+#endif
 
 #if defined( ATMEGA_USART1 )
-static volatile unsigned char UART1_TxBuf[UART1_TX_BUFFER_SIZE];
+#if UART1_RX_BUFFER_SIZE > 256
+typedef uint16_t uart1_rx_index_t;
+#else
+typedef unsigned char uart1_rx_index_t;
+#endif
+#if UART1_TX_BUFFER_SIZE > 256
+typedef uint16_t uart1_tx_index_t;
+#else
+typedef unsigned char uart1_tx_index_t;
+#endif
+
+#if UART1_RX_BUFFER_SIZE > 0
+#define UART1_RX_ENABLE (_BV(UART1_BIT_RXCIE)|(1<<UART1_BIT_RXEN))
 static volatile unsigned char UART1_RxBuf[UART1_RX_BUFFER_SIZE];
-static volatile unsigned char UART1_TxHead;
-static volatile unsigned char UART1_TxTail;
-static volatile unsigned char UART1_RxHead;
-static volatile unsigned char UART1_RxTail;
+static volatile uart1_rx_index_t UART1_RxHead;
+static volatile uart1_rx_index_t UART1_RxTail;
 static volatile unsigned char UART1_LastRxError;
+#else
+#define UART1_RX_ENABLE 0
+#endif
+
+#if UART1_TX_BUFFER_SIZE > 0
+#define UART1_TX_ENABLE (1<<UART1_BIT_TXEN)
+static volatile unsigned char UART1_TxBuf[UART1_TX_BUFFER_SIZE];
+static volatile uart1_tx_index_t UART1_TxHead;
+static volatile uart1_tx_index_t UART1_TxTail;
+static wait_queue_t UART1_TxSpaceQueue;
+static wait_queue_t UART1_TxDrainedQueue;
+#else
+#define UART1_TX_ENABLE 0
+#endif
+
+#if UART1_RX_BUFFER_SIZE > 0 || UART1_TX_BUFFER_SIZE > 0
+static volatile uart_stats_t UART1_Stats;
+#endif
 #endif
 
 #if defined( ATMEGA_USART2 )
-static volatile unsigned char UART2_TxBuf[UART2_TX_BUFFER_SIZE];
+#if UART2_RX_BUFFER_SIZE > 256
+typedef uint16_t uart2_rx_index_t;
+#else
+typedef unsigned char uart2_rx_index_t;
+#endif
+#if UART2_TX_BUFFER_SIZE > 256
+typedef uint16_t uart2_tx_index_t;
+#else
+typedef unsigned char uart2_tx_index_t;
+#endif
+
+#if UART2_RX_BUFFER_SIZE > 0
+#define UART2_RX_ENABLE (_BV(UART2_BIT_RXCIE)|(1<<UART2_BIT_RXEN))
 static volatile unsigned char UART2_RxBuf[UART2_RX_BUFFER_SIZE];
-static volatile unsigned char UART2_TxHead;
-static volatile unsigned char UART2_TxTail;
-static volatile unsigned char UART2_RxHead;
-static volatile unsigned char UART2_RxTail;
+static volatile uart2_rx_index_t UART2_RxHead;
+static volatile uart2_rx_index_t UART2_RxTail;
 static volatile unsigned char UART2_LastRxError;
+#else
+#define UART2_RX_ENABLE 0
+#endif
+
+#if UART2_TX_BUFFER_SIZE > 0
+#define UART2_TX_ENABLE (1<<UART2_BIT_TXEN)
+static volatile unsigned char UART2_TxBuf[UART2_TX_BUFFER_SIZE];
+static volatile uart2_tx_index_t UART2_TxHead;
+static volatile uart2_tx_index_t UART2_TxTail;
+#else
+#define UART2_TX_ENABLE 0
+#endif
+
+#if UART2_RX_BUFFER_SIZE > 0 || UART2_TX_BUFFER_SIZE > 0
+static volatile uart_stats_t UART2_Stats;
+#endif
 #endif
 
 #if defined( ATMEGA_USART3 )
-static volatile unsigned char UART3_TxBuf[UART3_TX_BUFFER_SIZE];
+#if UART3_RX_BUFFER_SIZE > 256
+typedef uint16_t uart3_rx_index_t;
+#else
+typedef unsigned char uart3_rx_index_t;
+#endif
+#if UART3_TX_BUFFER_SIZE > 256
+typedef uint16_t uart3_tx_index_t;
+#else
+typedef unsigned char uart3_tx_index_t;
+#endif
+
+#if UART3_RX_BUFFER_SIZE > 0
+#define UART3_RX_ENABLE (_BV(UART3_BIT_RXCIE)|(1<<UART3_BIT_RXEN))
 static volatile unsigned char UART3_RxBuf[UART3_RX_BUFFER_SIZE];
-static volatile unsigned char UART3_TxHead;
-static volatile unsigned char UART3_TxTail;
-static volatile unsigned char UART3_RxHead;
-static volatile unsigned char UART3_RxTail;
+static volatile uart3_rx_index_t UART3_RxHead;
+static volatile uart3_rx_index_t UART3_RxTail;
 static volatile unsigned char UART3_LastRxError;
+#else
+#define UART3_RX_ENABLE 0
 #endif
 
+#if UART3_TX_BUFFER_SIZE > 0
+#define UART3_TX_ENABLE (1<<UART3_BIT_TXEN)
+static volatile unsigned char UART3_TxBuf[UART3_TX_BUFFER_SIZE];
+static volatile uart3_tx_index_t UART3_TxHead;
+static volatile uart3_tx_index_t UART3_TxTail;
+#else
+#define UART3_TX_ENABLE 0
+#endif
+
+#if UART3_RX_BUFFER_SIZE > 0 || UART3_TX_BUFFER_SIZE > 0
+static volatile uart_stats_t UART3_Stats;
+#endif
+#endif
+
+/*
+ *  ring buffer indices
+ *  buffers with more than 256 bytes need 16 bit indices, which the CPU
+ *  cannot read or write in one go, so outside the ISRs they are accessed
+ *  with interrupts disabled
+ */
+#define UART_LOAD_INDEX(dst, index)                     \
+    do {                                                \
+        if ( sizeof(index) > 1 ) {                      \
+            unsigned char sreg_ = SREG;                 \
+            cli();                                      \
+            (dst) = (index);                            \
+            SREG = sreg_;                               \
+        } else {                                        \
+            (dst) = (index);                            \
+        }                                               \
+    } while (0)
+
+#define UART_STORE_INDEX(index, value)                  \
+    do {                                                \
+        if ( sizeof(index) > 1 ) {                      \
+            unsigned char sreg_ = SREG;                 \
+            cli();                                      \
+            (index) = (value);                          \
+            SREG = sreg_;                               \
+        } else {                                        \
+            (index) = (value);                          \
+        }                                               \
+    } while (0)
+
+#ifndef cbi
+#define cbi(x, b) (x &= ~(1 << (b)))
+#endif
+
+static inline uint16_t BUFFER_FILLING(uint16_t head, uint16_t tail, uint16_t size)
+{
+	if (head >= tail) { return head - tail; }
+	return size - tail + head;
+}
+
 
 //! USART 0 =======================================================================================
 
+#if UART0_RX_BUFFER_SIZE > 0
 ISR (UART0_RECEIVE_INTERRUPT)	
 /*************************************************************************
 Function: UART Receive Complete interrupt
 Purpose:  called when the UART has received a character
 **************************************************************************/
 {
-    unsigned char tmphead;
+    uart0_rx_index_t tmphead;
     unsigned char data;
     unsigned char usr;
     unsigned char lastRxError;
+    uint16_t filling;
  
  
     /* read UART status register and UART data register */
@@ -506,42 +665,67 @@ Purpose:  called when the UART has received a character
     lastRxError = usr & (_BV(FE)|_BV(DOR) );
 #endif
 
+    /* count received bytes and errors */
+    UART0_Stats.bytesReceived++;
+    if ( lastRxError & (UART_OVERRUN_ERROR >> 8) ) {
+        UART0_Stats.overruns++;
+    }
+    if ( lastRxError & (UART_FRAME_ERROR >> 8) ) {
+        UART0_Stats.frameErrors++;
+    }
+
     /* calculate buffer index */ 
     tmphead = ( UART0_RxHead + 1) & UART0_RX_BUFFER_MASK;
     
     if ( tmphead == UART0_RxTail ) {
         /* error: receive buffer overflow */
         lastRxError = UART_BUFFER_OVERFLOW >> 8;
+        UART0_Stats.bufferOverflows++;
     }else{
         /* store new index */
         UART0_RxHead = tmphead;
         /* store received data in buffer */
         UART0_RxBuf[tmphead] = data;
+        /* remember the highest filling */
+        filling = BUFFER_FILLING(tmphead, UART0_RxTail, UART0_RX_BUFFER_SIZE);
+        if ( filling > UART0_Stats.rxPeak ) {
+            UART0_Stats.rxPeak = filling;
+        }
     }
     UART0_LastRxError |= lastRxError;   
 }
+#endif
 
 
+#if UART0_TX_BUFFER_SIZE > 0
 ISR (UART0_TRANSMIT_INTERRUPT)
 /*************************************************************************
 Function: UART Data Register Empty interrupt
 Purpose:  called when the UART is ready to transmit the next byte
 **************************************************************************/
 {
-    unsigned char tmptail;
+    uart0_tx_index_t tmptail;
+    uint16_t filling;
 
     
     if ( UART0_TxHead != UART0_TxTail) {
+        /* remember the highest filling */
+        filling = BUFFER_FILLING(UART0_TxHead, UART0_TxTail, UART0_TX_BUFFER_SIZE);
+        if ( filling > UART0_Stats.txPeak ) {
+            UART0_Stats.txPeak = filling;
+        }
         /* calculate and store new buffer index */
         tmptail = (UART0_TxTail + 1) & UART0_TX_BUFFER_MASK;
         UART0_TxTail = tmptail;
         /* get one byte from buffer and write it to UART */
         UART0_DATA = UART0_TxBuf[tmptail];  /* start transmission */
+        UART0_Stats.bytesSent++;
     }else{
         /* tx buffer empty, disable UDRE interrupt */
         UART0_CONTROL &= ~_BV(UART0_UDRIE);
     }
 }
+#endif
 
 
 /*************************************************************************
@@ -552,10 +736,14 @@ Returns:  none
 **************************************************************************/
 void uart0_init(unsigned int baudrate)
 {
+#if UART0_TX_BUFFER_SIZE > 0
     UART0_TxHead = 0;
     UART0_TxTail = 0;
+#endif
+#if UART0_RX_BUFFER_SIZE > 0
     UART0_RxHead = 0;
     UART0_RxTail = 0;
+#endif
 
 #ifdef UART_TEST
 #ifndef UART0_BIT_U2X
@@ -574,20 +762,17 @@ void uart0_init(unsigned int baudrate)
 #endif
 #endif
 
-    /* Set baud rate */
-    if ( baudrate & 0x8000 )
-    {
-        #if UART0_BIT_U2X
-        UART0_STATUS = (1<<UART0_BIT_U2X);  //Enable 2x speed 
-        #endif
-    } 
+    /* Set baud rate, double speed is switched off again if it is not requested */
+    #if UART0_BIT_U2X
+    UART0_STATUS = ( baudrate & 0x8000 ) ? (1<<UART0_BIT_U2X) : 0;
+    #endif
     #if defined(UART0_UBRRH)
-    UART0_UBRRH = (unsigned char)((baudrate>>8)&0x80) ;
+    UART0_UBRRH = (unsigned char)((baudrate>>8)&0x0F) ;
     #endif    
     UART0_UBRRL = (unsigned char) (baudrate&0x00FF);
       
-    /* Enable USART receiver and transmitter and receive complete interrupt */
-    UART0_CONTROL = _BV(UART0_BIT_RXCIE)|(1<<UART0_BIT_RXEN)|(1<<UART0_BIT_TXEN);
+    /* Enable USART receiver and receive complete interrupt and transmitter, as far as they have a buffer */
+    UART0_CONTROL = UART0_RX_ENABLE|UART0_TX_ENABLE;
     
     /* Set frame format: asynchronous, 8data, no parity, 1stop bit */
     #ifdef UART0_CONTROLC
@@ -601,6 +786,7 @@ void uart0_init(unsigned int baudrate)
 }/* uart0_init */
 
 
+#if UART0_RX_BUFFER_SIZE > 0
 /*************************************************************************
 Function: uart0_getc()
 Purpose:  return byte from ringbuffer  
@@ -609,12 +795,14 @@ Returns:  lower byte:  received byte from ringbuffer
 **************************************************************************/
 unsigned int uart0_getc(void)
 {    
-    unsigned char tmptail;
+    uart0_rx_index_t tmptail;
+    uart0_rx_index_t head;
     unsigned char data;
     unsigned char lastRxError;
 
 
-    if ( UART0_RxHead == UART0_RxTail ) {
+    UART_LOAD_INDEX(head, UART0_RxHead);
+    if ( head == UART0_RxTail ) {
         return UART_NO_DATA;   /* no data available */
     }
     
@@ -626,14 +814,16 @@ unsigned int uart0_getc(void)
     lastRxError = UART0_LastRxError;
     
     /* store buffer index */
-    UART0_RxTail = tmptail; 
+    UART_STORE_INDEX(UART0_RxTail, tmptail);
     
     UART0_LastRxError = 0;
     return (lastRxError << 8) + data;
 
 }/* uart0_getc */
+#endif
 
 
+#if UART0_TX_BUFFER_SIZE > 0
 /*************************************************************************
 Function: uart0_putc()
 Purpose:  write byte to ringbuffer for transmitting via UART
@@ -642,17 +832,19 @@ Returns:  none
 **************************************************************************/
 void uart0_putc(unsigned char data)
 {
-    unsigned char tmphead;
+    uart0_tx_index_t tmphead;
+    uart0_tx_index_t tail;
 
     
     tmphead  = (UART0_TxHead + 1) & UART0_TX_BUFFER_MASK;
     
-    while ( tmphead == UART0_TxTail ){
-        ;/* wait for free space in buffer */
-    }
+    do {
+        /* wait for free space in buffer */
+        UART_LOAD_INDEX(tail, UART0_TxTail);
+    } while ( tmphead == tail );
     
     UART0_TxBuf[tmphead] = data;
-    UART0_TxHead = tmphead;
+    UART_STORE_INDEX(UART0_TxHead, tmphead);
 
     /* enable UDRE interrupt */
     UART0_CONTROL    |= _BV(UART0_UDRIE);
@@ -688,33 +880,32 @@ void uart0_puts_p(const char *progmem_s )
       uart0_putc(c);
 
 }/* uart0_puts_p */
-
-//! Extensions by David Thoennessen - proTEC-Vision Automation GmbH ===========
-#ifndef cbi
-#define cbi(x, b) (x &= ~(1 << (b)))
 #endif
 
-inline uint16_t BUFFER_FILLING(uint16_t head, uint16_t tail, uint16_t size)
-{
-	if (head >= tail) { return head - tail; }
-	return size - tail + head;
-}
-
+//! Extensions by David Thoennessen - proTEC-Vision Automation GmbH ===========
+#if UART0_RX_BUFFER_SIZE > 0
 /*
  * Returns current filling of the buffer in byte
  */
 uint16_t uart0_getrxcount()
 {
-	return BUFFER_FILLING(UART0_RxHead, UART0_RxTail, UART0_RX_BUFFER_SIZE);
+	uart0_rx_index_t head;
+	UART_LOAD_INDEX(head, UART0_RxHead);
+	return BUFFER_FILLING(head, UART0_RxTail, UART0_RX_BUFFER_SIZE);
 }
+#endif
 
+#if UART0_TX_BUFFER_SIZE > 0
 /*
  * Returns current filling of the buffer in byte
  */
 uint16_t uart0_gettxcount()
 {
-	return BUFFER_FILLING(UART0_TxHead, UART0_TxTail, UART0_TX_BUFFER_SIZE);
+	uart0_tx_index_t tail;
+	UART_LOAD_INDEX(tail, UART0_TxTail);
+	return BUFFER_FILLING(UART0_TxHead, tail, UART0_TX_BUFFER_SIZE);
 }
+#endif
 
 /*
  * Disables the RX/TX ports to not provide the connected device with energy
@@ -724,6 +915,30 @@ void uart0_disable()
 	cbi(UART0_CONTROL, UART0_BIT_RXEN);
 	cbi(UART0_CONTROL, UART0_BIT_TXEN);
 }
+
+#if UART0_RX_BUFFER_SIZE > 0 || UART0_TX_BUFFER_SIZE > 0
+/*
+ * Copies the statistics of the port
+ */
+void uart0_getStats(uart_stats_t *stats)
+{
+	unsigned char sreg = SREG;
+	cli();
+	memcpy(stats, (uart_stats_t *)&UART0_Stats, sizeof(uart_stats_t));
+	SREG = sreg;
+}
+
+/*
+ * Sets all statistics of the port to 0
+ */
+void uart0_resetStats()
+{
+	unsigned char sreg = SREG;
+	cli();
+	memset((uart_stats_t *)&UART0_Stats, 0, sizeof(uart_stats_t));
+	SREG = sreg;
+}
+#endif
 //! ===========================================================================
 
 //! USART 1 =======================================================================================
@@ -732,16 +947,18 @@ void uart0_disable()
  */
 #if defined( ATMEGA_USART1 )
 
+#if UART1_RX_BUFFER_SIZE > 0
 ISR(UART1_RECEIVE_INTERRUPT)
 /*************************************************************************
 Function: UART1 Receive Complete interrupt
 Purpose:  called when the UART1 has received a character
 **************************************************************************/
 {
-    unsigned char tmphead;
+    uart1_rx_index_t tmphead;
     unsigned char data;
     unsigned char usr;
     unsigned char lastRxError;
+    uint16_t filling;
  
  
     /* read UART status register and UART data register */ 
@@ -751,42 +968,76 @@ Purpose:  called when the UART1 has received a character
     /* get FEn (Frame Error) DORn (Data OverRun) UPEn (USART Parity Error) bits */
     lastRxError = usr & (_BV(FE1)|_BV(DOR1)|_BV(UPE1) );
             
+    /* count received bytes and errors */
+    UART1_Stats.bytesReceived++;
+    if ( lastRxError & (UART_OVERRUN_ERROR >> 8) ) {
+        UART1_Stats.overruns++;
+    }
+    if ( lastRxError & (UART_FRAME_ERROR >> 8) ) {
+        UART1_Stats.frameErrors++;
+    }
+
     /* calculate buffer index */ 
     tmphead = ( UART1_RxHead + 1) & UART1_RX_BUFFER_MASK;
     
     if ( tmphead == UART1_RxTail ) {
         /* error: receive buffer overflow */
         lastRxError = UART_BUFFER_OVERFLOW >> 8;
+        UART1_Stats.bufferOverflows++;
     }else{
         /* store new index */
         UART1_RxHead = tmphead;
         /* store received data in buffer */
         UART1_RxBuf[tmphead] = data;
+        /* remember the highest filling */
+        filling = BUFFER_FILLING(tmphead, UART1_RxTail, UART1_RX_BUFFER_SIZE);
+        if ( filling > UART1_Stats.rxPeak ) {
+            UART1_Stats.rxPeak = filling;
+        }
     }
     UART1_LastRxError |= lastRxError;   
 }
+#endif
 
 
+#if UART1_TX_BUFFER_SIZE > 0
 ISR(UART1_TRANSMIT_INTERRUPT)
 /*************************************************************************
 Function: UART1 Data Register Empty interrupt
 Purpose:  called when the UART1 is ready to transmit the next byte
 **************************************************************************/
 {
-    unsigned char tmptail;
+    uart1_tx_index_t tmptail;
+    uint16_t filling;
 
     
     if ( UART1_TxHead != UART1_TxTail) {
+        /* remember the highest filling */
+        filling = BUFFER_FILLING(UART1_TxHead, UART1_TxTail, UART1_TX_BUFFER_SIZE);
+        if ( filling > UART1_Stats.txPeak ) {
+            UART1_Stats.txPeak = filling;
+        }
         /* calculate and store new buffer index */
         tmptail = (UART1_TxTail + 1) & UART1_TX_BUFFER_MASK;
         UART1_TxTail = tmptail;
         /* get one byte from buffer and write it to UART */
         UART1_DATA = UART1_TxBuf[tmptail];  /* start transmission */
+        UART1_Stats.bytesSent++;
+
+        /* wake blocked writers once there is a reasonable amount of space */
+        if ( UART1_TxSpaceQueue && BUFFER_FILLING(UART1_TxHead, tmptail, UART1_TX_BUFFER_SIZE) <= UART1_TX_WAKEUP_LEVEL ) {
+            os_signal(&UART1_TxSpaceQueue);
+        }
     }else{
         /* tx buffer empty, disable UDRE interrupt */
         UART1_CONTROL &= ~_BV(UART1_UDRIE);
+
+        /* tx buffer drained */
+        os_signal(&UART1_TxSpaceQueue);
+        os_signal(&UART1_TxDrainedQueue);
     }
 }
+#endif
 
 
 /*************************************************************************
@@ -797,10 +1048,14 @@ Returns:  none
 **************************************************************************/
 void uart1_init(unsigned int baudrate)
 {
+#if UART1_TX_BUFFER_SIZE > 0
     UART1_TxHead = 0;
     UART1_TxTail = 0;
+#endif
+#if UART1_RX_BUFFER_SIZE > 0
     UART1_RxHead = 0;
     UART1_RxTail = 0;
+#endif
 
 #ifdef UART_TEST
 #ifndef UART1_BIT_U2X
@@ -819,18 +1074,15 @@ void uart1_init(unsigned int baudrate)
 #endif
 #endif
 
-    /* Set baud rate */
-    if ( baudrate & 0x8000 ) 
-    {
-        #if UART1_BIT_U2X
-    	UART1_STATUS = (1<<UART1_BIT_U2X);  //Enable 2x speed 
-        #endif
-    }
-    UART1_UBRRH = (unsigned char)((baudrate>>8)&0x80) ;
+    /* Set baud rate, double speed is switched off again if it is not requested */
+    #if UART1_BIT_U2X
+    UART1_STATUS = ( baudrate & 0x8000 ) ? (1<<UART1_BIT_U2X) : 0;
+    #endif
+    UART1_UBRRH = (unsigned char)((baudrate>>8)&0x0F) ;
     UART1_UBRRL = (unsigned char) baudrate;
         
-    /* Enable USART receiver and transmitter and receive complete interrupt */
-    UART1_CONTROL = _BV(UART1_BIT_RXCIE)|(1<<UART1_BIT_RXEN)|(1<<UART1_BIT_TXEN);    
+    /* Enable USART receiver and receive complete interrupt and transmitter, as far as they have a buffer */
+    UART1_CONTROL = UART1_RX_ENABLE|UART1_TX_ENABLE;    
     
     /* Set frame format: asynchronous, 8data, no parity, 1stop bit */   
     #ifdef UART1_BIT_URSEL
@@ -842,6 +1094,7 @@ void uart1_init(unsigned int baudrate)
 }/* uart_init */
 
 
+#if UART1_RX_BUFFER_SIZE > 0
 /*************************************************************************
 Function: uart1_getc()
 Purpose:  return byte from ringbuffer  
@@ -850,12 +1103,14 @@ Returns:  lower byte:  received byte from ringbuffer
 **************************************************************************/
 unsigned int uart1_getc(void)
 {    
-    unsigned char tmptail;
+    uart1_rx_index_t tmptail;
+    uart1_rx_index_t head;
     unsigned int  data;
     unsigned char lastRxError;
 
 
-    if ( UART1_RxHead == UART1_RxTail ) {
+    UART_LOAD_INDEX(head, UART1_RxHead);
+    if ( head == UART1_RxTail ) {
         return UART_NO_DATA;   /* no data available */
     }
     
@@ -867,14 +1122,16 @@ unsigned int uart1_getc(void)
     lastRxError = UART1_LastRxError;
     
     /* store buffer index */
-    UART1_RxTail = tmptail; 
+    UART_STORE_INDEX(UART1_RxTail, tmptail);
     
     UART1_LastRxError = 0;
     return (lastRxError << 8) + data;
 
 }/* uart1_getc */
+#endif
 
 
+#if UART1_TX_BUFFER_SIZE > 0
 /*************************************************************************
 Function: uart1_putc()
 Purpose:  write byte to ringbuffer for transmitting via UART
@@ -883,17 +1140,25 @@ Returns:  none
 **************************************************************************/
 void uart1_putc(unsigned char data)
 {
-    unsigned char tmphead;
+    uart1_tx_index_t tmphead;
+    uart1_tx_index_t tail;
 
     
     tmphead  = (UART1_TxHead + 1) & UART1_TX_BUFFER_MASK;
     
-    while ( tmphead == UART1_TxTail ){
-        ;/* wait for free space in buffer */
+    UART_LOAD_INDEX(tail, UART1_TxTail);
+    if ( tmphead == tail ){
+        /* wait for free space in buffer, other processes run meanwhile */
+        cli();
+        while ( tmphead == UART1_TxTail ){
+            os_waitOn(&UART1_TxSpaceQueue);
+            cli();
+        }
+        sei();
     }
     
     UART1_TxBuf[tmphead] = data;
-    UART1_TxHead = tmphead;
+    UART_STORE_INDEX(UART1_TxHead, tmphead);
 
     /* enable UDRE interrupt */
     UART1_CONTROL    |= _BV(UART1_UDRIE);
@@ -931,22 +1196,195 @@ void uart1_puts_p(const char *progmem_s )
 }/* uart1_puts_p */
 
 
+/*************************************************************************
+Function: uart1_tryWrite()
+Purpose:  write as many bytes to ringbuffer as fit without waiting
+          the free space is filled with at most two copies (up to the end
+          of the buffer and from its start) and a single head update
+Input:    data to be transmitted and its length
+Returns:  number of bytes accepted
+**************************************************************************/
+uint16_t uart1_tryWrite(const void *data, uint16_t length)
+{
+    const unsigned char *bytes = data;
+    uart1_tx_index_t head = UART1_TxHead;
+    uart1_tx_index_t tail;
+    uint16_t space;
+    uint16_t start;
+    uint16_t chunk;
+
+
+    UART_LOAD_INDEX(tail, UART1_TxTail);
+    space = (UART1_TX_BUFFER_SIZE - 1) - BUFFER_FILLING(head, tail, UART1_TX_BUFFER_SIZE);
+    if ( length > space ) {
+        length = space;
+    }
+    if ( length == 0 ) {
+        return 0;
+    }
+
+    /* the byte after head is the first free one */
+    start = (head + 1) & UART1_TX_BUFFER_MASK;
+    chunk = UART1_TX_BUFFER_SIZE - start;
+    if ( chunk > length ) {
+        chunk = length;
+    }
+    memcpy((unsigned char *)UART1_TxBuf + start, bytes, chunk);
+    memcpy((unsigned char *)UART1_TxBuf, bytes + chunk, length - chunk);
+
+    UART_MEMORY_BARRIER();
+    UART_STORE_INDEX(UART1_TxHead, (head + length) & UART1_TX_BUFFER_MASK);
+
+    /* enable UDRE interrupt */
+    UART1_CONTROL    |= _BV(UART1_UDRIE);
+    return length;
+
+}/* uart1_tryWrite */
+
+
+/*************************************************************************
+Function: uart1_write()
+Purpose:  write bytes to ringbuffer, the calling process is blocked
+          while the buffer is full
+Input:    data to be transmitted and its length
+Returns:  none
+**************************************************************************/
+void uart1_write(const void *data, uint16_t length)
+{
+    const unsigned char *bytes = data;
+    uint16_t written;
+
+
+    while ( (written = uart1_tryWrite(bytes, length)) < length ) {
+        bytes  += written;
+        length -= written;
+
+        /* sleep until the UDRE interrupt has made room */
+        cli();
+        if ( BUFFER_FILLING(UART1_TxHead, UART1_TxTail, UART1_TX_BUFFER_SIZE) > UART1_TX_WAKEUP_LEVEL ) {
+            os_waitOn(&UART1_TxSpaceQueue);
+        }
+        sei();
+    }
+
+}/* uart1_write */
+
+
+/*************************************************************************
+Function: uart1_waitTxDrained()
+Purpose:  block the calling process until the transmit ringbuffer is empty
+Returns:  none
+**************************************************************************/
+void uart1_waitTxDrained(void)
+{
+    uart1_tx_index_t tail;
+
+
+    UART_LOAD_INDEX(tail, UART1_TxTail);
+    if ( UART1_TxHead == tail ) {
+        return;
+    }
+
+    cli();
+    while ( UART1_TxHead != UART1_TxTail ) {
+        os_waitOn(&UART1_TxDrainedQueue);
+        cli();
+    }
+    sei();
+
+}/* uart1_waitTxDrained */
+#endif
+
+
+#if UART1_RX_BUFFER_SIZE > 0
+/*************************************************************************
+Function: uart1_read()
+Purpose:  copy received bytes out of the ringbuffer without waiting
+          with at most two copies and a single tail update
+Input:    buffer for the received bytes and its size
+Returns:  number of bytes copied
+**************************************************************************/
+uint16_t uart1_read(void *buffer, uint16_t length)
+{
+    unsigned char *bytes = buffer;
+    uart1_rx_index_t tail = UART1_RxTail;
+    uart1_rx_index_t head;
+    uint16_t available;
+    uint16_t start;
+    uint16_t chunk;
+
+
+    UART_LOAD_INDEX(head, UART1_RxHead);
+    available = BUFFER_FILLING(head, tail, UART1_RX_BUFFER_SIZE);
+    if ( length > available ) {
+        length = available;
+    }
+    if ( length == 0 ) {
+        return 0;
+    }
+
+    /* the byte after tail is the oldest one */
+    start = (tail + 1) & UART1_RX_BUFFER_MASK;
+    chunk = UART1_RX_BUFFER_SIZE - start;
+    if ( chunk > length ) {
+        chunk = length;
+    }
+    memcpy(bytes, (unsigned char *)UART1_RxBuf + start, chunk);
+    memcpy(bytes + chunk, (unsigned char *)UART1_RxBuf, length - chunk);
+
+    UART_MEMORY_BARRIER();
+    UART_STORE_INDEX(UART1_RxTail, (tail + length) & UART1_RX_BUFFER_MASK);
+    return length;
+
+}/* uart1_read */
+
+
+/*************************************************************************
+Function: uart1_getRxError()
+Purpose:  return and clear the receive errors since the last call
+Returns:  UART_FRAME_ERROR, UART_OVERRUN_ERROR, UART_PARITY_ERROR and
+          UART_BUFFER_OVERFLOW combined, 0 if there was none
+**************************************************************************/
+unsigned int uart1_getRxError(void)
+{
+    unsigned char lastRxError;
+    unsigned char sreg = SREG;
+
+
+    cli();
+    lastRxError = UART1_LastRxError;
+    UART1_LastRxError = 0;
+    SREG = sreg;
+    return lastRxError << 8;
+
+}/* uart1_getRxError */
+#endif
+
+
 //! Extensions by David Thoennessen - proTEC-Vision Automation GmbH ===========
+#if UART1_RX_BUFFER_SIZE > 0
 /*
  * Returns current filling of the buffer in byte
  */
 uint16_t uart1_getrxcount()
 {
-	return BUFFER_FILLING(UART1_RxHead, UART1_RxTail, UART1_RX_BUFFER_SIZE);
+	uart1_rx_index_t head;
+	UART_LOAD_INDEX(head, UART1_RxHead);
+	return BUFFER_FILLING(head, UART1_RxTail, UART1_RX_BUFFER_SIZE);
 }
+#endif
 
+#if UART1_TX_BUFFER_SIZE > 0
 /*
  * Returns current filling of the buffer in byte
  */
 uint16_t uart1_gettxcount()
 {
-	return BUFFER_FILLING(UART1_TxHead, UART1_TxTail, UART1_TX_BUFFER_SIZE);
+	uart1_tx_index_t tail;
+	UART_LOAD_INDEX(tail, UART1_TxTail);
+	return BUFFER_FILLING(UART1_TxHead, tail, UART1_TX_BUFFER_SIZE);
 }
+#endif
 
 /*
  * Disables the RX/TX ports to not provide the connected device with energy
@@ -956,6 +1394,30 @@ void uart1_disable()
 	cbi(UART1_CONTROL, UART1_BIT_RXEN);
 	cbi(UART1_CONTROL, UART1_BIT_TXEN);
 }
+
+#if UART1_RX_BUFFER_SIZE > 0 || UART1_TX_BUFFER_SIZE > 0
+/*
+ * Copies the statistics of the port
+ */
+void uart1_getStats(uart_stats_t *stats)
+{
+	unsigned char sreg = SREG;
+	cli();
+	memcpy(stats, (uart_stats_t *)&UART1_Stats, sizeof(uart_stats_t));
+	SREG = sreg;
+}
+
+/*
+ * Sets all statistics of the port to 0
+ */
+void uart1_resetStats()
+{
+	unsigned char sreg = SREG;
+	cli();
+	memset((uart_stats_t *)&UART1_Stats, 0, sizeof(uart_stats_t));
+	SREG = sreg;
+}
+#endif
 //! ===========================================================================
 #endif
 
@@ -965,16 +1427,18 @@ void uart1_disable()
  */
 #if defined( ATMEGA_USART2 )
 
+#if UART2_RX_BUFFER_SIZE > 0
 ISR(UART2_RECEIVE_INTERRUPT)
 /*************************************************************************
 Function: UART2 Receive Complete interrupt
 Purpose:  called when the UART2 has received a character
 **************************************************************************/
 {
-    unsigned char tmphead;
+    uart2_rx_index_t tmphead;
     unsigned char data;
     unsigned char usr;
     unsigned char lastRxError;
+    uint16_t filling;
  
  
     /* read UART status register and UART data register */ 
@@ -984,25 +1448,42 @@ Purpose:  called when the UART2 has received a character
     /* get FEn (Frame Error) DORn (Data OverRun) UPEn (USART Parity Error) bits */
     lastRxError = usr & (_BV(FE1)|_BV(DOR1)|_BV(UPE1) );
             
+    /* count received bytes and errors */
+    UART2_Stats.bytesReceived++;
+    if ( lastRxError & (UART_OVERRUN_ERROR >> 8) ) {
+        UART2_Stats.overruns++;
+    }
+    if ( lastRxError & (UART_FRAME_ERROR >> 8) ) {
+        UART2_Stats.frameErrors++;
+    }
+
     /* calculate buffer index */ 
     tmphead = ( UART2_RxHead + 1) & UART2_RX_BUFFER_MASK;
     
     if ( tmphead == UART2_RxTail ) {
         /* error: receive buffer overflow */
         lastRxError = UART_BUFFER_OVERFLOW >> 8;
+        UART2_Stats.bufferOverflows++;
     }else{
         /* store new index */
         UART2_RxHead = tmphead;
         /* store received data in buffer */
         UART2_RxBuf[tmphead] = data;
+        /* remember the highest filling */
+        filling = BUFFER_FILLING(tmphead, UART2_RxTail, UART2_RX_BUFFER_SIZE);
+        if ( filling > UART2_Stats.rxPeak ) {
+            UART2_Stats.rxPeak = filling;
+        }
     }
     UART2_LastRxError |= lastRxError;   
 }
+#endif
 
+#if UART2_TX_BUFFER_SIZE > 0
 /* -- Modifications by FH Aachen -- */
 void uart2_flush_blocking()
 {
-    unsigned char tmptail;
+    uart2_tx_index_t tmptail;
 
     while ( UART2_TxHead != UART2_TxTail)
     {
@@ -1012,30 +1493,41 @@ void uart2_flush_blocking()
         UART2_TxTail = tmptail;
         /* get one byte from buffer and write it to UART */
         UART2_DATA = UART2_TxBuf[tmptail];  /* start transmission */
+        UART2_Stats.bytesSent++;
     }
 }
 /* --------------------------------*/
+#endif
 
+#if UART2_TX_BUFFER_SIZE > 0
 ISR(UART2_TRANSMIT_INTERRUPT)
 /*************************************************************************
 Function: UART2 Data Register Empty interrupt
 Purpose:  called when the UART2 is ready to transmit the next byte
 **************************************************************************/
 {
-    unsigned char tmptail;
+    uart2_tx_index_t tmptail;
+    uint16_t filling;
 
     
     if ( UART2_TxHead != UART2_TxTail) {
+        /* remember the highest filling */
+        filling = BUFFER_FILLING(UART2_TxHead, UART2_TxTail, UART2_TX_BUFFER_SIZE);
+        if ( filling > UART2_Stats.txPeak ) {
+            UART2_Stats.txPeak = filling;
+        }
         /* calculate and store new buffer index */
         tmptail = (UART2_TxTail + 1) & UART2_TX_BUFFER_MASK;
         UART2_TxTail = tmptail;
         /* get one byte from buffer and write it to UART */
         UART2_DATA = UART2_TxBuf[tmptail];  /* start transmission */
+        UART2_Stats.bytesSent++;
     }else{
         /* tx buffer empty, disable UDRE interrupt */
         UART2_CONTROL &= ~_BV(UART2_UDRIE);
     }
 }
+#endif
 
 
 /*************************************************************************
@@ -1046,10 +1538,14 @@ Returns:  none
 **************************************************************************/
 void uart2_init(unsigned int baudrate)
 {
+#if UART2_TX_BUFFER_SIZE > 0
     UART2_TxHead = 0;
     UART2_TxTail = 0;
+#endif
+#if UART2_RX_BUFFER_SIZE > 0
     UART2_RxHead = 0;
     UART2_RxTail = 0;
+#endif
 
 #ifdef UART_TEST
 #ifndef UART2_BIT_U2X
@@ -1068,18 +1564,15 @@ void uart2_init(unsigned int baudrate)
 #endif
 #endif
 
-    /* Set baud rate */
-    if ( baudrate & 0x8000 ) 
-    {
-        #if UART2_BIT_U2X
-    	UART2_STATUS = (1<<UART2_BIT_U2X);  //Enable 2x speed 
-        #endif
-    }
-    UART2_UBRRH = (unsigned char)((baudrate>>8)&0x80) ;
+    /* Set baud rate, double speed is switched off again if it is not requested */
+    #if UART2_BIT_U2X
+    UART2_STATUS = ( baudrate & 0x8000 ) ? (1<<UART2_BIT_U2X) : 0;
+    #endif
+    UART2_UBRRH = (unsigned char)((baudrate>>8)&0x0F) ;
     UART2_UBRRL = (unsigned char) baudrate;
         
-    /* Enable USART receiver and transmitter and receive complete interrupt */
-    UART2_CONTROL = _BV(UART2_BIT_RXCIE)|(1<<UART2_BIT_RXEN)|(1<<UART2_BIT_TXEN);    
+    /* Enable USART receiver and receive complete interrupt and transmitter, as far as they have a buffer */
+    UART2_CONTROL = UART2_RX_ENABLE|UART2_TX_ENABLE;    
     
     /* Set frame format: asynchronous, 8data, no parity, 1stop bit */   
     #ifdef UART2_BIT_URSEL
@@ -1091,6 +1584,7 @@ void uart2_init(unsigned int baudrate)
 }/* uart2_init */
 
 
+#if UART2_RX_BUFFER_SIZE > 0
 /*************************************************************************
 Function: uart2_getc()
 Purpose:  return byte from ringbuffer  
@@ -1099,12 +1593,14 @@ Returns:  lower byte:  received byte from ringbuffer
 **************************************************************************/
 unsigned int uart2_getc(void)
 {    
-    unsigned char tmptail;
+    uart2_rx_index_t tmptail;
+    uart2_rx_index_t head;
     unsigned int  data;
     unsigned char lastRxError;
 
 
-    if ( UART2_RxHead == UART2_RxTail ) {
+    UART_LOAD_INDEX(head, UART2_RxHead);
+    if ( head == UART2_RxTail ) {
         return UART_NO_DATA;   /* no data available */
     }
     
@@ -1116,14 +1612,16 @@ unsigned int uart2_getc(void)
     lastRxError = UART2_LastRxError;
     
     /* store buffer index */
-    UART2_RxTail = tmptail; 
+    UART_STORE_INDEX(UART2_RxTail, tmptail);
     
     UART2_LastRxError = 0;
     return (lastRxError << 8) + data;
 
 }/* uart2_getc */
+#endif
 
 
+#if UART2_TX_BUFFER_SIZE > 0
 /*************************************************************************
 Function: uart2_putc()
 Purpose:  write byte to ringbuffer for transmitting via UART2
@@ -1132,17 +1630,19 @@ Returns:  none
 **************************************************************************/
 void uart2_putc(unsigned char data)
 {
-    unsigned char tmphead;
+    uart2_tx_index_t tmphead;
+    uart2_tx_index_t tail;
 
     
     tmphead  = (UART2_TxHead + 1) & UART2_TX_BUFFER_MASK;
     
-    while ( tmphead == UART2_TxTail ){
-        ;/* wait for free space in buffer */
-    }
+    do {
+        /* wait for free space in buffer */
+        UART_LOAD_INDEX(tail, UART2_TxTail);
+    } while ( tmphead == tail );
     
     UART2_TxBuf[tmphead] = data;
-    UART2_TxHead = tmphead;
+    UART_STORE_INDEX(UART2_TxHead, tmphead);
 
     /* enable UDRE interrupt */
     UART2_CONTROL    |= _BV(UART2_UDRIE);
@@ -1178,24 +1678,33 @@ void uart2_puts_p(const char *progmem_s )
       uart2_putc(c);
 
 }/* uart2_puts_p */
+#endif
 
 
 //! Extensions by David Thoennessen - proTEC-Vision Automation GmbH ===========
+#if UART2_RX_BUFFER_SIZE > 0
 /*
  * Returns current filling of the buffer in byte
  */
 uint16_t uart2_getrxcount()
 {
-	return BUFFER_FILLING(UART2_RxHead, UART2_RxTail, UART2_RX_BUFFER_SIZE);
+	uart2_rx_index_t head;
+	UART_LOAD_INDEX(head, UART2_RxHead);
+	return BUFFER_FILLING(head, UART2_RxTail, UART2_RX_BUFFER_SIZE);
 }
+#endif
 
+#if UART2_TX_BUFFER_SIZE > 0
 /*
  * Returns current filling of the buffer in byte
  */
 uint16_t uart2_gettxcount()
 {
-	return BUFFER_FILLING(UART2_TxHead, UART2_TxTail, UART2_TX_BUFFER_SIZE);
+	uart2_tx_index_t tail;
+	UART_LOAD_INDEX(tail, UART2_TxTail);
+	return BUFFER_FILLING(UART2_TxHead, tail, UART2_TX_BUFFER_SIZE);
 }
+#endif
 
 /*
  * Disables the RX/TX ports to not provide the connected device with energy
@@ -1205,6 +1714,30 @@ void uart2_disable()
 	cbi(UART2_CONTROL, UART2_BIT_RXEN);
 	cbi(UART2_CONTROL, UART2_BIT_TXEN);
 }
+
+#if UART2_RX_BUFFER_SIZE > 0 || UART2_TX_BUFFER_SIZE > 0
+/*
+ * Copies the statistics of the port
+ */
+void uart2_getStats(uart_stats_t *stats)
+{
+	unsigned char sreg = SREG;
+	cli();
+	memcpy(stats, (uart_stats_t *)&UART2_Stats, sizeof(uart_stats_t));
+	SREG = sreg;
+}
+
+/*
+ * Sets all statistics of the port to 0
+ */
+void uart2_resetStats()
+{
+	unsigned char sreg = SREG;
+	cli();
+	memset((uart_stats_t *)&UART2_Stats, 0, sizeof(uart_stats_t));
+	SREG = sreg;
+}
+#endif
 //! ===========================================================================
 #endif
 
@@ -1214,16 +1747,18 @@ void uart2_disable()
  */
 #if defined( ATMEGA_USART3 )
 
+#if UART3_RX_BUFFER_SIZE > 0
 ISR(UART3_RECEIVE_INTERRUPT)
 /*************************************************************************
 Function: UART3 Receive Complete interrupt
 Purpose:  called when the UART3 has received a character
 **************************************************************************/
 {
-    unsigned char tmphead;
+    uart3_rx_index_t tmphead;
     unsigned char data;
     unsigned char usr;
     unsigned char lastRxError;
+    uint16_t filling;
  
  
     /* read UART status register and UART data register */ 
@@ -1233,42 +1768,67 @@ Purpose:  called when the UART3 has received a character
     /* get FEn (Frame Error) DORn (Data OverRun) UPEn (USART Parity Error) bits */
     lastRxError = usr & (_BV(FE1)|_BV(DOR1)|_BV(UPE1) );
             
+    /* count received bytes and errors */
+    UART3_Stats.bytesReceived++;
+    if ( lastRxError & (UART_OVERRUN_ERROR >> 8) ) {
+        UART3_Stats.overruns++;
+    }
+    if ( lastRxError & (UART_FRAME_ERROR >> 8) ) {
+        UART3_Stats.frameErrors++;
+    }
+
     /* calculate buffer index */ 
     tmphead = ( UART3_RxHead + 1) & UART3_RX_BUFFER_MASK;
     
     if ( tmphead == UART3_RxTail ) {
         /* error: receive buffer overflow */
         lastRxError = UART_BUFFER_OVERFLOW >> 8;
+        UART3_Stats.bufferOverflows++;
     }else{
         /* store new index */
         UART3_RxHead = tmphead;
         /* store received data in buffer */
         UART3_RxBuf[tmphead] = data;
+        /* remember the highest filling */
+        filling = BUFFER_FILLING(tmphead, UART3_RxTail, UART3_RX_BUFFER_SIZE);
+        if ( filling > UART3_Stats.rxPeak ) {
+            UART3_Stats.rxPeak = filling;
+        }
     }
     UART3_LastRxError |= lastRxError;   
 }
+#endif
 
 
+#if UART3_TX_BUFFER_SIZE > 0
 ISR(UART3_TRANSMIT_INTERRUPT)
 /*************************************************************************
 Function: UART3 Data Register Empty interrupt
 Purpose:  called when the UART3 is ready to transmit the next byte
 **************************************************************************/
 {
-    unsigned char tmptail;
+    uart3_tx_index_t tmptail;
+    uint16_t filling;
 
     
     if ( UART3_TxHead != UART3_TxTail) {
+        /* remember the highest filling */
+        filling = BUFFER_FILLING(UART3_TxHead, UART3_TxTail, UART3_TX_BUFFER_SIZE);
+        if ( filling > UART3_Stats.txPeak ) {
+            UART3_Stats.txPeak = filling;
+        }
         /* calculate and store new buffer index */
         tmptail = (UART3_TxTail + 1) & UART3_TX_BUFFER_MASK;
         UART3_TxTail = tmptail;
         /* get one byte from buffer and write it to UART */
         UART3_DATA = UART3_TxBuf[tmptail];  /* start transmission */
+        UART3_Stats.bytesSent++;
     }else{
         /* tx buffer empty, disable UDRE interrupt */
         UART3_CONTROL &= ~_BV(UART3_UDRIE);
     }
 }
+#endif
 
 
 /*************************************************************************
@@ -1279,10 +1839,14 @@ Returns:  none
 **************************************************************************/
 void uart3_init(unsigned int baudrate)
 {
+#if UART3_TX_BUFFER_SIZE > 0
     UART3_TxHead = 0;
     UART3_TxTail = 0;
+#endif
+#if UART3_RX_BUFFER_SIZE > 0
     UART3_RxHead = 0;
     UART3_RxTail = 0;
+#endif
 
 #ifdef UART_TEST
 #ifndef UART3_BIT_U2X
@@ -1301,18 +1865,15 @@ void uart3_init(unsigned int baudrate)
 #endif
 #endif
 
-    /* Set baud rate */
-    if ( baudrate & 0x8000 ) 
-    {
-        #if UART3_BIT_U2X
-    	UART3_STATUS = (1<<UART3_BIT_U2X);  //Enable 2x speed 
-        #endif
-    }
-    UART3_UBRRH = (unsigned char)((baudrate>>8)&0x80) ;
+    /* Set baud rate, double speed is switched off again if it is not requested */
+    #if UART3_BIT_U2X
+    UART3_STATUS = ( baudrate & 0x8000 ) ? (1<<UART3_BIT_U2X) : 0;
+    #endif
+    UART3_UBRRH = (unsigned char)((baudrate>>8)&0x0F) ;
     UART3_UBRRL = (unsigned char) baudrate;
         
-    /* Enable USART receiver and transmitter and receive complete interrupt */
-    UART3_CONTROL = _BV(UART3_BIT_RXCIE)|(1<<UART3_BIT_RXEN)|(1<<UART3_BIT_TXEN);    
+    /* Enable USART receiver and receive complete interrupt and transmitter, as far as they have a buffer */
+    UART3_CONTROL = UART3_RX_ENABLE|UART3_TX_ENABLE;    
     
     /* Set frame format: asynchronous, 8data, no parity, 1stop bit */   
     #ifdef UART3_BIT_URSEL
@@ -1324,6 +1885,7 @@ void uart3_init(unsigned int baudrate)
 }/* uart3_init */
 
 
+#if UART3_RX_BUFFER_SIZE > 0
 /*************************************************************************
 Function: uart3_getc()
 Purpose:  return byte from ringbuffer  
@@ -1332,12 +1894,14 @@ Returns:  lower byte:  received byte from ringbuffer
 **************************************************************************/
 unsigned int uart3_getc(void)
 {    
-    unsigned char tmptail;
+    uart3_rx_index_t tmptail;
+    uart3_rx_index_t head;
     unsigned int  data;
     unsigned char lastRxError;
 
 
-    if ( UART3_RxHead == UART3_RxTail ) {
+    UART_LOAD_INDEX(head, UART3_RxHead);
+    if ( head == UART3_RxTail ) {
         return UART_NO_DATA;   /* no data available */
     }
     
@@ -1349,14 +1913,16 @@ unsigned int uart3_getc(void)
     lastRxError = UART3_LastRxError;
     
     /* store buffer index */
-    UART3_RxTail = tmptail; 
+    UART_STORE_INDEX(UART3_RxTail, tmptail);
     
     UART3_LastRxError = 0;
     return (lastRxError << 8) + data;
 
 }/* uart3_getc */
+#endif
 
 
+#if UART3_TX_BUFFER_SIZE > 0
 /*************************************************************************
 Function: uart3_putc()
 Purpose:  write byte to ringbuffer for transmitting via UART3
@@ -1365,17 +1931,19 @@ Returns:  none
 **************************************************************************/
 void uart3_putc(unsigned char data)
 {
-    unsigned char tmphead;
+    uart3_tx_index_t tmphead;
+    uart3_tx_index_t tail;
 
     
     tmphead  = (UART3_TxHead + 1) & UART3_TX_BUFFER_MASK;
     
-    while ( tmphead == UART3_TxTail ){
-        ;/* wait for free space in buffer */
-    }
+    do {
+        /* wait for free space in buffer */
+        UART_LOAD_INDEX(tail, UART3_TxTail);
+    } while ( tmphead == tail );
     
     UART3_TxBuf[tmphead] = data;
-    UART3_TxHead = tmphead;
+    UART_STORE_INDEX(UART3_TxHead, tmphead);
 
     /* enable UDRE interrupt */
     UART3_CONTROL    |= _BV(UART3_UDRIE);
@@ -1411,24 +1979,33 @@ void uart3_puts_p(const char *progmem_s )
       uart3_putc(c);
 
 }/* uart3_puts_p */
+#endif
 
 
 //! Extensions by David Thoennessen - proTEC-Vision Automation GmbH ===========
+#if UART3_RX_BUFFER_SIZE > 0
 /*
  * Returns current filling of the buffer in byte
  */
 uint16_t uart3_getrxcount()
 {
-	return BUFFER_FILLING(UART3_RxHead, UART3_RxTail, UART3_RX_BUFFER_SIZE);
+	uart3_rx_index_t head;
+	UART_LOAD_INDEX(head, UART3_RxHead);
+	return BUFFER_FILLING(head, UART3_RxTail, UART3_RX_BUFFER_SIZE);
 }
+#endif
 
+#if UART3_TX_BUFFER_SIZE > 0
 /*
  * Returns current filling of the buffer in byte
  */
 uint16_t uart3_gettxcount()
 {
-	return BUFFER_FILLING(UART3_TxHead, UART3_TxTail, UART3_TX_BUFFER_SIZE);
+	uart3_tx_index_t tail;
+	UART_LOAD_INDEX(tail, UART3_TxTail);
+	return BUFFER_FILLING(UART3_TxHead, tail, UART3_TX_BUFFER_SIZE);
 }
+#endif
 
 /*
  * Disables the RX/TX ports to not provide the connected device with energy
@@ -1438,6 +2015,111 @@ void uart3_disable()
 	cbi(UART3_CONTROL, UART3_BIT_RXEN);
 	cbi(UART3_CONTROL, UART3_BIT_TXEN);
 }
+
+#if UART3_RX_BUFFER_SIZE > 0 || UART3_TX_BUFFER_SIZE > 0
+/*
+ * Copies the statistics of the port
+ */
+void uart3_getStats(uart_stats_t *stats)
+{
+	unsigned char sreg = SREG;
+	cli();
+	memcpy(stats, (uart_stats_t *)&UART3_Stats, sizeof(uart_stats_t));
+	SREG = sreg;
+}
+
+/*
+ * Sets all statistics of the port to 0
+ */
+void uart3_resetStats()
+{
+	unsigned char sreg = SREG;
+	cli();
+	memset((uart_stats_t *)&UART3_Stats, 0, sizeof(uart_stats_t));
+	SREG = sreg;
+}
+#endif
 //! ===========================================================================
 
 #endif
+
+
+//! Statistics of all ports =====================================================================
+/*
+ * Prints the statistics of all ports that have a buffer to the terminal
+ */
+void uart_printStats()
+{
+	uart_stats_t stats;
+
+	for (unsigned char port = 0; port < 4; port++)
+	{
+		switch (port)
+		{
+#if UART0_RX_BUFFER_SIZE > 0 || UART0_TX_BUFFER_SIZE > 0
+			case 0: uart0_getStats(&stats); break;
+#endif
+#if defined( ATMEGA_USART1 ) && ( UART1_RX_BUFFER_SIZE > 0 || UART1_TX_BUFFER_SIZE > 0 )
+			case 1: uart1_getStats(&stats); break;
+#endif
+#if defined( ATMEGA_USART2 ) && ( UART2_RX_BUFFER_SIZE > 0 || UART2_TX_BUFFER_SIZE > 0 )
+			case 2: uart2_getStats(&stats); break;
+#endif
+#if defined( ATMEGA_USART3 ) && ( UART3_RX_BUFFER_SIZE > 0 || UART3_TX_BUFFER_SIZE > 0 )
+			case 3: uart3_getStats(&stats); break;
+#endif
+			default: continue;
+		}
+
+		INFO("UART%u: rx %lu B, tx %lu B, overruns %u, frame errors %u, overflows %u, peak rx %u B, peak tx %u B",
+			 port,
+			 (unsigned long)stats.bytesReceived,
+			 (unsigned long)stats.bytesSent,
+			 stats.overruns,
+			 stats.frameErrors,
+			 stats.bufferOverflows,
+			 stats.rxPeak,
+			 stats.txPeak);
+	}
+}
+
+
+//! Baudrate calculation =======================================================================
+/*
+ * Returns the deviation of the baudrate that results from ubrr in 0.1 %
+ */
+static int16_t uart_baudrateError(uint32_t baudrate, uint16_t ubrr, uint8_t samples)
+{
+	uint32_t actual = F_CPU / ((uint32_t)samples * (ubrr + 1));
+	return (int16_t)(((int32_t)actual - (int32_t)baudrate) * 1000 / (int32_t)baudrate);
+}
+
+/*
+ * Returns the UBRR setting that comes closest to the baudrate at F_CPU, with
+ * 0x8000 set if double speed is needed for it
+ */
+unsigned int uart_selectBaudrate(uint32_t baudrate, int16_t *error)
+{
+	uint32_t normal = UART_BAUD_SELECT(baudrate, F_CPU);
+	uint32_t doubleSpeed = UART_BAUD_SELECT_DOUBLE_SPEED(baudrate, F_CPU) & 0x7FFF;
+
+	/* UBRR has 12 bits */
+	if (normal > 0x0FFF)
+		normal = 0x0FFF;
+	if (doubleSpeed > 0x0FFF)
+		doubleSpeed = 0x0FFF;
+
+	int16_t normalError = uart_baudrateError(baudrate, normal, 16);
+	int16_t doubleError = uart_baudrateError(baudrate, doubleSpeed, 8);
+
+	if (abs(doubleError) < abs(normalError))
+	{
+		if (error)
+			*error = doubleError;
+		return doubleSpeed | 0x8000;
+	}
+
+	if (error)
+		*error = normalError;
+	return normal;
+}
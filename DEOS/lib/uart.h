@@ -83,77 +83,8 @@ void uart2_flush_blocking();
  */
 #define UART_BAUD_SELECT_DOUBLE_SPEED(baudRate,xtalCpu) ( ((((xtalCpu) + 4UL * (baudRate)) / (8UL * (baudRate)) -1UL)) | 0x8000)
 
-/** @brief  Size of the UART0 circular receive buffer, must be power of 2, and <= 256
- * 
- *  You may need to adapt this constant to your target and your application by adding 
- *  CDEFS += -DUART_RX_BUFFER_SIZE=nn to your Makefile.
- */
-#ifndef UART0_RX_BUFFER_SIZE
-#define UART0_RX_BUFFER_SIZE 0
-#endif
-
-/** @brief  Size of the UART0 circular transmit buffer, must be power of 2, and <= 256
- *
- *  You may need to adapt this constant to your target and your application by adding 
- *  CDEFS += -DUART_TX_BUFFER_SIZE=nn to your Makefile.
- */
-#ifndef UART0_TX_BUFFER_SIZE
-#define UART0_TX_BUFFER_SIZE 0
-#endif
-
-/** @brief  Size of the UART1 circular receive buffer, must be power of 2, and <= 256
- * 
- *  You may need to adapt this constant to your target and your application by adding 
- *  CDEFS += -DUART_RX_BUFFER_SIZE=nn to your Makefile.
- */
-#ifndef UART1_RX_BUFFER_SIZE
-#define UART1_RX_BUFFER_SIZE 256
-#endif
-
-/** @brief  Size of the UART1 circular transmit buffer, must be power of 2, and <= 256
- *
- *  You may need to adapt this constant to your target and your application by adding 
- *  CDEFS += -DUART_TX_BUFFER_SIZE=nn to your Makefile.
- */
-#ifndef UART1_TX_BUFFER_SIZE
-#define UART1_TX_BUFFER_SIZE 64
-#endif
-
-/** @brief  Size of the UART2 circular receive buffer, must be power of 2, and <= 256
- * 
- *  You may need to adapt this constant to your target and your application by adding 
- *  CDEFS += -DUART_RX_BUFFER_SIZE=nn to your Makefile.
- */
-#ifndef UART2_RX_BUFFER_SIZE
-#define UART2_RX_BUFFER_SIZE 0
-#endif
-
-/** @brief  Size of the UART2 circular transmit buffer, must be power of 2, and <= 256
- *
- *  You may need to adapt this constant to your target and your application by adding 
- *  CDEFS += -DUART_TX_BUFFER_SIZE=nn to your Makefile.
- */
-#ifndef UART2_TX_BUFFER_SIZE
-#define UART2_TX_BUFFER_SIZE 64 //fr Testtask sonst 0
-#endif
-
-/** @brief  Size of the UART3 circular receive buffer, must be power of 2, and <= 256
- * 
- *  You may need to adapt this constant to your target and your application by adding 
- *  CDEFS += -DUART_RX_BUFFER_SIZE=nn to your Makefile.
- */
-#ifndef UART3_RX_BUFFER_SIZE
-#define UART3_RX_BUFFER_SIZE 64 //fr Testtask sonst 0
-#endif
-
-/** @brief  Size of the UART3 circular transmit buffer, must be power of 2, and <= 256
- *
- *  You may need to adapt this constant to your target and your application by adding 
- *  CDEFS += -DUART_TX_BUFFER_SIZE=nn to your Makefile.
- */
-#ifndef UART3_TX_BUFFER_SIZE
-#define UART3_TX_BUFFER_SIZE 0
-#endif
+/* The sizes of the circular buffers of every port are chosen in uart_config.h */
+#include "uart_config.h"
 
 /* test if the size of the circular buffers fits into SRAM */
 #if ( (UART0_RX_BUFFER_SIZE + UART0_TX_BUFFER_SIZE + \
@@ -172,6 +103,20 @@ void uart2_flush_blocking();
 #define UART_BUFFER_OVERFLOW  0x0200              /**< @brief receive ringbuffer overflow */
 #define UART_NO_DATA          0x0100              /**< @brief no receive data available   */
 
+/* -- Modifications by FH Aachen -- */
+/** @brief  Statistics of one USART, maintained by its interrupt handlers */
+typedef struct UartStats
+{
+    uint32_t bytesReceived;   /**< @brief bytes received, including dropped ones        */
+    uint32_t bytesSent;       /**< @brief bytes handed to the USART                     */
+    uint16_t overruns;        /**< @brief bytes lost before the ISR could fetch them    */
+    uint16_t frameErrors;     /**< @brief bytes received with a framing error           */
+    uint16_t bufferOverflows; /**< @brief bytes dropped as the receive ringbuffer was full */
+    uint16_t rxPeak;          /**< @brief highest filling of the receive ringbuffer     */
+    uint16_t txPeak;          /**< @brief highest filling of the transmit ringbuffer    */
+} uart_stats_t;
+/* --------------------------------*/
+
 
 /*
 ** function prototypes
@@ -266,6 +211,43 @@ extern void uart1_puts_p(const char *s );
 /** @brief  Macro to automatically put a string constant into program memory */
 #define uart1_puts_P(__s)       uart1_puts_p(PSTR(__s))
 
+/* -- Modifications by FH Aachen -- */
+/**
+ *  @brief   Put as many bytes into the USART1 ringbuffer as fit without waiting
+ *  @param   data bytes to be transmitted
+ *  @param   length number of bytes to be transmitted
+ *  @return  number of bytes accepted, the rest has to be written again later
+ */
+extern uint16_t uart1_tryWrite(const void *data, uint16_t length);
+/**
+ *  @brief   Put bytes into the USART1 ringbuffer
+ *
+ *  The calling process is blocked while the ringbuffer is full and woken by the
+ *  transmit interrupt once it has drained to half its size, so other processes
+ *  run meanwhile. Inside a critical section the function busy-waits instead.
+ *
+ *  @param   data bytes to be transmitted
+ *  @param   length number of bytes to be transmitted
+ */
+extern void uart1_write(const void *data, uint16_t length);
+/** @brief  Blocks the calling process until the USART1 transmit ringbuffer is empty */
+extern void uart1_waitTxDrained(void);
+/**
+ *  @brief   Copy received bytes out of the USART1 ringbuffer without waiting
+ *  @param   buffer destination of the received bytes
+ *  @param   length maximum number of bytes to be copied
+ *  @return  number of bytes copied
+ *  @see     uart1_getRxError
+ */
+extern uint16_t uart1_read(void *buffer, uint16_t length);
+/**
+ *  @brief   Get and clear the receive errors of USART1 since the last call
+ *  @return  combination of UART_FRAME_ERROR, UART_OVERRUN_ERROR,
+ *           UART_PARITY_ERROR and UART_BUFFER_OVERFLOW, 0 if there was none
+ */
+extern unsigned int uart1_getRxError(void);
+/* --------------------------------*/
+
 /** @brief  Initialize USART2 (only available on selected ATmegas) @see uart_init */
 extern void uart2_init(unsigned int baudrate);
 /** @brief  Get received byte of USART2 from ringbuffer. (only available on selected ATmega) @see uart_getc */
@@ -323,6 +305,41 @@ extern void uart2_disable();
 //! Disables the RX/TX ports to not provide the connected device with energy
 extern void uart3_disable();
 
+/* -- Modifications by FH Aachen -- */
+//! Copies the statistics of the port (only available if the port has a buffer)
+extern void uart0_getStats(uart_stats_t *stats);
+//! Copies the statistics of the port (only available if the port has a buffer)
+extern void uart1_getStats(uart_stats_t *stats);
+//! Copies the statistics of the port (only available if the port has a buffer)
+extern void uart2_getStats(uart_stats_t *stats);
+//! Copies the statistics of the port (only available if the port has a buffer)
+extern void uart3_getStats(uart_stats_t *stats);
+
+//! Sets all statistics of the port to 0
+extern void uart0_resetStats();
+//! Sets all statistics of the port to 0
+extern void uart1_resetStats();
+//! Sets all statistics of the port to 0
+extern void uart2_resetStats();
+//! Sets all statistics of the port to 0
+extern void uart3_resetStats();
+
+//! Prints the statistics of all ports that have a buffer to the terminal
+extern void uart_printStats();
+
+/**
+ *  @brief   Calculate the UBRR setting that comes closest to the baudrate at F_CPU
+ *
+ *  Normal and double speed mode are compared and the one with the smaller
+ *  deviation is taken, on a tie normal speed as it samples each bit more often.
+ *
+ *  @param   baudrate baudrate in bps, e.g. 115200
+ *  @param   error deviation of the resulting baudrate in 0.1 %, may be NULL
+ *  @return  value for uartN_init(), with 0x8000 set for double speed
+ */
+extern unsigned int uart_selectBaudrate(uint32_t baudrate, int16_t *error);
+/* --------------------------------*/
+
 
 #endif // UART_H 
 
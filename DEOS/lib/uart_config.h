@@ -0,0 +1,111 @@
+/*! \file
+ *  \brief Buffer configuration of the UART library.
+ *
+ *  Every port of the ATmega2560 gets its own receive and transmit buffer
+ *  size. A size of 0 disables that direction of the port completely: neither
+ *  the buffer nor its indices nor its interrupt handler take up any memory.
+ *  Sizes have to be powers of two up to 1024, buffers bigger than 256 bytes
+ *  use 16 bit indices.
+ *
+ *  The sizes are bundled in profiles for the different kinds of applications.
+ *  A profile can be chosen with UART_PROFILE in progs.h or on the command line,
+ *  single sizes can still be overridden with -DUARTn_RX_BUFFER_SIZE=nn.
+ *
+ *  \author   Fachbereich 5 - FH Aachen
+ *  \date     2024
+ *  \version  1.0
+ */
+
+#ifndef UART_CONFIG_H
+#define UART_CONFIG_H
+
+#include "../progs/progs.h"
+
+//----------------------------------------------------------------------------
+// Profiles
+//----------------------------------------------------------------------------
+
+//! Sensor node: XBee on UART1 only
+#define UART_PROFILE_NODE 0
+
+//! Gateway receiving from many nodes: XBee on UART1 with a big receive buffer
+#define UART_PROFILE_GATEWAY 1
+
+//! Bridge between the XBee on UART1 and the USB port on UART2 (TT_CONIFGXBEE)
+#define UART_PROFILE_XBEE_BRIDGE 2
+
+#ifndef UART_PROFILE
+#if defined(TESTTASK_ENABLED) && TESTTASK == TT_CONIFGXBEE
+#define UART_PROFILE UART_PROFILE_XBEE_BRIDGE
+#else
+#define UART_PROFILE UART_PROFILE_NODE
+#endif
+#endif
+
+//----------------------------------------------------------------------------
+// Buffer sizes
+//----------------------------------------------------------------------------
+
+#if UART_PROFILE == UART_PROFILE_NODE
+#define UART_PROFILE_UART1_RX_SIZE 256
+#define UART_PROFILE_UART1_TX_SIZE 64
+#define UART_PROFILE_UART2_RX_SIZE 0
+#define UART_PROFILE_UART2_TX_SIZE 0
+#elif UART_PROFILE == UART_PROFILE_GATEWAY
+#define UART_PROFILE_UART1_RX_SIZE 512
+#define UART_PROFILE_UART1_TX_SIZE 64
+#define UART_PROFILE_UART2_RX_SIZE 0
+#define UART_PROFILE_UART2_TX_SIZE 0
+#elif UART_PROFILE == UART_PROFILE_XBEE_BRIDGE
+#define UART_PROFILE_UART1_RX_SIZE 256
+#define UART_PROFILE_UART1_TX_SIZE 64
+#define UART_PROFILE_UART2_RX_SIZE 64
+#define UART_PROFILE_UART2_TX_SIZE 64
+#else
+#error "Unknown UART_PROFILE"
+#endif
+
+// UART0 and UART3 are not used
+#ifndef UART0_RX_BUFFER_SIZE
+#define UART0_RX_BUFFER_SIZE 0
+#endif
+#ifndef UART0_TX_BUFFER_SIZE
+#define UART0_TX_BUFFER_SIZE 0
+#endif
+
+#ifndef UART1_RX_BUFFER_SIZE
+#define UART1_RX_BUFFER_SIZE UART_PROFILE_UART1_RX_SIZE
+#endif
+#ifndef UART1_TX_BUFFER_SIZE
+#define UART1_TX_BUFFER_SIZE UART_PROFILE_UART1_TX_SIZE
+#endif
+
+// UART2 is driven by lib/terminal.c without buffers unless a profile needs them
+#ifndef UART2_RX_BUFFER_SIZE
+#define UART2_RX_BUFFER_SIZE UART_PROFILE_UART2_RX_SIZE
+#endif
+#ifndef UART2_TX_BUFFER_SIZE
+#define UART2_TX_BUFFER_SIZE UART_PROFILE_UART2_TX_SIZE
+#endif
+
+#ifndef UART3_RX_BUFFER_SIZE
+#define UART3_RX_BUFFER_SIZE 0
+#endif
+#ifndef UART3_TX_BUFFER_SIZE
+#define UART3_TX_BUFFER_SIZE 0
+#endif
+
+//! Memory taken up by all UART buffers
+#define UART_BUFFER_TOTAL_SIZE (UART0_RX_BUFFER_SIZE + UART0_TX_BUFFER_SIZE + \
+                                UART1_RX_BUFFER_SIZE + UART1_TX_BUFFER_SIZE + \
+                                UART2_RX_BUFFER_SIZE + UART2_TX_BUFFER_SIZE + \
+                                UART3_RX_BUFFER_SIZE + UART3_TX_BUFFER_SIZE)
+
+#if UART0_RX_BUFFER_SIZE > 1024 || UART0_TX_BUFFER_SIZE > 1024 || \
+    UART1_RX_BUFFER_SIZE > 1024 || UART1_TX_BUFFER_SIZE > 1024 || \
+    UART2_RX_BUFFER_SIZE > 1024 || UART2_TX_BUFFER_SIZE > 1024 || \
+    UART3_RX_BUFFER_SIZE > 1024 || UART3_TX_BUFFER_SIZE > 1024
+#error "UART buffers may not be bigger than 1024 bytes"
+#endif
+
+#endif
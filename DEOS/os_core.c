@@ -5,6 +5,8 @@
  */
 
 #include "os_core.h"
+#include "os_mempool.h"
+#include "lib/buttons.h"
 #include "lib/defines.h"
 #include "lib/lcd.h"
 #include "lib/stop_watch.h"
@@ -34,7 +36,7 @@ void os_initTimer(void)
 }
 
 /*!
- *  Readies stack, scheduler and heap for first use. Additionally, the LCD is initialized. In order to do those tasks,
+ *  Readies stack, scheduler and memory pools for first use. Additionally, the LCD is initialized. In order to do those tasks,
  *  it calls the subfunction os_initScheduler().
  */
 void os_init()
@@ -47,6 +49,9 @@ void os_init()
 	lcd_init();
 	terminal_init();
 
+	// The buttons share PF0 with the RW pin of the LCD, which is tied to ground
+	buttons_init();
+
 	// display on
 	lcd_displayOn();
 	lcd_clear();
@@ -61,6 +66,9 @@ void os_init()
 	// Security check if the stack crushes global variables
 	assert((uint16_t)&__heap_start < AVR_SRAM_START + STACK_OFFSET, " Stack collides with global vars");
 
+	// The memory pools use the space between the globals and the stacks
+	os_initMemPools();
+
 	os_initScheduler();
 }
 
@@ -0,0 +1,370 @@
+/*! \file
+ *
+ *  Contains the fixed-size memory pools that are used for frames, sensor
+ *  records and GUI elements instead of large globals and stack arrays.
+ *
+ */
+
+#include "os_mempool.h"
+#include "os_core.h"
+#include "os_scheduler.h"
+#include "communication/sensorData.h"
+#include "communication/serialAdapter.h"
+#include "gui/gui.h"
+#include "lib/defines.h"
+#include "lib/terminal.h"
+#include "lib/util.h"
+
+#include <avr/pgmspace.h>
+
+// Every pooled type has to fit into a block of its pool, otherwise it would be served by a bigger pool or not at all
+_Static_assert(sizeof(sensor_data_t) <= MEMPOOL_SENSOR_BLOCK_SIZE, "sensor_data_t does not fit into MEMPOOL_SENSOR_BLOCK_SIZE");
+_Static_assert(sizeof(frame_t) <= MEMPOOL_FRAME_BLOCK_SIZE, "frame_t does not fit into MEMPOOL_FRAME_BLOCK_SIZE");
+_Static_assert(sizeof(gui_element_container_t) <= MEMPOOL_GUI_BLOCK_SIZE, "gui_element_container_t does not fit into MEMPOOL_GUI_BLOCK_SIZE");
+
+//! Marks the end of a free list
+#define MEMPOOL_NO_BLOCK 255
+
+//----------------------------------------------------------------------------
+// Types
+//----------------------------------------------------------------------------
+
+//! Bookkeeping of a single block (kept outside of the block itself)
+typedef struct MemPoolBlock
+{
+	uint8_t next;       //!< Next free block (global index), only valid while free
+	process_id_t owner; //!< Owning process or INVALID_PROCESS for shared blocks
+	uint8_t size;       //!< Requested size, 0 if the block is free
+} mempool_block_t;
+
+//! Runtime state of one pool
+typedef struct MemPool
+{
+	uint8_t *start;        //!< Address of the first block
+	uint8_t freeHead;      //!< First free block (global index)
+	uint8_t usedBlocks;    //!< Number of allocated blocks
+	uint8_t peakBlocks;    //!< High water mark of usedBlocks
+	uint16_t usedBytes;    //!< Sum of the requested sizes
+	uint16_t failedAllocs; //!< Number of failed requests
+} mempool_t;
+
+//----------------------------------------------------------------------------
+// Globals
+//----------------------------------------------------------------------------
+
+//! Block sizes of the pools, ordered ascending
+static uint8_t const mempool_blockSize[MEMPOOL_CLASS_COUNT] PROGMEM = {
+	MEMPOOL_SENSOR_BLOCK_SIZE,
+	MEMPOOL_FRAME_BLOCK_SIZE,
+	MEMPOOL_GUI_BLOCK_SIZE};
+
+//! Number of blocks per pool
+static uint8_t const mempool_blockCount[MEMPOOL_CLASS_COUNT] PROGMEM = {
+	MEMPOOL_SENSOR_BLOCK_COUNT,
+	MEMPOOL_FRAME_BLOCK_COUNT,
+	MEMPOOL_GUI_BLOCK_COUNT};
+
+//! Global index of the first block of every pool
+static uint8_t const mempool_firstBlock[MEMPOOL_CLASS_COUNT] PROGMEM = {
+	0,
+	MEMPOOL_SENSOR_BLOCK_COUNT,
+	MEMPOOL_SENSOR_BLOCK_COUNT + MEMPOOL_FRAME_BLOCK_COUNT};
+
+//! Runtime state of all pools
+static mempool_t mempools[MEMPOOL_CLASS_COUNT];
+
+//! Bookkeeping of all blocks
+static mempool_block_t mempool_blocks[MEMPOOL_TOTAL_BLOCK_COUNT];
+
+//----------------------------------------------------------------------------
+// Private functions
+//----------------------------------------------------------------------------
+
+/*!
+ *  Looks up the pool and the global block index of a block address.
+ *  Terminates the OS if the address does not point to the start of a pool block.
+ *
+ *  \param block The address of the block
+ *  \param poolClass Is set to the pool the block belongs to
+ *  \return The global index of the block
+ */
+static uint8_t os_memPoolLookup(void const *block, mempool_class_t *poolClass)
+{
+	uint8_t const *addr = (uint8_t const *)block;
+
+	for (uint8_t p = 0; p < MEMPOOL_CLASS_COUNT; p++)
+	{
+		uint8_t blockSize = pgm_read_byte(&mempool_blockSize[p]);
+		uint16_t offset = (uint16_t)(addr - mempools[p].start);
+
+		if (addr < mempools[p].start || offset >= (uint16_t)blockSize * pgm_read_byte(&mempool_blockCount[p]))
+		{
+			continue;
+		}
+		if (offset % blockSize != 0)
+		{
+			break;
+		}
+		*poolClass = (mempool_class_t)p;
+		return pgm_read_byte(&mempool_firstBlock[p]) + offset / blockSize;
+	}
+
+	os_error("Invalid pool    block %p", block);
+	return MEMPOOL_NO_BLOCK;
+}
+
+/*!
+ *  Puts a block back into the free list of its pool.
+ *  Must be called from within a critical section.
+ *
+ *  \param poolClass The pool the block belongs to
+ *  \param index The global index of the block
+ */
+static void os_memPoolRelease(mempool_class_t poolClass, uint8_t index)
+{
+	mempool_t *pool = &mempools[poolClass];
+
+	pool->usedBlocks--;
+	pool->usedBytes -= mempool_blocks[index].size;
+
+	mempool_blocks[index].size = 0;
+	mempool_blocks[index].owner = INVALID_PROCESS;
+	mempool_blocks[index].next = pool->freeHead;
+	pool->freeHead = index;
+}
+
+//----------------------------------------------------------------------------
+// Public functions
+//----------------------------------------------------------------------------
+
+/*!
+ *  Places the pools directly behind the global variables and links all
+ *  blocks of every pool into its free list. Terminates the OS if the pools
+ *  do not fit below the process stacks.
+ */
+void os_initMemPools(void)
+{
+	uint8_t *start = (uint8_t *)&__heap_start;
+
+	assert((uint16_t)start + MEMPOOL_TOTAL_SIZE <= AVR_SRAM_START + STACK_OFFSET, "Memory pools    collide w. stack");
+
+	for (uint8_t p = 0; p < MEMPOOL_CLASS_COUNT; p++)
+	{
+		uint8_t first = pgm_read_byte(&mempool_firstBlock[p]);
+		uint8_t count = pgm_read_byte(&mempool_blockCount[p]);
+
+		mempools[p].start = start;
+		mempools[p].freeHead = first;
+		mempools[p].usedBlocks = 0;
+		mempools[p].peakBlocks = 0;
+		mempools[p].usedBytes = 0;
+		mempools[p].failedAllocs = 0;
+
+		for (uint8_t i = first; i < first + count; i++)
+		{
+			mempool_blocks[i].next = (i + 1 < first + count) ? i + 1 : MEMPOOL_NO_BLOCK;
+			mempool_blocks[i].owner = INVALID_PROCESS;
+			mempool_blocks[i].size = 0;
+		}
+
+		start += (uint16_t)pgm_read_byte(&mempool_blockSize[p]) * count;
+	}
+
+	INFO("Memory pools: %u bytes at 0x%04x", MEMPOOL_TOTAL_SIZE, (uint16_t)&__heap_start);
+}
+
+/*!
+ *  Allocates a block from the smallest pool whose blocks can hold size bytes.
+ *  If that pool is exhausted, the next bigger pool is tried. The block is
+ *  owned by the calling process and reclaimed when the process is killed.
+ *  The content of the block is not initialized.
+ *
+ *  \param size The number of bytes needed
+ *  \return The address of the block or NULL if no block is available
+ */
+void *os_memPoolAlloc(uint16_t size)
+{
+	if (size == 0)
+	{
+		return NULL;
+	}
+
+	os_enterCriticalSection();
+
+	for (uint8_t p = 0; p < MEMPOOL_CLASS_COUNT; p++)
+	{
+		uint8_t blockSize = pgm_read_byte(&mempool_blockSize[p]);
+		mempool_t *pool = &mempools[p];
+
+		if (size > blockSize)
+		{
+			continue;
+		}
+		if (pool->freeHead == MEMPOOL_NO_BLOCK)
+		{
+			pool->failedAllocs++;
+			continue;
+		}
+
+		uint8_t index = pool->freeHead;
+		pool->freeHead = mempool_blocks[index].next;
+
+		mempool_blocks[index].owner = os_getCurrentProc();
+		mempool_blocks[index].size = (uint8_t)size;
+
+		pool->usedBytes += size;
+		if (++pool->usedBlocks > pool->peakBlocks)
+		{
+			pool->peakBlocks = pool->usedBlocks;
+		}
+
+		os_leaveCriticalSection();
+		return pool->start + (uint16_t)(index - pgm_read_byte(&mempool_firstBlock[p])) * blockSize;
+	}
+
+	os_leaveCriticalSection();
+	return NULL;
+}
+
+/*!
+ *  Returns a block to its pool. Passing NULL has no effect.
+ *  Terminates the OS if the block is invalid or has already been freed.
+ *
+ *  \param block The address returned by os_memPoolAlloc
+ */
+void os_memPoolFree(void *block)
+{
+	if (block == NULL)
+	{
+		return;
+	}
+
+	os_enterCriticalSection();
+
+	mempool_class_t poolClass;
+	uint8_t index = os_memPoolLookup(block, &poolClass);
+
+	if (mempool_blocks[index].size == 0)
+	{
+		os_error("Double free of  block %p", block);
+	}
+
+	os_memPoolRelease(poolClass, index);
+
+	os_leaveCriticalSection();
+}
+
+/*!
+ *  Changes the owner of a block. This is needed if a block is passed on to
+ *  another process, so it is not reclaimed when the allocating process dies.
+ *  Blocks without owner (INVALID_PROCESS) are never reclaimed automatically.
+ *
+ *  \param block The address returned by os_memPoolAlloc
+ *  \param pid The new owner
+ */
+void os_memPoolSetOwner(void *block, process_id_t pid)
+{
+	os_enterCriticalSection();
+
+	mempool_class_t poolClass;
+	uint8_t index = os_memPoolLookup(block, &poolClass);
+
+	if (mempool_blocks[index].size == 0)
+	{
+		os_error("Owner of free   block %p", block);
+	}
+	mempool_blocks[index].owner = pid;
+
+	os_leaveCriticalSection();
+}
+
+/*!
+ *  Frees all blocks that are owned by the passed process.
+ *  This is called by os_kill so terminated processes cannot leak blocks.
+ *
+ *  \param pid The process whose blocks are reclaimed
+ *  \return The number of reclaimed blocks
+ */
+uint8_t os_memPoolFreeOwnedBy(process_id_t pid)
+{
+	uint8_t freed = 0;
+
+	os_enterCriticalSection();
+
+	for (uint8_t p = 0; p < MEMPOOL_CLASS_COUNT; p++)
+	{
+		uint8_t first = pgm_read_byte(&mempool_firstBlock[p]);
+		uint8_t count = pgm_read_byte(&mempool_blockCount[p]);
+
+		for (uint8_t i = first; i < first + count; i++)
+		{
+			if (mempool_blocks[i].size != 0 && mempool_blocks[i].owner == pid)
+			{
+				os_memPoolRelease((mempool_class_t)p, i);
+				freed++;
+			}
+		}
+	}
+
+	os_leaveCriticalSection();
+
+	return freed;
+}
+
+/*!
+ *  Collects the usage statistics of a pool. The longest run of adjacent
+ *  free blocks indicates how scattered the allocated blocks are.
+ *
+ *  \param poolClass The pool to be inspected
+ *  \param stats Is filled with the statistics
+ */
+void os_memPoolGetStats(mempool_class_t poolClass, mempool_stats_t *stats)
+{
+	uint8_t first = pgm_read_byte(&mempool_firstBlock[poolClass]);
+	uint8_t count = pgm_read_byte(&mempool_blockCount[poolClass]);
+	uint8_t run = 0;
+
+	os_enterCriticalSection();
+
+	stats->blockSize = pgm_read_byte(&mempool_blockSize[poolClass]);
+	stats->blockCount = count;
+	stats->usedBlocks = mempools[poolClass].usedBlocks;
+	stats->peakBlocks = mempools[poolClass].peakBlocks;
+	stats->usedBytes = mempools[poolClass].usedBytes;
+	stats->failedAllocs = mempools[poolClass].failedAllocs;
+	stats->largestFreeRun = 0;
+
+	for (uint8_t i = first; i < first + count; i++)
+	{
+		run = (mempool_blocks[i].size == 0) ? run + 1 : 0;
+		if (run > stats->largestFreeRun)
+		{
+			stats->largestFreeRun = run;
+		}
+	}
+
+	os_leaveCriticalSection();
+}
+
+/*!
+ *  Prints the usage statistics of all pools to the terminal. The waste is the
+ *  number of bytes that are allocated but were not requested (internal fragmentation).
+ */
+void os_memPoolPrintStats(void)
+{
+	mempool_stats_t stats;
+
+	for (uint8_t p = 0; p < MEMPOOL_CLASS_COUNT; p++)
+	{
+		os_memPoolGetStats((mempool_class_t)p, &stats);
+		INFO("Pool %u (%u B): used %u/%u, peak %u, waste %u B, free run %u, failed %u",
+			 p,
+			 stats.blockSize,
+			 stats.usedBlocks,
+			 stats.blockCount,
+			 stats.peakBlocks,
+			 (uint16_t)stats.usedBlocks * stats.blockSize - stats.usedBytes,
+			 stats.largestFreeRun,
+			 stats.failedAllocs);
+	}
+}
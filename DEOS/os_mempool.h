@@ -0,0 +1,106 @@
+/*! \file
+ *  \brief Fixed-size memory pools for kernel objects.
+ *
+ *  The pools are carved out of the SRAM between the end of the global
+ *  variables (__heap_start) and the start of the stacks (STACK_OFFSET).
+ *  Every pool consists of equally sized blocks that are kept in a free list,
+ *  so allocating and freeing a block takes constant time and the pools can
+ *  never fragment externally.
+ *
+ *  \author   Fachbereich 5 - FH Aachen
+ *  \date     2024
+ *  \version  1.0
+ */
+
+#ifndef _OS_MEMPOOL_H
+#define _OS_MEMPOOL_H
+
+#include "os_process.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+//----------------------------------------------------------------------------
+// Pool configuration
+//----------------------------------------------------------------------------
+
+//! Block size of the pool for sensor records (sensor_data_t)
+#define MEMPOOL_SENSOR_BLOCK_SIZE 16
+//! Number of blocks in the pool for sensor records
+#define MEMPOOL_SENSOR_BLOCK_COUNT 12
+
+//! Block size of the pool for communication frames (frame_t)
+#define MEMPOOL_FRAME_BLOCK_SIZE 64
+//! Number of blocks in the pool for communication frames
+//! (receiving, sending and the retransmit window of the reliable channel)
+#define MEMPOOL_FRAME_BLOCK_COUNT 7
+
+//! Block size of the pool for GUI elements (gui_element_container_t)
+#define MEMPOOL_GUI_BLOCK_SIZE 80
+//! Number of blocks in the pool for GUI elements
+#define MEMPOOL_GUI_BLOCK_COUNT 6
+
+//! Total number of bytes occupied by all pools
+#define MEMPOOL_TOTAL_SIZE ((MEMPOOL_SENSOR_BLOCK_SIZE * MEMPOOL_SENSOR_BLOCK_COUNT) + \
+                            (MEMPOOL_FRAME_BLOCK_SIZE * MEMPOOL_FRAME_BLOCK_COUNT) +   \
+                            (MEMPOOL_GUI_BLOCK_SIZE * MEMPOOL_GUI_BLOCK_COUNT))
+
+//! Total number of blocks in all pools
+#define MEMPOOL_TOTAL_BLOCK_COUNT (MEMPOOL_SENSOR_BLOCK_COUNT + MEMPOOL_FRAME_BLOCK_COUNT + MEMPOOL_GUI_BLOCK_COUNT)
+
+#if MEMPOOL_TOTAL_BLOCK_COUNT > 254
+#error "Too many pool blocks, block indices are 8 bit"
+#endif
+
+//----------------------------------------------------------------------------
+// Types
+//----------------------------------------------------------------------------
+
+//! The size classes of the memory pools (ordered by block size)
+typedef enum MemPoolClass
+{
+	MEMPOOL_SENSOR,
+	MEMPOOL_FRAME,
+	MEMPOOL_GUI
+} mempool_class_t;
+
+#define MEMPOOL_CLASS_COUNT 3
+
+//! Usage statistics of one memory pool
+typedef struct MemPoolStats
+{
+	uint8_t blockSize;     //!< Size of a single block in bytes
+	uint8_t blockCount;    //!< Number of blocks in the pool
+	uint8_t usedBlocks;    //!< Number of blocks currently allocated
+	uint8_t peakBlocks;    //!< Highest number of blocks allocated at the same time
+	uint16_t usedBytes;    //!< Sum of the requested sizes of all allocated blocks
+	uint16_t failedAllocs; //!< Number of requests that could not be served by this pool
+	uint8_t largestFreeRun; //!< Longest run of adjacent free blocks
+} mempool_stats_t;
+
+//----------------------------------------------------------------------------
+// Function headers
+//----------------------------------------------------------------------------
+
+//! Sets up the pools behind the global variables
+void os_initMemPools(void);
+
+//! Allocates a block of at least size bytes for the current process
+void *os_memPoolAlloc(uint16_t size);
+
+//! Returns a block to its pool
+void os_memPoolFree(void *block);
+
+//! Hands a block over to another process (INVALID_PROCESS: no owner)
+void os_memPoolSetOwner(void *block, process_id_t pid);
+
+//! Frees all blocks owned by the passed process
+uint8_t os_memPoolFreeOwnedBy(process_id_t pid);
+
+//! Returns the usage statistics of a pool
+void os_memPoolGetStats(mempool_class_t poolClass, mempool_stats_t *stats);
+
+//! Prints the usage statistics of all pools to the terminal
+void os_memPoolPrintStats(void);
+
+#endif
@@ -28,7 +28,8 @@ typedef enum ProcessState
 {
   OS_PS_UNUSED,
   OS_PS_READY,
-  OS_PS_RUNNING
+  OS_PS_RUNNING,
+  OS_PS_BLOCKED
 } process_state_t;
 
 //! The type of the priority of a process.
@@ -9,6 +9,7 @@
 #include "lib/lcd.h"
 #include "lib/util.h"
 #include "os_core.h"
+#include "os_mempool.h"
 #include "os_process.h"
 #include "os_scheduling_strategies.h"
 #include "lib/terminal.h"
@@ -39,6 +40,9 @@ uint8_t criticalSectionCount = 0;
 //! Used to auto-execute programs.
 uint16_t os_autostart;
 
+//! Blocked processes that were signalled and are made ready by the next scheduler run
+wait_queue_t os_pendingWakeups = 0;
+
 //----------------------------------------------------------------------------
 // Private function declarations
 //----------------------------------------------------------------------------
@@ -53,6 +57,9 @@ void os_dispatcher(void);
 //! Casts a function pointer without throwing a warning
 uint32_t addressOfProgram(program_t program);
 
+//! Makes signalled processes ready again
+void os_wakePendingProcesses(void);
+
 //----------------------------------------------------------------------------
 // Given functions
 //----------------------------------------------------------------------------
@@ -357,6 +364,13 @@ ISR(TIMER2_COMPA_vect)
 		os_processes[currentProc].state = OS_PS_READY;
 	}
 	// Note for task 2: Only set to ready if it is currently running because of os_kill
+	// Blocked processes keep their state and are skipped by the strategies
+
+	// Make processes ready that were signalled since the last run
+	if (os_pendingWakeups)
+	{
+		os_wakePendingProcesses();
+	}
 
 	// In task 2: Save the processes stack checksum
 	os_processes[currentProc].checksum = os_getStackChecksum(currentProc);
@@ -403,6 +417,71 @@ ISR(TIMER2_COMPA_vect)
 
 }
 
+/*!
+ *  Makes all processes ready that were signalled while they were blocked.
+ *  Runs inside the scheduler ISR, so the ready queues cannot be modified
+ *  concurrently. The current process is not pushed to a ready queue as the
+ *  strategy does that itself when it is ready.
+ */
+void os_wakePendingProcesses(void)
+{
+	uint8_t wakeups = os_pendingWakeups;
+	os_pendingWakeups = 0;
+
+	for (process_id_t pid = 1; pid < MAX_NUMBER_OF_PROCESSES; pid++)
+	{
+		if ((wakeups & (1 << pid)) && os_processes[pid].state == OS_PS_BLOCKED)
+		{
+			os_processes[pid].state = OS_PS_READY;
+			if (pid != currentProc)
+			{
+				os_resetProcessSchedulingInformation(os_getSchedulingStrategy(), pid);
+			}
+		}
+	}
+}
+
+/*!
+ *  Blocks the current process until another process or an ISR signals the
+ *  passed queue. The caller checks its wait condition with global interrupts
+ *  disabled and calls this function without enabling them in between, so a
+ *  signal cannot get lost. Returns with global interrupts enabled.
+ *  Wakeups may be spurious, so the condition has to be checked again.
+ *  The idle process and processes inside a critical section cannot block,
+ *  in that case the function returns immediately and the caller busy-waits.
+ *
+ *  \param queue The queue to wait on
+ */
+void os_waitOn(wait_queue_t *queue)
+{
+	if (currentProc == 0 || criticalSectionCount != 0)
+	{
+		sei();
+		return;
+	}
+
+	*queue |= 1 << currentProc;
+	os_processes[currentProc].state = OS_PS_BLOCKED;
+
+	// The scheduler enables interrupts again when it switches back to us
+	os_yield();
+}
+
+/*!
+ *  Wakes all processes waiting on the passed queue. They become ready with
+ *  the next run of the scheduler. May be called from an ISR.
+ *
+ *  \param queue The queue whose processes are woken
+ */
+void os_signal(wait_queue_t *queue)
+{
+	uint8_t sreg = SREG;
+	cli();
+	os_pendingWakeups |= *queue;
+	*queue = 0;
+	SREG = sreg;
+}
+
 /*!
  *  This is the idle program. The idle process owns all the memory
  *  and processor time no other process wants to have.
@@ -689,6 +768,15 @@ bool os_kill(process_id_t pid)
 
 	os_getProcessSlot(pid)->state = OS_PS_UNUSED;
 
+	// Forget a pending wakeup so it does not hit the next process in this slot
+	uint8_t sreg = SREG;
+	cli();
+	os_pendingWakeups &= ~(1 << pid);
+	SREG = sreg;
+
+	// Reclaim all pool blocks the process did not free
+	os_memPoolFreeOwnedBy(pid);
+
 	// Tidy up the scheduler
 	// (Process needs to be removed from ready queue of DPRR)
 
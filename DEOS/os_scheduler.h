@@ -33,6 +33,13 @@ typedef enum SchedulingStrategy
 // Change this define to reflect the number of available strategies:
 #define SCHEDULING_STRATEGY_COUNT 2
 
+//! Set of processes waiting for an event (one bit per process id)
+typedef uint8_t volatile wait_queue_t;
+
+#if MAX_NUMBER_OF_PROCESSES > 8
+#error "Wait queues hold one bit per process"
+#endif
+
 //----------------------------------------------------------------------------
 // Function headers
 //----------------------------------------------------------------------------
@@ -88,6 +95,16 @@ bool os_kill(process_id_t pid);
 //! triggers scheduler to schedule another process
 void os_yield();
 
+//----------------------------------------------------------------------------
+// Blocking
+//----------------------------------------------------------------------------
+
+//! blocks the current process until the queue is signalled (call with interrupts disabled)
+void os_waitOn(wait_queue_t *queue);
+
+//! wakes all processes waiting on the queue (may be called from an ISR)
+void os_signal(wait_queue_t *queue);
+
 //----------------------------------------------------------------------------
 // Critical section management
 //----------------------------------------------------------------------------
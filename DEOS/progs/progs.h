@@ -10,15 +10,32 @@
 #define TT_STACK_CONSISTENCY	23
 #define TT_YIELD				24
 #define TT_ISR_Benchmark		25
+#define TT_MEMPOOL				26
 
 // Testtasks for exercise 3
 #define TT_COMMUNICATION		30
 #define TT_PROTOCOLSTACK        31
 #define TT_CONIFGXBEE           32
+#define TT_CRC_BENCHMARK        33
+#define TT_UART_TX              34
+#define TT_UART_BENCHMARK       35
+#define TT_XBEE_BAUDRATE        36
+#define TT_MESH_ROUTING         37
+#define TT_RELIABLE             38
 
 // Testtasks for exercise 4
 #define TT_SENSOR_DATA			40
 #define TT_TLCD					41
+#define TT_SENSOR_HISTORY		42
+#define TT_SENSOR_ROLLUP		43
+#define TT_SENSOR_REGISTRY		44
+#define TT_FIXED_POINT			45
+#define TT_FONT_METRICS			46
+#define TT_LCD_BENCHMARK		47
+#define TT_BUTTONS				48
+#define TT_TWI					49
+#define TT_TLCD_BUTTONS			50
+#define TT_GUI_CHART			51
 
 ///////////////////////////////////////////////////////////////////////////////
 // Configure what program-set should be active: testtasks or your user progs
@@ -33,6 +50,9 @@
 // Will run tests/testx.c
 #define TESTTASK TT_SENSOR_DATA
 
+// UART buffer profile, see lib/uart_config.h (picked by the test task if not set)
+//#define UART_PROFILE UART_PROFILE_GATEWAY
+
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -0,0 +1,86 @@
+//-------------------------------------------------
+//          TestSuite: Buttons
+//-------------------------------------------------
+// Asks to press and release SELECT and checks the
+// queued events, then waits for a release while a
+// second process keeps counting, which shows that
+// waiting for a button takes no CPU time.
+//-------------------------------------------------
+#include "../progs.h"
+#if defined(TESTTASK_ENABLED) && TESTTASK == TT_BUTTONS
+
+#include "../../lib/buttons.h"
+#include "../../lib/lcd.h"
+#include "../../lib/terminal.h"
+#include "../../os_core.h"
+#include "../../os_scheduler.h"
+
+//! Incremented by the counting process
+volatile uint32_t tt_count = 0;
+
+// Counts while the main program waits for a button
+PROGRAM(2, DONTSTART)
+{
+	while (1)
+	{
+		tt_count++;
+	}
+}
+
+// Main program
+PROGRAM(1, AUTOSTART)
+{
+	button_event_t event;
+
+	lcd_clear();
+	lcd_writeProgString(PSTR("Phase 1: Press  SELECT"));
+
+	// Forget everything pressed while booting
+	while (buttons_popEvent(&event));
+
+	buttons_waitForEvent(&event);
+	if (event.button != BTN_SELECT || !event.pressed || buttons_read() != BTN_SELECT)
+	{
+		os_error("Wrong press     event");
+	}
+
+	lcd_clear();
+	lcd_writeProgString(PSTR("Phase 2: ReleaseSELECT"));
+
+	buttons_waitForEvent(&event);
+	if (event.button != BTN_SELECT || event.pressed || buttons_read() != BTN_NONE)
+	{
+		os_error("Wrong release   event");
+	}
+
+	lcd_clear();
+	lcd_writeProgString(PSTR("Phase 3: Press  and release UP"));
+
+	process_id_t counter = os_exec(2, DEFAULT_PRIORITY);
+	buttons_waitForPressed(BTN_UP);
+	buttons_waitForReleased(BTN_UP);
+	os_kill(counter);
+
+	INFO("Counted while waiting: %lu", (unsigned long)tt_count);
+
+	// Press and release of UP are still queued
+	bool pressed = buttons_popEvent(&event) && event.button == BTN_UP && event.pressed;
+	bool released = buttons_popEvent(&event) && event.button == BTN_UP && !event.pressed;
+
+	lcd_clear();
+	if (pressed && released && !buttons_popEvent(&event) && tt_count > 0 && buttons_getDroppedCount() == 0)
+	{
+		LCD("  TEST PASSED   ");
+	}
+	else
+	{
+		LCD("  TEST FAILED   ");
+	}
+
+	while (1)
+	{
+		os_yield();
+	}
+}
+
+#endif
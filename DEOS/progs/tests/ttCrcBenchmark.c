@@ -0,0 +1,147 @@
+//-------------------------------------------------
+//          TestSuite: CRC Benchmark
+//-------------------------------------------------
+// Compares the frame checksums: XOR checksum,
+// bitwise CRC-16 and table driven CRC-16.
+// Also checks that the CRC finds errors the XOR
+// checksum misses.
+//-------------------------------------------------
+#include "../progs.h"
+#if defined(TESTTASK_ENABLED) && TESTTASK == TT_CRC_BENCHMARK
+
+#include "../../communication/serialAdapter.h"
+#include "../../lib/crc16.h"
+#include "../../lib/lcd.h"
+#include "../../lib/stop_watch.h"
+#include "../../lib/terminal.h"
+#include "../../lib/util.h"
+#include "../../os_core.h"
+#include "../../os_scheduler.h"
+
+#include <string.h>
+
+//! Implemented in serialAdapter.c
+void serialAdapter_calculateChecksum(checksum_t *checksum, void *data, uint8_t length);
+
+#define BENCHMARK_SAMPLE_COUNT 50
+
+//! Header and full inner frame of the biggest possible frame
+#define FRAME_BYTES (sizeof(frame_header_t) + COMM_MAX_INNER_FRAME_LENGTH)
+
+//! CPU cycles per micro second
+#define CYCLES_PER_US (F_CPU / 1000000UL)
+
+uint8_t tt_frame[FRAME_BYTES];
+
+//! Checksum of the frame with the XOR checksum of serialAdapter
+uint16_t tt_xor(void)
+{
+	checksum_t checksum = 0;
+	serialAdapter_calculateChecksum(&checksum, tt_frame, FRAME_BYTES);
+	return checksum;
+}
+
+//! Checksum of the frame with the bitwise CRC-16
+uint16_t tt_crcBitwise(void)
+{
+	crc16_t crc = CRC16_INITIAL_VALUE;
+	for (uint8_t i = 0; i < FRAME_BYTES; i++)
+	{
+		crc = crc16_updateBitwise(crc, tt_frame[i]);
+	}
+	return crc;
+}
+
+//! Checksum of the frame with the table driven CRC-16
+uint16_t tt_crcTable(void)
+{
+	return crc16_calculate(CRC16_INITIAL_VALUE, tt_frame, FRAME_BYTES);
+}
+
+//! Measures the average duration of one checksum over the frame
+time_t tt_benchmark(uint16_t (*checksum)(void))
+{
+	time_t sum = 0;
+
+	for (uint8_t i = 0; i < BENCHMARK_SAMPLE_COUNT; i++)
+	{
+		os_enterCriticalSection();
+		stop_watch_handler_t handler = stopWatch_start();
+		checksum();
+		sum += stopWatch_stop(handler);
+		os_leaveCriticalSection();
+	}
+
+	return sum / BENCHMARK_SAMPLE_COUNT;
+}
+
+PROGRAM(1, AUTOSTART)
+{
+	uint8_t passed = 1;
+
+	// Check value of CRC-16/CCITT-FALSE
+	if (crc16_calculate(CRC16_INITIAL_VALUE, "123456789", 9) != 0x29B1)
+	{
+		os_error("CRC table wrong");
+	}
+
+	for (uint8_t i = 0; i < FRAME_BYTES; i++)
+	{
+		tt_frame[i] = i * 37 + 11;
+	}
+
+	if (tt_crcBitwise() != tt_crcTable())
+	{
+		os_error("CRC bitwise and table differ");
+	}
+
+	// The same bit flipped in two bytes cancels out in the XOR checksum
+	uint16_t xorBefore = tt_xor();
+	uint16_t crcBefore = tt_crcTable();
+	tt_frame[3] ^= 0x01;
+	tt_frame[10] ^= 0x01;
+	if (tt_xor() != xorBefore)
+	{
+		os_error("XOR found error unexpectedly");
+	}
+	if (tt_crcTable() == crcBefore)
+	{
+		os_error("CRC missed      double bit error");
+	}
+
+	time_t xorTime = tt_benchmark(tt_xor);
+	time_t bitwiseTime = tt_benchmark(tt_crcBitwise);
+	time_t tableTime = tt_benchmark(tt_crcTable);
+
+	// The table has to pay off
+	if (tableTime >= bitwiseTime)
+	{
+		passed = 0;
+	}
+
+	INFO("");
+	INFO("Checksum over %u bytes | Time per frame | Cycles per frame | Cycles per byte", FRAME_BYTES);
+	INFO("---------------------|----------------|------------------|----------------");
+	INFO("XOR                  | %5lu us       | %6lu           | %3lu", (unsigned long)xorTime, (unsigned long)xorTime * CYCLES_PER_US, (unsigned long)xorTime * CYCLES_PER_US / FRAME_BYTES);
+	INFO("CRC-16 bitwise       | %5lu us       | %6lu           | %3lu", (unsigned long)bitwiseTime, (unsigned long)bitwiseTime * CYCLES_PER_US, (unsigned long)bitwiseTime * CYCLES_PER_US / FRAME_BYTES);
+	INFO("CRC-16 table         | %5lu us       | %6lu           | %3lu", (unsigned long)tableTime, (unsigned long)tableTime * CYCLES_PER_US, (unsigned long)tableTime * CYCLES_PER_US / FRAME_BYTES);
+
+	lcd_clear();
+	LCD("X%lu B%lu T%lu", (unsigned long)xorTime, (unsigned long)bitwiseTime, (unsigned long)tableTime);
+	lcd_line2();
+	if (passed)
+	{
+		LCD("  TEST PASSED   ");
+	}
+	else
+	{
+		LCD("  TEST FAILED   ");
+	}
+
+	while (1)
+	{
+		os_yield();
+	}
+}
+
+#endif
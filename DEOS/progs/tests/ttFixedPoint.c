@@ -0,0 +1,105 @@
+//-------------------------------------------------
+//          TestSuite: Fixed Point
+//-------------------------------------------------
+// Formats fixed point numbers with different
+// decimals, widths and suffixes and compares them
+// with the expected strings. Then measures the
+// cycles per formatted sensor value against the
+// float conversion of dtostrf and strcat, which
+// the float vfprintf would use as well.
+//-------------------------------------------------
+#include "../progs.h"
+#if defined(TESTTASK_ENABLED) && TESTTASK == TT_FIXED_POINT
+
+#include "../../lib/fixed_point.h"
+#include "../../lib/lcd.h"
+#include "../../lib/stop_watch.h"
+#include "../../lib/terminal.h"
+#include "../../os_core.h"
+#include "../../os_scheduler.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+//! Number of values formatted per measurement
+#define RUNS 50
+
+const struct
+{
+	int32_t value;
+	uint8_t decimals;
+	uint8_t width;
+	const char *suffix;
+	const char *expected;
+} tt_cases[] = {
+	{215, 1, 0, " *C", "21.5 *C"},
+	{-5, 1, 0, NULL, "-0.5"},
+	{0, 2, 0, NULL, "0.00"},
+	{7, 3, 6, NULL, " 0.007"},
+	{1013250, 1, 14, " hPa", "  101325.0 hPa"},
+	{1234, 0, 0, " PPM", "1234 PPM"},
+	{65536, 0, 0, NULL, "65536"},
+	{INT32_MIN, 0, 0, NULL, "-2147483648"},
+	{INT32_MAX, 9, 0, NULL, "2.147483647"},
+};
+
+// Main program
+PROGRAM(1, AUTOSTART)
+{
+	char buffer[20];
+
+	lcd_clear();
+	lcd_writeProgString(PSTR("Phase 1: Format"));
+
+	for (uint8_t i = 0; i < sizeof(tt_cases) / sizeof(tt_cases[0]); i++)
+	{
+		uint8_t length = fixedPoint_format(buffer, tt_cases[i].value, tt_cases[i].decimals, tt_cases[i].width, tt_cases[i].suffix);
+		if (strcmp(buffer, tt_cases[i].expected) != 0 || length != strlen(tt_cases[i].expected))
+		{
+			os_error("Wrong format    of case %u", i);
+		}
+	}
+
+	if (fixedPoint_fromFloat(21.45f, 1) != 215 || fixedPoint_fromFloat(-0.26f, 1) != -3 || fixedPoint_fromFloat(1013.25f, 0) != 1013)
+	{
+		os_error("Wrong rounding");
+	}
+
+	lcd_clear();
+	lcd_writeProgString(PSTR("Phase 2: Bench"));
+
+	// a pressure value, the longest one the GUI shows
+	os_enterCriticalSection();
+	stop_watch_handler_t handler = stopWatch_start();
+	for (uint8_t i = 0; i < RUNS; i++)
+	{
+		fixedPoint_format(buffer, 1013250 + i, 1, 0, " hPa");
+	}
+	time_t fixedDuration = stopWatch_stop(handler);
+
+	// The same values as floats, as the sensor pipeline carried them before
+	float value = 101325.0f;
+	handler = stopWatch_start();
+	for (uint8_t i = 0; i < RUNS; i++)
+	{
+		dtostrf(value, 1, 1, buffer);
+		strcat(buffer, " hPa");
+		value += 0.1f;
+	}
+	time_t floatDuration = stopWatch_stop(handler);
+	os_leaveCriticalSection();
+
+	INFO("fixedPoint_format: %lu cycles per value", (unsigned long)fixedDuration * (F_CPU / 1000000UL) / RUNS);
+	INFO("dtostrf + strcat: %lu cycles per value", (unsigned long)floatDuration * (F_CPU / 1000000UL) / RUNS);
+
+	// The durations are only reported, failures were caught in phase 1
+	lcd_clear();
+	LCD("  TEST PASSED   ");
+
+	while (1)
+	{
+		os_yield();
+	}
+}
+
+#endif
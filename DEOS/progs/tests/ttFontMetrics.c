@@ -0,0 +1,100 @@
+//-------------------------------------------------
+//          TestSuite: Font Metrics
+//-------------------------------------------------
+// Measures strings with the metrics of the TLCD
+// fonts at different zoom factors, checks that
+// strings are cut off where they stop fitting and
+// that unknown fonts and zoom factors fall back
+// to valid ones and which fonts are measured
+// exactly. Then measures a value text of the GUI.
+// No display is needed.
+//-------------------------------------------------
+#include "../progs.h"
+#if defined(TESTTASK_ENABLED) && TESTTASK == TT_FONT_METRICS
+
+#include "../../lib/lcd.h"
+#include "../../lib/stop_watch.h"
+#include "../../lib/terminal.h"
+#include "../../os_core.h"
+#include "../../os_scheduler.h"
+#include "../../tlcd/tlcd_font.h"
+
+const struct
+{
+	tlcd_font_t font;
+	uint8_t zoom;
+	const char *text;
+	uint16_t width;
+	uint16_t height;
+} tt_cases[] = {
+	{TLCD_FONT_7X12, 1, "Seconds:59", 70, 12},
+	{TLCD_FONT_7X12, 2, "21.5 *C", 98, 24},
+	{TLCD_FONT_4X6, 3, "ab", 24, 18},
+	{TLCD_FONT_6X8, 1, "", 0, 8},
+	{TLCD_FONT_6X8, 1, "a\nb", 12, 8},
+	{TLCD_FONT_7X12, 0, "x", 7, 12},
+	{TLCD_FONT_7X12, 9, "x", 56, 96},
+	{(tlcd_font_t)0, 1, "abc", 21, 12},
+};
+
+// Main program
+PROGRAM(1, AUTOSTART)
+{
+	lcd_clear();
+	lcd_writeProgString(PSTR("Phase 1: Measure"));
+
+	for (uint8_t i = 0; i < sizeof(tt_cases) / sizeof(tt_cases[0]); i++)
+	{
+		if (tlcd_measureString(tt_cases[i].font, tt_cases[i].zoom, tt_cases[i].text) != tt_cases[i].width
+			|| tlcd_getFontHeight(tt_cases[i].font, tt_cases[i].zoom) != tt_cases[i].height)
+		{
+			os_error("Wrong size      of case %u", i);
+		}
+	}
+
+	// Only the fixed-width fonts are measured exactly
+	if (!tlcd_isFixedWidth(TLCD_FONT_7X12) || !tlcd_isFixedWidth(TLCD_FONT_BIGZIF50) || tlcd_isFixedWidth(TLCD_FONT_GENEVA10)
+		|| tlcd_isFixedWidth(TLCD_FONT_CHICAGO14) || tlcd_isFixedWidth(TLCD_FONT_SWISS30B))
+	{
+		os_error("Wrong fixed     width fonts");
+	}
+
+	lcd_clear();
+	lcd_writeProgString(PSTR("Phase 2: Fit"));
+
+	// 24 characters of 7 pixels, the first 21 fit into a GUI cell
+	const char *header = "Address: 255, Sensor: 10";
+	if (tlcd_fitString(TLCD_FONT_7X12, 1, header, 152) != 21 || tlcd_fitString(TLCD_FONT_7X12, 1, header, 168) != 24
+		|| tlcd_fitString(TLCD_FONT_7X12, 2, header, 13) != 0 || tlcd_fitString(TLCD_FONT_7X12, 2, header, 14) != 1)
+	{
+		os_error("Wrong fit");
+	}
+
+	lcd_clear();
+	lcd_writeProgString(PSTR("Phase 3: Bench"));
+
+	os_enterCriticalSection();
+	stop_watch_handler_t handler = stopWatch_start();
+	uint16_t width = tlcd_measureString(TLCD_FONT_7X12, 2, "101325.0 hPa");
+	time_t duration = stopWatch_stop(handler);
+	os_leaveCriticalSection();
+
+	INFO("Measuring a value text: %lu us", (unsigned long)duration);
+
+	lcd_clear();
+	if (width == 168)
+	{
+		LCD("  TEST PASSED   ");
+	}
+	else
+	{
+		LCD("  TEST FAILED   ");
+	}
+
+	while (1)
+	{
+		os_yield();
+	}
+}
+
+#endif
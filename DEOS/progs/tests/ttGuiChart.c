@@ -0,0 +1,122 @@
+//-------------------------------------------------
+//          TestSuite: GUI Chart
+//-------------------------------------------------
+// Adds a GUI element, switches it to the trend
+// chart and feeds it samples within the scale.
+// Every sample has to cost the same few TLCD
+// commands, no matter how many are shown. Also
+// checks that the cell got a touch button that
+// switches it. The TLCD should be attached.
+//-------------------------------------------------
+#include "../progs.h"
+#if defined(TESTTASK_ENABLED) && TESTTASK == TT_GUI_CHART
+
+#include "../../gui/gui.h"
+#include "../../lib/lcd.h"
+#include "../../lib/terminal.h"
+#include "../../os_core.h"
+#include "../../os_scheduler.h"
+#include "../../tlcd/tlcd_button.h"
+#include "../../tlcd/tlcd_core.h"
+
+//! Number of samples drawn within the scale, every QUEUE_SIZE-th wraps around to the left border
+#define SAMPLES (3 * QUEUE_SIZE)
+
+//! Most TLCD commands a sample may cost
+#define MAX_COMMANDS_PER_SAMPLE 3
+
+gui_element_container_t *tt_elements[GUI_ELEMENT_CONTAINER_SIZE];
+
+// Main program
+PROGRAM(1, AUTOSTART)
+{
+	uint8_t count = 0;
+	sensor_data_t data = {0};
+	data.sensor_src_address = 5;
+	data.sensor_type = SENSOR_TMP117;
+	data.sensor_data_type = PARAM_TEMPERATURE_CELSIUS;
+	data.sensor_fixed_value = 200;
+
+	lcd_clear();
+	lcd_writeProgString(PSTR("Phase 1: Add"));
+
+	tlcd_init();
+	init_gui(tt_elements);
+	if (!add_gui_element(tt_elements, &count, &data))
+	{
+		os_error("Element not     added");
+	}
+	gui_element_container_t *element = tt_elements[0];
+
+	// The cell is a touch button, it is the first one added
+	touch_event_t touch = {TOUCHPANEL_DOWN, TLCD_WIDTH / 6, TLCD_HEIGHT / 2};
+	if (!tlcd_handleButtons(touch) || tlcd_getButtonState(0) != BUTTON_PRESSED)
+	{
+		os_error("Cell is no      button");
+	}
+	touch.type = TOUCHPANEL_UP;
+	tlcd_handleButtons(touch);
+
+	lcd_clear();
+	lcd_writeProgString(PSTR("Phase 2: Scale"));
+
+	toggle_gui_element(element);
+	if (element->ui_state != 2)
+	{
+		os_error("No chart");
+	}
+
+	// Both values leave the scale, so the chart is rescaled to 150 - 250
+	update_sensor_data(element, 150);
+	update_gui_element(element, true);
+	update_sensor_data(element, 250);
+	update_gui_element(element, true);
+
+	lcd_clear();
+	lcd_writeProgString(PSTR("Phase 3: Sweep"));
+
+	uint8_t wraps = 0;
+	for (uint8_t i = 0; i < SAMPLES; i++)
+	{
+		uint16_t before = tlcd_getCommandCount();
+		update_sensor_data(element, 150 + (i * 37) % 101);
+		update_gui_element(element, true);
+		uint16_t commands = tlcd_getCommandCount() - before;
+
+		if (commands > MAX_COMMANDS_PER_SAMPLE || commands < 2)
+		{
+			os_error("%u commands for sample %u", commands, i);
+		}
+		// At the wrap around there is no segment to draw
+		if (commands == 2)
+		{
+			wraps++;
+		}
+	}
+
+	INFO("Chart samples drawn with at most %u commands, %u wrap arounds", MAX_COMMANDS_PER_SAMPLE, wraps);
+
+	lcd_clear();
+	lcd_writeProgString(PSTR("Phase 4: Value"));
+
+	uint16_t before = tlcd_getCommandCount();
+	toggle_gui_element(element);
+	bool redrawn = element->ui_state == 1 && tlcd_getCommandCount() != before;
+
+	lcd_clear();
+	if (wraps == SAMPLES / QUEUE_SIZE && redrawn)
+	{
+		LCD("  TEST PASSED   ");
+	}
+	else
+	{
+		LCD("  TEST FAILED   ");
+	}
+
+	while (1)
+	{
+		os_yield();
+	}
+}
+
+#endif
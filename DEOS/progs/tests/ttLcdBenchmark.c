@@ -0,0 +1,113 @@
+//-------------------------------------------------
+//          TestSuite: LCD Benchmark
+//-------------------------------------------------
+// Measures how long writing a character blocks
+// the process and how long the timer takes to
+// show it. Then counts loop iterations while the
+// whole LCD is redrawn over and over and without
+// LCD output, the ratio is the share of the CPU
+// the process keeps while the LCD is written.
+//-------------------------------------------------
+#include "../progs.h"
+#if defined(TESTTASK_ENABLED) && TESTTASK == TT_LCD_BENCHMARK
+
+#include "../../lib/lcd.h"
+#include "../../lib/stop_watch.h"
+#include "../../lib/terminal.h"
+#include "../../lib/util.h"
+#include "../../os_core.h"
+#include "../../os_scheduler.h"
+
+//! Length of the windows the loop iterations are counted in, in ms
+#define WINDOW_MS 200
+
+//! Time in ms the LCD may take to show a full frame buffer
+#define CATCH_UP_MS 100
+
+//! Lowest share of the CPU in percent the process has to keep while the LCD is redrawn
+#define MIN_CPU_SHARE 50
+
+//! Waits until the LCD shows the frame buffer
+void tt_waitForLcd(void)
+{
+	time_t start = getSystemTime_ms();
+	while (lcd_isBusy())
+	{
+		if (getSystemTime_ms() - start > CATCH_UP_MS)
+		{
+			os_error("LCD did not     catch up");
+		}
+	}
+}
+
+//! Counts loop iterations for WINDOW_MS, redrawing the whole LCD whenever it caught up if redraw is set
+uint32_t tt_countIterations(bool redraw)
+{
+	uint32_t count = 0;
+	bool odd = false;
+	time_t end = getSystemTime_ms() + WINDOW_MS;
+
+	while (getSystemTime_ms() < end)
+	{
+		if (!lcd_isBusy() && redraw)
+		{
+			lcd_clear();
+			lcd_writeProgString(odd ? PSTR("0123456789ABCDEF0123456789ABCDEF") : PSTR("FEDCBA9876543210FEDCBA9876543210"));
+			odd = !odd;
+		}
+		count++;
+	}
+	return count;
+}
+
+// Main program
+PROGRAM(1, AUTOSTART)
+{
+	lcd_clear();
+	lcd_writeProgString(PSTR("Phase 1: Char"));
+	tt_waitForLcd();
+
+	// A changed character, like a dot of the idle process
+	lcd_goto(1, 15);
+	os_enterCriticalSection();
+	stop_watch_handler_t handler = stopWatch_start();
+	lcd_writeChar('.');
+	time_t writeDuration = stopWatch_stop(handler);
+
+	handler = stopWatch_start();
+	tt_waitForLcd();
+	time_t shownDuration = stopWatch_stop(handler);
+	os_leaveCriticalSection();
+
+	INFO("Writing a character blocks for %lu us, it is shown %lu us later", (unsigned long)writeDuration, (unsigned long)shownDuration);
+
+	lcd_clear();
+	lcd_writeProgString(PSTR("Phase 2: CPU"));
+	tt_waitForLcd();
+
+	os_enterCriticalSection();
+	uint32_t redrawing = tt_countIterations(true);
+	tt_waitForLcd();
+	uint32_t idle = tt_countIterations(false);
+	os_leaveCriticalSection();
+
+	uint8_t share = redrawing * 100 / idle;
+	INFO("%lu iterations while redrawing, %lu without LCD output: %u%% of the CPU stays with the process", (unsigned long)redrawing, (unsigned long)idle, share);
+
+	lcd_clear();
+	if (share >= MIN_CPU_SHARE)
+	{
+		LCD("  TEST PASSED   ");
+	}
+	else
+	{
+		LCD("  TEST FAILED   ");
+	}
+
+	while (1)
+	{
+		os_yield();
+	}
+}
+
+#endif
@@ -0,0 +1,175 @@
+//-------------------------------------------------
+//          TestSuite: Memory Pools
+//-------------------------------------------------
+// Tests the fixed-size memory pools: exhaustion,
+// fallback to bigger pools, reclamation of blocks
+// of killed processes and speed of alloc/free.
+//-------------------------------------------------
+#include "../progs.h"
+#if defined(TESTTASK_ENABLED) && TESTTASK == TT_MEMPOOL
+
+#include "../../lib/lcd.h"
+#include "../../lib/stop_watch.h"
+#include "../../lib/util.h"
+#include "../../os_core.h"
+#include "../../os_mempool.h"
+#include "../../os_scheduler.h"
+
+#include <string.h>
+
+//! Maximum duration of one alloc/free pair (in micro seconds)
+#define MAX_ALLOC_DURATION 50
+
+#define BENCHMARK_SAMPLE_COUNT 100
+
+//! Set by program 2 as soon as it holds its blocks
+bool volatile tt_blocksTaken = false;
+
+//! Returns the number of allocated blocks of all pools
+uint8_t tt_usedBlocks(void)
+{
+	mempool_stats_t stats;
+	uint8_t used = 0;
+
+	for (uint8_t p = 0; p < MEMPOOL_CLASS_COUNT; p++)
+	{
+		os_memPoolGetStats((mempool_class_t)p, &stats);
+		used += stats.usedBlocks;
+	}
+	return used;
+}
+
+//! Allocates every block, checks that they are disjoint and frees them again
+void tt_testExhaustion(void)
+{
+	void *blocks[MEMPOOL_TOTAL_BLOCK_COUNT];
+
+	for (uint8_t i = 0; i < MEMPOOL_TOTAL_BLOCK_COUNT; i++)
+	{
+		// Small requests must spill over into the bigger pools
+		blocks[i] = os_memPoolAlloc(MEMPOOL_SENSOR_BLOCK_SIZE);
+		if (blocks[i] == NULL)
+		{
+			os_error("Alloc failed    early: %u", i);
+		}
+		memset(blocks[i], i, MEMPOOL_SENSOR_BLOCK_SIZE);
+	}
+
+	if (os_memPoolAlloc(1) != NULL)
+	{
+		os_error("Alloc succeeded on full pools");
+	}
+	if (os_memPoolAlloc(MEMPOOL_GUI_BLOCK_SIZE + 1) != NULL)
+	{
+		os_error("Oversized alloc succeeded");
+	}
+
+	for (uint8_t i = 0; i < MEMPOOL_TOTAL_BLOCK_COUNT; i++)
+	{
+		uint8_t const *data = blocks[i];
+		for (uint8_t j = 0; j < MEMPOOL_SENSOR_BLOCK_SIZE; j++)
+		{
+			if (data[j] != i)
+			{
+				os_error("Blocks overlap  at block %u", i);
+			}
+		}
+		os_memPoolFree(blocks[i]);
+	}
+
+	if (tt_usedBlocks() != 0)
+	{
+		os_error("Blocks leaked   after free");
+	}
+}
+
+//! Lets program 2 allocate blocks and checks that os_kill reclaims them
+void tt_testReclamation(void)
+{
+	tt_blocksTaken = false;
+	process_id_t pid = os_exec(2, DEFAULT_PRIORITY);
+
+	while (!tt_blocksTaken)
+	{
+		os_yield();
+	}
+
+	if (tt_usedBlocks() != 3)
+	{
+		os_error("Wrong number of used blocks");
+	}
+
+	os_kill(pid);
+
+	if (tt_usedBlocks() != 0)
+	{
+		os_error("os_kill leaked  blocks");
+	}
+}
+
+//! Measures the average duration of an alloc/free pair
+time_t tt_benchmark(void)
+{
+	time_t sum = 0;
+
+	for (uint8_t i = 0; i < BENCHMARK_SAMPLE_COUNT; i++)
+	{
+		stop_watch_handler_t handler = stopWatch_start();
+		os_memPoolFree(os_memPoolAlloc(MEMPOOL_FRAME_BLOCK_SIZE));
+		sum += stopWatch_stop(handler);
+	}
+
+	return sum / BENCHMARK_SAMPLE_COUNT;
+}
+
+// Allocates one block of every pool and never frees them
+PROGRAM(2, DONTSTART)
+{
+	os_memPoolAlloc(MEMPOOL_SENSOR_BLOCK_SIZE);
+	os_memPoolAlloc(MEMPOOL_FRAME_BLOCK_SIZE);
+	os_memPoolAlloc(MEMPOOL_GUI_BLOCK_SIZE);
+	tt_blocksTaken = true;
+
+	while (1)
+	{
+		os_yield();
+	}
+}
+
+// Main program
+PROGRAM(1, AUTOSTART)
+{
+	INFO("Running memory pool test");
+
+	lcd_clear();
+	lcd_writeProgString(PSTR("Phase 1: Exhaust"));
+	tt_testExhaustion();
+	os_memPoolPrintStats();
+
+	lcd_clear();
+	lcd_writeProgString(PSTR("Phase 2: Reclaim"));
+	tt_testReclamation();
+
+	lcd_clear();
+	lcd_writeProgString(PSTR("Phase 3: Speed"));
+	time_t duration = tt_benchmark();
+
+	INFO("Alloc/free took %lu of max. %d microseconds", (unsigned long)duration, MAX_ALLOC_DURATION);
+
+	lcd_clear();
+	if (duration <= MAX_ALLOC_DURATION)
+	{
+		LCD("  TEST PASSED   ");
+	}
+	else
+	{
+		LCD("  TEST FAILED   ");
+	}
+
+	while (1)
+	{
+		os_yield();
+	}
+}
+
+#endif
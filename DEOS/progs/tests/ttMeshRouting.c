@@ -0,0 +1,138 @@
+//-------------------------------------------------
+//          TestSuite: Mesh Routing
+//-------------------------------------------------
+// Hands mesh frames of imaginary neighbours to the
+// meshAdapter and checks the learned routes, the
+// duplicate suppression, the advertisements and
+// the forwarding decisions. Forwarded frames are
+// really sent through the XBee.
+//-------------------------------------------------
+#include "../progs.h"
+#if defined(TESTTASK_ENABLED) && TESTTASK == TT_MESH_ROUTING
+
+#include "../../communication/meshAdapter.h"
+#include "../../communication/rfAdapter.h"
+#include "../../lib/lcd.h"
+#include "../../lib/terminal.h"
+#include "../../os_core.h"
+#include "../../os_mempool.h"
+#include "../../os_scheduler.h"
+
+#include <string.h>
+
+//! Neighbour of this node
+#define NEIGHBOUR ADDRESS(2, 1)
+//! Node two hops away, reached over NEIGHBOUR
+#define REMOTE ADDRESS(2, 2)
+//! Node NEIGHBOUR advertises
+#define ADVERTISED ADDRESS(2, 3)
+//! Node no route is known to
+#define UNKNOWN ADDRESS(2, 4)
+
+//! Builds a mesh frame as if NEIGHBOUR had sent it
+frame_t *tt_receivedFrame(address_t srcAddr, address_t destAddr, uint8_t hops, uint8_t sequence, command_t command)
+{
+	frame_t *frame = os_memPoolAlloc(sizeof(frame_t));
+	if (frame == NULL)
+	{
+		os_error("No frame buffer");
+	}
+
+	frame->header.startFlag = serialAdapter_startFlagMesh;
+	frame->header.srcAddr = srcAddr;
+	frame->header.destAddr = destAddr;
+	frame->header.length = sizeof(command_t);
+	frame->innerFrame.command = command;
+	frame->mesh.prevHop = NEIGHBOUR;
+	frame->mesh.nextHop = serialAdapter_address;
+	frame->mesh.hops = hops;
+	frame->mesh.sequence = sequence;
+	return frame;
+}
+
+//! Hands the frame to the meshAdapter and checks whether it has to be processed (message in program memory)
+void tt_receive(frame_t *frame, bool expected, const char *message)
+{
+	if (meshAdapter_receiveFrame(frame) != expected)
+	{
+		os_errorPstr(message);
+	}
+	os_memPoolFree(frame);
+}
+
+//! Checks the route to a destination
+void tt_checkRoute(address_t destination, address_t expectedNextHop, uint8_t expectedHops)
+{
+	address_t nextHop;
+	uint8_t hops;
+
+	if (!meshAdapter_getRoute(destination, &nextHop, &hops) || nextHop != expectedNextHop || hops != expectedHops)
+	{
+		os_error("Wrong route to  %u", destination);
+	}
+}
+
+// Main program
+PROGRAM(1, AUTOSTART)
+{
+	rfAdapter_init();
+	meshAdapter_enabled = true;
+
+	lcd_clear();
+	lcd_writeProgString(PSTR("Phase 1: Learn"));
+
+	tt_receive(tt_receivedFrame(REMOTE, serialAdapter_address, 1, 1, CMD_TOGGLE_LED), true, PSTR("Frame for us    dropped"));
+	tt_checkRoute(NEIGHBOUR, NEIGHBOUR, 1);
+	tt_checkRoute(REMOTE, NEIGHBOUR, 2);
+
+	lcd_clear();
+	lcd_writeProgString(PSTR("Phase 2: Dupl."));
+
+	tt_receive(tt_receivedFrame(REMOTE, serialAdapter_address, 1, 1, CMD_TOGGLE_LED), false, PSTR("Duplicate not   dropped"));
+	tt_receive(tt_receivedFrame(REMOTE, serialAdapter_address, 1, 2, CMD_TOGGLE_LED), true, PSTR("New frame       dropped"));
+	tt_receive(tt_receivedFrame(serialAdapter_address, ADDRESS_BROADCAST, 2, 3, CMD_TOGGLE_LED), false, PSTR("Own frame not   dropped"));
+
+	lcd_clear();
+	lcd_writeProgString(PSTR("Phase 3: Advert."));
+
+	frame_t *advertisement = tt_receivedFrame(NEIGHBOUR, ADDRESS_BROADCAST, 0, 1, CMD_ROUTE_ADVERTISEMENT);
+	uint8_t entries[] = {ADVERTISED, 1, REMOTE, 1, serialAdapter_address, 1};
+	memcpy(advertisement->innerFrame.payload, entries, sizeof(entries));
+	advertisement->header.length += sizeof(entries);
+	tt_receive(advertisement, false, PSTR("Advertisement   processed"));
+
+	tt_checkRoute(ADVERTISED, NEIGHBOUR, 2);
+	tt_checkRoute(REMOTE, NEIGHBOUR, 2);
+	if (meshAdapter_getRoute(serialAdapter_address, &entries[0], &entries[1]))
+	{
+		os_error("Route to itself");
+	}
+
+	lcd_clear();
+	lcd_writeProgString(PSTR("Phase 4: Forward"));
+
+	tt_receive(tt_receivedFrame(REMOTE, ADVERTISED, 0, 4, CMD_TOGGLE_LED), false, PSTR("Foreign frame   processed"));
+	tt_receive(tt_receivedFrame(REMOTE, UNKNOWN, 0, 5, CMD_TOGGLE_LED), false, PSTR("Foreign frame   processed"));
+	tt_receive(tt_receivedFrame(REMOTE, UNKNOWN, MESH_MAX_HOPS - 1, 6, CMD_TOGGLE_LED), false, PSTR("Foreign frame   processed"));
+	tt_receive(tt_receivedFrame(REMOTE, ADDRESS_BROADCAST, 0, 7, CMD_TOGGLE_LED), true, PSTR("Broadcast       dropped"));
+
+	mesh_stats_t stats = meshAdapter_getStats();
+	meshAdapter_printRoutes();
+
+	lcd_clear();
+	if (stats.forwarded == 3 && stats.flooded == 1 && stats.hopLimit == 1 && stats.duplicates == 1)
+	{
+		LCD("  TEST PASSED   ");
+	}
+	else
+	{
+		LCD("  TEST FAILED   ");
+	}
+
+	while (1)
+	{
+		os_yield();
+	}
+}
+
+#endif
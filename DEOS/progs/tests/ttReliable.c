@@ -0,0 +1,199 @@
+//-------------------------------------------------
+//          TestSuite: Reliable Channel
+//-------------------------------------------------
+// Sends frames reliably to a peer that does not
+// exist, so every frame is lost. Checks the
+// retransmission after the timeout, the release by
+// an injected acknowledgement, giving up after
+// RELIABLE_MAX_RETRIES, that a full window is
+// reported and that the next frames are
+// acknowledged. Then hands reliable frames of an
+// imaginary peer to the rfAdapter and checks the
+// delivery, the duplicate suppression and that
+// frames after a given up one are delivered.
+//-------------------------------------------------
+#include "../progs.h"
+#if defined(TESTTASK_ENABLED) && TESTTASK == TT_RELIABLE
+
+#include "../../communication/reliableAdapter.h"
+#include "../../communication/rfAdapter.h"
+#include "../../lib/lcd.h"
+#include "../../lib/util.h"
+#include "../../os_core.h"
+#include "../../os_mempool.h"
+#include "../../os_scheduler.h"
+
+#include <string.h>
+
+//! Node that never answers
+#define PEER ADDRESS(2, 1)
+//! Node whose reliable frames are injected
+#define SENDER ADDRESS(2, 2)
+//! Command wrapped in the injected reliable frames
+#define CMD_TT_RELIABLE 0x50
+//! Sync flag of the reliable header (see reliableAdapter.c)
+#define TT_FLAG_SYNC 1
+
+//! Number of delivered test commands
+uint8_t tt_delivered = 0;
+//! Payloads of the delivered test commands in order of delivery
+uint8_t tt_order[8];
+
+//! Handler of CMD_TT_RELIABLE, records the payload byte
+void tt_receiveTest(frame_t *frame)
+{
+	if (tt_delivered < sizeof(tt_order))
+	{
+		tt_order[tt_delivered] = frame->innerFrame.payload[0];
+	}
+	tt_delivered++;
+}
+
+//! Hands a frame of a peer with the given payload to the rfAdapter
+void tt_inject(address_t srcAddr, command_t command, const uint8_t *payload, uint8_t length)
+{
+	frame_t *frame = os_memPoolAlloc(sizeof(frame_t));
+	if (frame == NULL)
+	{
+		os_error("No frame buffer");
+	}
+
+	frame->header.startFlag = serialAdapter_startFlag;
+	frame->header.srcAddr = srcAddr;
+	frame->header.destAddr = serialAdapter_address;
+	frame->header.length = sizeof(command_t) + length;
+	frame->innerFrame.command = command;
+	memcpy(frame->innerFrame.payload, payload, length);
+
+	serialAdapter_processFrame(frame);
+	os_memPoolFree(frame);
+}
+
+//! Injects a reliable frame of SENDER that wraps CMD_TT_RELIABLE, base is its oldest outstanding sequence number
+void tt_injectData(uint8_t seq, uint8_t flags, uint8_t base)
+{
+	uint8_t payload[] = {seq, flags, base, CMD_TT_RELIABLE, seq};
+	tt_inject(SENDER, CMD_RELIABLE_DATA, payload, sizeof(payload));
+}
+
+//! Sends a toggle frame reliably to PEER
+void tt_send(void)
+{
+	frame_t *frame = serialAdapter_allocFrame(PEER, CMD_TOGGLE_LED);
+	if (frame == NULL || reliableAdapter_sendFrame(frame, sizeof(command_t)) != RELIABLE_SENT)
+	{
+		os_error("Send failed");
+	}
+}
+
+// Main program
+PROGRAM(1, AUTOSTART)
+{
+	rfAdapter_init();
+	rfAdapter_registerCommand(CMD_TT_RELIABLE, 1, 1, tt_receiveTest);
+
+	lcd_clear();
+	lcd_writeProgString(PSTR("Phase 1: Loss"));
+
+	tt_send();
+	reliableAdapter_worker();
+	if (reliableAdapter_getStats().retransmissions != 0)
+	{
+		os_error("Retransmitted   too early");
+	}
+
+	delayMs(RELIABLE_BASE_TIMEOUT_MS + 10);
+	reliableAdapter_worker();
+	reliable_stats_t stats = reliableAdapter_getStats();
+	if (stats.sent != 1 || stats.retransmissions != 1 || reliableAdapter_getOutstanding() != 1)
+	{
+		os_error("No retransmit");
+	}
+
+	lcd_clear();
+	lcd_writeProgString(PSTR("Phase 2: Ack"));
+
+	// Everything before sequence number 1 was received
+	uint8_t ack[] = {1, 0};
+	tt_inject(PEER, CMD_RELIABLE_ACK, ack, sizeof(ack));
+	if (reliableAdapter_getOutstanding() != 0 || reliableAdapter_getStats().acknowledged != 1)
+	{
+		os_error("Ack not handled");
+	}
+
+	lcd_clear();
+	lcd_writeProgString(PSTR("Phase 3: Give up"));
+
+	tt_send();
+	while (reliableAdapter_getOutstanding() > 0)
+	{
+		delayMs(50);
+		reliableAdapter_worker();
+	}
+	stats = reliableAdapter_getStats();
+	if (stats.failed != 1 || stats.retransmissions != 1 + RELIABLE_MAX_RETRIES)
+	{
+		os_error("Not given up");
+	}
+
+	lcd_clear();
+	lcd_writeProgString(PSTR("Phase 4: Resume"));
+
+	// Sequence number 1 was given up, the window is filled from 2 on
+	for (uint8_t i = 0; i < RELIABLE_WINDOW_SIZE; i++)
+	{
+		tt_send();
+	}
+	frame_t *frame = serialAdapter_allocFrame(PEER, CMD_TOGGLE_LED);
+	if (frame == NULL || reliableAdapter_sendFrame(frame, sizeof(command_t)) != RELIABLE_WINDOW_FULL)
+	{
+		os_error("Window not full");
+	}
+	serialAdapter_freeFrame(frame);
+
+	ack[0] = 2 + RELIABLE_WINDOW_SIZE;
+	tt_inject(PEER, CMD_RELIABLE_ACK, ack, sizeof(ack));
+	if (reliableAdapter_getOutstanding() != 0 || reliableAdapter_getStats().acknowledged != 1 + RELIABLE_WINDOW_SIZE)
+	{
+		os_error("No ack after   give up");
+	}
+
+	lcd_clear();
+	lcd_writeProgString(PSTR("Phase 5: Receive"));
+
+	tt_injectData(0, TT_FLAG_SYNC, 0);
+	tt_injectData(0, TT_FLAG_SYNC, 0);
+	tt_injectData(2, 0, 1);
+	tt_injectData(1, 0, 1);
+	if (tt_delivered != 3 || tt_order[0] != 0 || tt_order[1] != 2 || tt_order[2] != 1)
+	{
+		os_error("Wrong delivery");
+	}
+
+	lcd_clear();
+	lcd_writeProgString(PSTR("Phase 6: Skip"));
+
+	// 4 arrives while 3 is retransmitted, then 3 and 5 to 11 are given up
+	tt_injectData(4, 0, 3);
+	tt_injectData(12, 0, 12);
+	tt_injectData(13, 0, 12);
+	tt_injectData(12, 0, 12);
+
+	stats = reliableAdapter_getStats();
+	lcd_clear();
+	if (tt_delivered == 6 && tt_order[3] == 4 && tt_order[4] == 12 && tt_order[5] == 13 && stats.duplicates == 2)
+	{
+		LCD("  TEST PASSED   ");
+	}
+	else
+	{
+		LCD("  TEST FAILED   ");
+	}
+
+	while (1)
+	{
+		os_yield();
+	}
+}
+
+#endif
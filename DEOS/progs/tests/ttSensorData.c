@@ -224,15 +224,18 @@ void incrementSensorData(sensor_parameter_type_t paramType, sensor_parameter_t *
 
 void rfAdapter_sendSensorData(address_t destAddr, sensor_type_t sensor, sensor_parameter_type_t paramType, sensor_parameter_t param)
 {
-	inner_frame_t innerFrame;
-	innerFrame.command = CMD_SENSOR_DATA;
+	frame_t *frame = serialAdapter_allocFrame(destAddr, CMD_SENSOR_DATA);
+	if (frame == NULL)
+	{
+		return;
+	}
 
-	cmd_sensorData_t *cmd = (cmd_sensorData_t *)innerFrame.payload;
+	cmd_sensorData_t *cmd = FRAME_PAYLOAD(frame, cmd_sensorData_t);
 	cmd->sensor = sensor;
 	cmd->paramType = paramType;
 	memcpy(&cmd->param, &param, sizeof(sensor_parameter_t));
 
-	serialAdapter_writeFrame(destAddr, sizeof(command_t) + sizeof(cmd_sensorData_t), &innerFrame);
+	serialAdapter_sendFrame(frame, sizeof(command_t) + sizeof(cmd_sensorData_t));
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,164 @@
+//-------------------------------------------------
+//          TestSuite: Sensor History
+//-------------------------------------------------
+// Appends an hour of one-per-second temperature
+// values with jittering timestamps and reads them
+// back in ranges. Then fills the pool with a noisy
+// second series and checks that only old samples
+// of the longest series are dropped.
+//-------------------------------------------------
+#include "../progs.h"
+#if defined(TESTTASK_ENABLED) && TESTTASK == TT_SENSOR_HISTORY
+
+#include "../../communication/rfAdapter.h"
+#include "../../communication/sensorHistory.h"
+#include "../../communication/sensorRegistry.h"
+#include "../../lib/lcd.h"
+#include "../../lib/stop_watch.h"
+#include "../../lib/terminal.h"
+#include "../../os_core.h"
+#include "../../os_scheduler.h"
+
+#include <stdlib.h>
+
+//! Sender of the test values
+#define SOURCE ADDRESS(1, 5)
+
+//! Number of temperature samples, one per second
+#define TEMPERATURE_COUNT 3600
+
+//! Number of noisy samples, two per second
+#define NOISE_COUNT 2000
+
+//! Samples read back at once
+#define QUERY_SIZE 20
+
+sensor_sample_t tt_samples[QUERY_SIZE];
+
+//! Time of the i-th temperature sample, every seventh one arrives late
+time_t tt_temperatureTime(uint16_t i)
+{
+	return (time_t)i * 1000 + (i % 7 == 0 ? 30 : 0);
+}
+
+//! Temperature of the i-th sample in 0.1 degrees, rises every 40 s
+int16_t tt_temperature(uint16_t i)
+{
+	return 210 + (i / 40) % 20;
+}
+
+//! Appends a value to the history
+void tt_append(sensor_parameter_type_t paramType, time_t time, sensor_parameter_t value)
+{
+	sensor_data_t data;
+	data.sensor_src_address = SOURCE;
+	data.sensor_type = SENSOR_TMP117;
+	data.sensor_data_type = paramType;
+	data.sensor_data_value = value;
+	data.sensor_fixed_value = sensorData_toFixed(paramType, value);
+	data.sensor_last_update = time;
+	data.sensor_handle = sensorRegistry_register(SOURCE, SENSOR_TMP117, paramType);
+
+	if (!sensorHistory_append(&data))
+	{
+		os_error("Append failed");
+	}
+}
+
+//! Reads the temperature series back in ranges of QUERY_SIZE samples, starting at sample first
+void tt_checkTemperature(uint16_t first)
+{
+	for (uint16_t i = first; i < TEMPERATURE_COUNT; i += QUERY_SIZE)
+	{
+		time_t from = tt_temperatureTime(i) / SENSOR_HISTORY_TIME_UNIT_MS * SENSOR_HISTORY_TIME_UNIT_MS;
+		uint16_t found = sensorHistory_query(SOURCE, SENSOR_TMP117, PARAM_TEMPERATURE_CELSIUS, from, UINT32_MAX, tt_samples, QUERY_SIZE);
+
+		for (uint16_t j = 0; j < found; j++)
+		{
+			time_t time = tt_temperatureTime(i + j) / SENSOR_HISTORY_TIME_UNIT_MS * SENSOR_HISTORY_TIME_UNIT_MS;
+			int16_t value = (int16_t)(tt_samples[j].value.fValue * 10 + 0.5f);
+
+			if (tt_samples[j].time != time || value != tt_temperature(i + j))
+			{
+				os_error("Wrong sample    %u", i + j);
+			}
+		}
+		if (found != (TEMPERATURE_COUNT - i < QUERY_SIZE ? TEMPERATURE_COUNT - i : QUERY_SIZE))
+		{
+			os_error("Missing samples %u", i);
+		}
+	}
+}
+
+// Main program
+PROGRAM(1, AUTOSTART)
+{
+	sensor_parameter_t value;
+	sensorHistory_clear();
+
+	lcd_clear();
+	lcd_writeProgString(PSTR("Phase 1: Append"));
+
+	time_t duration = 0;
+	for (uint16_t i = 0; i < TEMPERATURE_COUNT; i++)
+	{
+		value.fValue = tt_temperature(i) / 10.0f;
+
+		os_enterCriticalSection();
+		stop_watch_handler_t handler = stopWatch_start();
+		tt_append(PARAM_TEMPERATURE_CELSIUS, tt_temperatureTime(i), value);
+		duration += stopWatch_stop(handler);
+		os_leaveCriticalSection();
+	}
+
+	sensorHistory_printStats();
+	INFO("Appending %u samples took %lu us, %lu us each", TEMPERATURE_COUNT, (unsigned long)duration, (unsigned long)(duration / TEMPERATURE_COUNT));
+
+	lcd_clear();
+	lcd_writeProgString(PSTR("Phase 2: Query"));
+
+	if (sensorHistory_getCount(SOURCE, SENSOR_TMP117, PARAM_TEMPERATURE_CELSIUS) != TEMPERATURE_COUNT)
+	{
+		os_error("Wrong count");
+	}
+	tt_checkTemperature(0);
+
+	lcd_clear();
+	lcd_writeProgString(PSTR("Phase 3: Evict"));
+
+	srand(1);
+	for (uint16_t i = 0; i < NOISE_COUNT; i++)
+	{
+		value.uValue = 400 + rand() % 50;
+		tt_append(PARAM_CO2_PPM, (time_t)i * 500, value);
+	}
+	sensorHistory_printStats();
+
+	// The temperature series has fewer blocks and must be complete, the noise lost its oldest samples
+	tt_checkTemperature(0);
+
+	uint16_t noiseCount = sensorHistory_getCount(SOURCE, SENSOR_TMP117, PARAM_CO2_PPM);
+	sensor_sample_t latest;
+	if (!sensorHistory_getLatest(SOURCE, SENSOR_TMP117, PARAM_CO2_PPM, &latest) || latest.value.uValue != value.uValue)
+	{
+		os_error("Wrong latest");
+	}
+	uint16_t found = sensorHistory_query(SOURCE, SENSOR_TMP117, PARAM_CO2_PPM, 0, UINT32_MAX, tt_samples, 1);
+
+	lcd_clear();
+	if (noiseCount < NOISE_COUNT && found == 1 && tt_samples[0].time == (time_t)(NOISE_COUNT - noiseCount) * 500)
+	{
+		LCD("  TEST PASSED   ");
+	}
+	else
+	{
+		LCD("  TEST FAILED   ");
+	}
+
+	while (1)
+	{
+		os_yield();
+	}
+}
+
+#endif
@@ -0,0 +1,113 @@
+//-------------------------------------------------
+//          TestSuite: Sensor Registry
+//-------------------------------------------------
+// Registers sensor values that share address,
+// sensor or parameter type and checks that every
+// key keeps its own handle, that lookups find the
+// same handles and that a full registry rejects
+// new keys. Also measures a lookup.
+//-------------------------------------------------
+#include "../progs.h"
+#if defined(TESTTASK_ENABLED) && TESTTASK == TT_SENSOR_REGISTRY
+
+#include "../../communication/rfAdapter.h"
+#include "../../communication/sensorRegistry.h"
+#include "../../lib/lcd.h"
+#include "../../lib/stop_watch.h"
+#include "../../lib/terminal.h"
+#include "../../os_core.h"
+#include "../../os_scheduler.h"
+
+//! Keys that only differ in one part, the first two used to collide in the GUI
+const struct
+{
+	address_t address;
+	sensor_type_t sensor;
+	sensor_parameter_type_t paramType;
+} tt_keys[SENSOR_REGISTRY_SIZE] = {
+	{ADDRESS(1, 7), SENSOR_SHTC3, PARAM_HUMIDITY_PERCENT},
+	{ADDRESS(1, 7), SENSOR_SHTC3, PARAM_TEMPERATURE_CELSIUS},
+	{ADDRESS(1, 7), SENSOR_TMP117, PARAM_TEMPERATURE_CELSIUS},
+	{ADDRESS(1, 5), SENSOR_TMP117, PARAM_TEMPERATURE_CELSIUS},
+	{ADDRESS(2, 5), SENSOR_TMP117, PARAM_TEMPERATURE_CELSIUS},
+	{ADDRESS(1, 6), SENSOR_SCD41, PARAM_CO2_PPM},
+};
+
+// Main program
+PROGRAM(1, AUTOSTART)
+{
+	sensor_handle_t handles[SENSOR_REGISTRY_SIZE];
+
+	lcd_clear();
+	lcd_writeProgString(PSTR("Phase 1: Reg."));
+
+	for (uint8_t i = 0; i < SENSOR_REGISTRY_SIZE; i++)
+	{
+		if (sensorRegistry_lookup(tt_keys[i].address, tt_keys[i].sensor, tt_keys[i].paramType) != SENSOR_HANDLE_INVALID)
+		{
+			os_error("Unknown key     found");
+		}
+
+		handles[i] = sensorRegistry_register(tt_keys[i].address, tt_keys[i].sensor, tt_keys[i].paramType);
+		for (uint8_t j = 0; j < i; j++)
+		{
+			if (handles[i] == SENSOR_HANDLE_INVALID || handles[i] == handles[j])
+			{
+				os_error("Handle %u reused", handles[i]);
+			}
+		}
+	}
+
+	lcd_clear();
+	lcd_writeProgString(PSTR("Phase 2: Lookup"));
+
+	for (uint8_t i = 0; i < SENSOR_REGISTRY_SIZE; i++)
+	{
+		address_t address;
+		sensor_type_t sensor;
+		sensor_parameter_type_t paramType;
+
+		if (sensorRegistry_lookup(tt_keys[i].address, tt_keys[i].sensor, tt_keys[i].paramType) != handles[i]
+			|| sensorRegistry_register(tt_keys[i].address, tt_keys[i].sensor, tt_keys[i].paramType) != handles[i])
+		{
+			os_error("Handle %u changed", handles[i]);
+		}
+		if (!sensorRegistry_getKey(handles[i], &address, &sensor, &paramType) || address != tt_keys[i].address || sensor != tt_keys[i].sensor || paramType != tt_keys[i].paramType)
+		{
+			os_error("Wrong key of    handle %u", handles[i]);
+		}
+	}
+
+	lcd_clear();
+	lcd_writeProgString(PSTR("Phase 3: Full"));
+
+	if (sensorRegistry_register(ADDRESS(3, 1), SENSOR_BMP581, PARAM_PRESSURE_PASCAL) != SENSOR_HANDLE_INVALID)
+	{
+		os_error("Full registry   accepted key");
+	}
+
+	os_enterCriticalSection();
+	stop_watch_handler_t handler = stopWatch_start();
+	sensor_handle_t last = sensorRegistry_lookup(tt_keys[SENSOR_REGISTRY_SIZE - 1].address, tt_keys[SENSOR_REGISTRY_SIZE - 1].sensor, tt_keys[SENSOR_REGISTRY_SIZE - 1].paramType);
+	time_t duration = stopWatch_stop(handler);
+	os_leaveCriticalSection();
+
+	INFO("Lookup of the last registered key: %lu us", (unsigned long)duration);
+
+	lcd_clear();
+	if (last == handles[SENSOR_REGISTRY_SIZE - 1] && sensorRegistry_getCount() == SENSOR_REGISTRY_SIZE)
+	{
+		LCD("  TEST PASSED   ");
+	}
+	else
+	{
+		LCD("  TEST FAILED   ");
+	}
+
+	while (1)
+	{
+		os_yield();
+	}
+}
+
+#endif
@@ -0,0 +1,111 @@
+//-------------------------------------------------
+//          TestSuite: Sensor Rollup
+//-------------------------------------------------
+// Appends 20 minutes of one-per-second values that
+// follow a saw tooth, leaving out minutes 15 to 17,
+// and checks min, max, mean and count of the
+// minute and hour rollups.
+//-------------------------------------------------
+#include "../progs.h"
+#if defined(TESTTASK_ENABLED) && TESTTASK == TT_SENSOR_ROLLUP
+
+#include "../../communication/rfAdapter.h"
+#include "../../communication/sensorHistory.h"
+#include "../../communication/sensorRegistry.h"
+#include "../../lib/lcd.h"
+#include "../../lib/terminal.h"
+#include "../../os_core.h"
+#include "../../os_scheduler.h"
+
+//! Sender of the test values
+#define SOURCE ADDRESS(1, 5)
+
+//! Number of minutes with values
+#define MINUTES 20
+
+//! First minute without values
+#define GAP_START 15
+
+//! First minute with values after the gap
+#define GAP_END 18
+
+sensor_rollup_t tt_rollups[SENSOR_ROLLUP_HOUR_COUNT];
+
+// Main program
+PROGRAM(1, AUTOSTART)
+{
+	sensor_data_t data;
+	data.sensor_src_address = SOURCE;
+	data.sensor_type = SENSOR_SCD41;
+	data.sensor_data_type = PARAM_CO2_PPM;
+	data.sensor_handle = sensorRegistry_register(SOURCE, SENSOR_SCD41, PARAM_CO2_PPM);
+
+	sensorHistory_clear();
+
+	lcd_clear();
+	lcd_writeProgString(PSTR("Phase 1: Append"));
+
+	// 400 to 459 ppm within each minute, mean 429.5
+	for (uint16_t second = 0; second < MINUTES * 60; second++)
+	{
+		if (second >= GAP_START * 60 && second < GAP_END * 60)
+		{
+			continue;
+		}
+		data.sensor_data_value.uValue = 400 + second % 60;
+		data.sensor_fixed_value = data.sensor_data_value.iValue;
+		data.sensor_last_update = (time_t)second * 1000;
+		sensorHistory_append(&data);
+	}
+
+	lcd_clear();
+	lcd_writeProgString(PSTR("Phase 2: Minutes"));
+
+	uint8_t count = sensorHistory_getRollups(SOURCE, SENSOR_SCD41, PARAM_CO2_PPM, SENSOR_ROLLUP_MINUTE, tt_rollups, SENSOR_ROLLUP_HOUR_COUNT);
+	if (count != SENSOR_ROLLUP_MINUTE_COUNT)
+	{
+		os_error("Wrong number of minutes");
+	}
+
+	for (uint8_t i = 0; i < count; i++)
+	{
+		uint8_t minute = MINUTES - SENSOR_ROLLUP_MINUTE_COUNT + i;
+		sensor_rollup_t *rollup = &tt_rollups[i];
+		bool gap = minute >= GAP_START && minute < GAP_END;
+
+		INFO("Minute %2u: %2u samples, min %lu, max %lu, mean %lu", minute, rollup->count, rollup->min.uValue, rollup->max.uValue, rollup->mean.uValue);
+
+		if (rollup->start != (time_t)minute * 60000 || rollup->count != (gap ? 0 : 60))
+		{
+			os_error("Wrong minute    %u", minute);
+		}
+		// The mean is rounded towards zero relative to the first value
+		if (!gap && (rollup->min.uValue != 400 || rollup->max.uValue != 459 || rollup->mean.uValue != 429))
+		{
+			os_error("Wrong values    %u", minute);
+		}
+	}
+
+	lcd_clear();
+	lcd_writeProgString(PSTR("Phase 3: Hours"));
+
+	count = sensorHistory_getRollups(SOURCE, SENSOR_SCD41, PARAM_CO2_PPM, SENSOR_ROLLUP_HOUR, tt_rollups, SENSOR_ROLLUP_HOUR_COUNT);
+
+	lcd_clear();
+	if (count == 1 && tt_rollups[0].start == 0 && tt_rollups[0].count == (MINUTES - GAP_END + GAP_START) * 60
+		&& tt_rollups[0].min.uValue == 400 && tt_rollups[0].max.uValue == 459 && tt_rollups[0].mean.uValue == 429)
+	{
+		LCD("  TEST PASSED   ");
+	}
+	else
+	{
+		LCD("  TEST FAILED   ");
+	}
+
+	while (1)
+	{
+		os_yield();
+	}
+}
+
+#endif
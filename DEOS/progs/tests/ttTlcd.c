@@ -1,7 +1,9 @@
 //-------------------------------------------------
 //          TestSuite: TLCD
 //-------------------------------------------------
-// Simple GUI for TLCD
+// Simple GUI for TLCD. Touch events are read by
+// program 2 whenever SBUF signals data and drawn
+// by program 3.
 //-------------------------------------------------
 #include "../progs.h"
 #if defined(TESTTASK_ENABLED) && TESTTASK == TT_TLCD
@@ -120,7 +122,7 @@ void drawColorBar()
 		ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
 		{
 			tlcd_defineColor(17, color);
-			tlcd_changeDrawColor(17);
+			tlcd_changeLineColor(17);
 			tlcd_drawLine(x, TLCD_HEIGHT - 40, x, TLCD_HEIGHT);
 		}
 	}
@@ -152,13 +154,13 @@ void pressButton(uint8_t code, uint16_t x, uint16_t y)
 	else if (code == ERASER)
 	{
 		tlcd_changePenSize(15);
-		tlcd_changeDrawColor(1);
+		tlcd_changeLineColor(1);
 	}
 	else
 	{
 		tlcd_defineColor(code, getColor((uint32_t)x * MAX_COLORS / TLCD_WIDTH));
 		tlcd_changePenSize(penSize); // Resetting pen size because the eraser could have been selected in between
-		tlcd_changeDrawColor(code);
+		tlcd_changeLineColor(code);
 	}
 }
 
@@ -239,7 +241,19 @@ PROGRAM(2, AUTOSTART)
 	tlcd_init();
 	while (1)
 	{
+		tlcd_waitForData();
 		tlcd_event_worker();
+	}
+}
+
+/*!
+ * Handles the queued touch events, a slow drawing does not delay reading the TLCD
+ */
+PROGRAM(3, AUTOSTART)
+{
+	while (1)
+	{
+		tlcd_event_dispatch();
 		os_yield();
 	}
 }
@@ -0,0 +1,156 @@
+//-------------------------------------------------
+//          TestSuite: TLCD Buttons
+//-------------------------------------------------
+// Adds MAX_BUTTONS touch buttons, some of them
+// overlapping and spanning several grid cells,
+// and feeds synthetic touch events through
+// tlcd_handleButtons and tlcd_updateButtons.
+// Checks lookup, press, release and long press.
+// No display is needed.
+//-------------------------------------------------
+#include "../progs.h"
+#if defined(TESTTASK_ENABLED) && TESTTASK == TT_TLCD_BUTTONS
+
+#include "../../lib/lcd.h"
+#include "../../lib/util.h"
+#include "../../os_core.h"
+#include "../../os_scheduler.h"
+#include "../../tlcd/tlcd_button.h"
+
+//! Codes of the buttons
+#define CODE_A 1
+#define CODE_B 2
+#define CODE_C 3
+#define CODE_ROW 10
+#define CODE_LAST 99
+#define CODE_REJECTED 100
+
+//! Number of small buttons in the bottom row, they fill the buttons up to MAX_BUTTONS
+#define ROW_COUNT (MAX_BUTTONS - 4)
+
+//! Code and state of the latest state change
+uint8_t tt_code;
+button_state_t tt_state;
+
+//! Number of state changes
+uint8_t tt_changes = 0;
+
+//! Code of the latest press reported to the button callback
+uint8_t tt_pressedCode;
+
+void tt_stateCallback(uint8_t buttonCode, button_state_t state)
+{
+	tt_code = buttonCode;
+	tt_state = state;
+	tt_changes++;
+}
+
+void tt_callback(uint8_t buttonCode, uint16_t x, uint16_t y)
+{
+	tt_pressedCode = buttonCode;
+}
+
+//! Sends a touch event, checks whether it hit a button and which state change it caused
+void tt_touch(touch_event_type_t type, uint16_t x, uint16_t y, bool hit, uint8_t code, button_state_t state)
+{
+	touch_event_t event = {type, x, y};
+	uint8_t changes = tt_changes;
+
+	if (tlcd_handleButtons(event) != hit)
+	{
+		os_error("Wrong hit at    %u,%u", x, y);
+	}
+	if (code != 0 && (tt_changes == changes || tt_code != code || tt_state != state))
+	{
+		os_error("Wrong state at  %u,%u", x, y);
+	}
+	if (code == 0 && tt_changes != changes)
+	{
+		os_error("Unexpected stateat %u,%u", x, y);
+	}
+}
+
+// Main program
+PROGRAM(1, AUTOSTART)
+{
+	tlcd_setButtonCallback(tt_callback);
+	tlcd_setButtonStateCallback(tt_stateCallback);
+
+	lcd_clear();
+	lcd_writeProgString(PSTR("Phase 1: Add"));
+
+	// A and B overlap in grid cell 0,0, B and C span several cells
+	tlcd_addButton(10, 10, 60, 40, 0, CODE_A);
+	tlcd_addButton(100, 80, 50, 30, 0, CODE_B);
+	tlcd_addButton(200, 100, 300, 200, 0, CODE_C);
+	for (uint8_t i = 0; i < ROW_COUNT; i++)
+	{
+		tlcd_addButton(4 + 16 * i, 220, 16 + 16 * i, 260, 0, CODE_ROW + i);
+	}
+	// The last button uses bit 31 of the grid cells
+	tlcd_addButton(460, 250, 479, 271, 0, CODE_LAST);
+	// The registry is full, this one is ignored
+	tlcd_addButton(0, 0, 479, 271, 0, CODE_REJECTED);
+
+	lcd_clear();
+	lcd_writeProgString(PSTR("Phase 2: Lookup"));
+
+	// Of overlapping buttons the one added first is found
+	tt_touch(TOUCHPANEL_DOWN, 55, 35, true, CODE_A, BUTTON_PRESSED);
+	tt_touch(TOUCHPANEL_UP, 55, 35, true, CODE_A, BUTTON_RELEASED);
+	tt_touch(TOUCHPANEL_DOWN, 90, 70, true, CODE_B, BUTTON_PRESSED);
+	tt_touch(TOUCHPANEL_UP, 90, 70, true, CODE_B, BUTTON_RELEASED);
+	tt_touch(TOUCHPANEL_DOWN, 16 + 16 * (ROW_COUNT - 1), 260, true, CODE_ROW + ROW_COUNT - 1, BUTTON_PRESSED);
+	tt_touch(TOUCHPANEL_UP, 16 + 16 * (ROW_COUNT - 1), 260, true, CODE_ROW + ROW_COUNT - 1, BUTTON_RELEASED);
+	tt_touch(TOUCHPANEL_DOWN, 479, 271, true, CODE_LAST, BUTTON_PRESSED);
+	if (tt_pressedCode != CODE_LAST)
+	{
+		os_error("Wrong callback");
+	}
+	tt_touch(TOUCHPANEL_UP, 479, 271, true, CODE_LAST, BUTTON_RELEASED);
+
+	// Inside the grid cells of buttons, but outside of them
+	tt_touch(TOUCHPANEL_DOWN, 150, 30, false, 0, BUTTON_RELEASED);
+	tt_touch(TOUCHPANEL_DOWN, 70, 20, false, 0, BUTTON_RELEASED);
+	tt_touch(TOUCHPANEL_UP, 70, 20, false, 0, BUTTON_RELEASED);
+
+	lcd_clear();
+	lcd_writeProgString(PSTR("Phase 3: Long"));
+
+	// A long press needs BUTTON_LONG_PRESS_MS, a drag on the button keeps it
+	tt_touch(TOUCHPANEL_DOWN, 250, 150, true, CODE_C, BUTTON_PRESSED);
+	tlcd_updateButtons();
+	tt_touch(TOUCHPANEL_DRAG, 260, 160, true, 0, BUTTON_PRESSED);
+	if (tlcd_getButtonState(CODE_C) != BUTTON_PRESSED)
+	{
+		os_error("Long press      too early");
+	}
+
+	delayMs(BUTTON_LONG_PRESS_MS);
+	tlcd_updateButtons();
+	if (tlcd_getButtonState(CODE_C) != BUTTON_LONG_PRESSED || tt_code != CODE_C || tt_state != BUTTON_LONG_PRESSED)
+	{
+		os_error("No long press");
+	}
+
+	// Dragging off the button releases it
+	tt_touch(TOUCHPANEL_DRAG, 350, 150, false, CODE_C, BUTTON_RELEASED);
+	tlcd_updateButtons();
+
+	lcd_clear();
+	if (tlcd_getButtonState(CODE_C) == BUTTON_RELEASED && tlcd_getButtonState(CODE_REJECTED) == BUTTON_RELEASED && tt_changes == 11)
+	{
+		LCD("  TEST PASSED   ");
+	}
+	else
+	{
+		LCD("  TEST FAILED   ");
+	}
+
+	while (1)
+	{
+		os_yield();
+	}
+}
+
+#endif
@@ -0,0 +1,125 @@
+//-------------------------------------------------
+//          TestSuite: TWI
+//-------------------------------------------------
+// Queues transactions to an address no device
+// answers to, checks that they complete in order
+// with TWI_NACK_ADDRESS and that the queue rejects
+// one more. A second process counts meanwhile to
+// show that waiting takes no CPU time.
+// SCL and SDA need pull-up resistors.
+//-------------------------------------------------
+#include "../progs.h"
+#if defined(TESTTASK_ENABLED) && TESTTASK == TT_TWI
+
+#include "../../i2c/twi.h"
+#include "../../lib/lcd.h"
+#include "../../lib/terminal.h"
+#include "../../os_core.h"
+#include "../../os_scheduler.h"
+
+//! Address no device on the bus uses
+#define ABSENT_ADDRESS 0x5A
+
+//! Incremented by the counting process
+volatile uint32_t tt_count = 0;
+
+//! Indices of the transactions in the order they completed
+volatile uint8_t tt_order[TWI_QUEUE_SIZE];
+
+//! Number of completed transactions
+volatile uint8_t tt_completed = 0;
+
+twi_transaction_t tt_transactions[TWI_QUEUE_SIZE + 1];
+
+//! Records which transaction completed, runs in the TWI interrupt
+void tt_callback(twi_transaction_t *transaction)
+{
+	tt_order[tt_completed++] = transaction - tt_transactions;
+}
+
+// Counts while the main program waits for the bus
+PROGRAM(2, DONTSTART)
+{
+	while (1)
+	{
+		tt_count++;
+	}
+}
+
+// Main program
+PROGRAM(1, AUTOSTART)
+{
+	uint8_t command = 0x00;
+	uint8_t data[2];
+
+	twi_init();
+
+	lcd_clear();
+	lcd_writeProgString(PSTR("Phase 1: Queue"));
+
+	for (uint8_t i = 0; i < TWI_QUEUE_SIZE + 1; i++)
+	{
+		tt_transactions[i].address = ABSENT_ADDRESS;
+		tt_transactions[i].writeData = &command;
+		tt_transactions[i].writeLength = i % 2;
+		tt_transactions[i].readData = data;
+		tt_transactions[i].readLength = sizeof(data);
+		tt_transactions[i].callback = tt_callback;
+	}
+
+	// Submit all at once, so the bus cannot complete one in between
+	cli();
+	bool accepted = true;
+	for (uint8_t i = 0; i < TWI_QUEUE_SIZE; i++)
+	{
+		accepted &= twi_submit(&tt_transactions[i]);
+	}
+	bool rejected = !twi_submit(&tt_transactions[TWI_QUEUE_SIZE]);
+	sei();
+
+	if (!accepted || !rejected)
+	{
+		os_error("Wrong queue size");
+	}
+
+	lcd_clear();
+	lcd_writeProgString(PSTR("Phase 2: Wait"));
+
+	process_id_t counter = os_exec(2, DEFAULT_PRIORITY);
+	for (uint8_t i = 0; i < TWI_QUEUE_SIZE; i++)
+	{
+		if (twi_wait(&tt_transactions[i]) != TWI_NACK_ADDRESS)
+		{
+			os_error("Wrong status    %u", tt_transactions[i].status);
+		}
+		if (tt_order[i] != i)
+		{
+			os_error("Wrong order     %u", tt_order[i]);
+		}
+	}
+	os_kill(counter);
+
+	INFO("Counted while waiting: %lu", (unsigned long)tt_count);
+
+	lcd_clear();
+	lcd_writeProgString(PSTR("Phase 3: Transfer"));
+
+	twi_status_t status = twi_transfer(ABSENT_ADDRESS, &command, 1, data, sizeof(data));
+
+	lcd_clear();
+	if (status == TWI_NACK_ADDRESS && tt_completed == TWI_QUEUE_SIZE && tt_count > 0)
+	{
+		LCD("  TEST PASSED   ");
+	}
+	else
+	{
+		LCD("  TEST FAILED   ");
+	}
+
+	while (1)
+	{
+		os_yield();
+	}
+}
+
+#endif
@@ -0,0 +1,108 @@
+//-------------------------------------------------
+//          TestSuite: UART Benchmark
+//-------------------------------------------------
+// Compares the CPU time needed to hand a frame to
+// UART1 byte by byte (uart1_putc) and in one go
+// (uart1_write), the way serialAdapter sends it.
+//-------------------------------------------------
+#include "../progs.h"
+#if defined(TESTTASK_ENABLED) && TESTTASK == TT_UART_BENCHMARK
+
+#include "../../communication/serialAdapter.h"
+#include "../../communication/xbee.h"
+#include "../../lib/lcd.h"
+#include "../../lib/stop_watch.h"
+#include "../../lib/terminal.h"
+#include "../../lib/uart.h"
+#include "../../lib/util.h"
+#include "../../os_core.h"
+#include "../../os_scheduler.h"
+
+#define BENCHMARK_SAMPLE_COUNT 50
+
+//! Inner frame length of the sample frame (fits into the UART buffer)
+#define INNER_FRAME_LENGTH 20
+
+//! Header and inner frame of the sample frame
+#define FRAME_BYTES (sizeof(frame_header_t) + INNER_FRAME_LENGTH)
+
+//! CPU cycles per micro second
+#define CYCLES_PER_US (F_CPU / 1000000UL)
+
+uint8_t tt_frame[FRAME_BYTES];
+checksum_t tt_footer = 0x42;
+
+//! Hands the frame to the UART byte by byte
+void tt_sendBytewise(void)
+{
+	for (uint8_t i = 0; i < FRAME_BYTES; i++)
+	{
+		uart1_putc(tt_frame[i]);
+	}
+	uart1_putc(tt_footer);
+}
+
+//! Hands the frame to the UART in one go
+void tt_sendBulk(void)
+{
+	uart1_write(tt_frame, FRAME_BYTES);
+	uart1_write(&tt_footer, sizeof(tt_footer));
+}
+
+//! Measures the average duration of handing one frame to the UART
+time_t tt_benchmark(void (*send)(void))
+{
+	time_t sum = 0;
+
+	for (uint8_t i = 0; i < BENCHMARK_SAMPLE_COUNT; i++)
+	{
+		// Start with an empty buffer, so the write never waits for the UART
+		uart1_waitTxDrained();
+
+		os_enterCriticalSection();
+		stop_watch_handler_t handler = stopWatch_start();
+		send();
+		sum += stopWatch_stop(handler);
+		os_leaveCriticalSection();
+	}
+
+	return sum / BENCHMARK_SAMPLE_COUNT;
+}
+
+PROGRAM(1, AUTOSTART)
+{
+	xbee_init();
+
+	for (uint8_t i = 0; i < FRAME_BYTES; i++)
+	{
+		tt_frame[i] = i * 37 + 11;
+	}
+
+	time_t bytewiseTime = tt_benchmark(tt_sendBytewise);
+	time_t bulkTime = tt_benchmark(tt_sendBulk);
+
+	INFO("");
+	INFO("Sending %u bytes | Time per frame | Cycles per frame", FRAME_BYTES + sizeof(tt_footer));
+	INFO("-----------------|----------------|-----------------");
+	INFO("uart1_putc       | %5lu us       | %6lu", (unsigned long)bytewiseTime, (unsigned long)bytewiseTime * CYCLES_PER_US);
+	INFO("uart1_write      | %5lu us       | %6lu", (unsigned long)bulkTime, (unsigned long)bulkTime * CYCLES_PER_US);
+
+	lcd_clear();
+	LCD("B%lu W%lu", (unsigned long)bytewiseTime, (unsigned long)bulkTime);
+	lcd_line2();
+	if (bulkTime < bytewiseTime)
+	{
+		LCD("  TEST PASSED   ");
+	}
+	else
+	{
+		LCD("  TEST FAILED   ");
+	}
+
+	while (1)
+	{
+		os_yield();
+	}
+}
+
+#endif
@@ -0,0 +1,136 @@
+//-------------------------------------------------
+//          TestSuite: UART Transmit
+//-------------------------------------------------
+// Tests the non-blocking and the blocking transmit
+// functions of UART1. A process that writes more
+// than fits into the buffer has to sleep, so a
+// counting process gets considerably more CPU time
+// than while the writer busy-waits.
+//-------------------------------------------------
+#include "../progs.h"
+#if defined(TESTTASK_ENABLED) && TESTTASK == TT_UART_TX
+
+#include "../../communication/xbee.h"
+#include "../../lib/lcd.h"
+#include "../../lib/terminal.h"
+#include "../../lib/uart.h"
+#include "../../lib/util.h"
+#include "../../os_core.h"
+#include "../../os_scheduler.h"
+
+//! Number of bytes written in one go (about 130 ms at 38400 baud)
+#define TX_LENGTH 512
+
+uint8_t tt_data[TX_LENGTH];
+
+//! Incremented by program 2 as fast as possible
+uint32_t volatile tt_counter = 0;
+
+//! Reads the counter without program 2 changing it halfway
+uint32_t tt_getCounter(void)
+{
+	os_enterCriticalSection();
+	uint32_t counter = tt_counter;
+	os_leaveCriticalSection();
+	return counter;
+}
+
+//! Checks that the non-blocking write only accepts what fits into the buffer
+void tt_testTryWrite(void)
+{
+	uint16_t accepted = uart1_tryWrite(tt_data, TX_LENGTH);
+
+	if (accepted == 0 || accepted >= TX_LENGTH)
+	{
+		os_error("tryWrite accepted %u bytes", accepted);
+	}
+	if (uart1_tryWrite(tt_data, TX_LENGTH) != 0)
+	{
+		os_error("tryWrite on full buffer");
+	}
+
+	uart1_waitTxDrained();
+
+	if (uart1_gettxcount() != 0)
+	{
+		os_error("Buffer not      drained");
+	}
+}
+
+//! Returns how far program 2 counted while TX_LENGTH bytes were written blocking
+uint32_t tt_countWhileWriting(time_t *duration)
+{
+	time_t start = getSystemTime_ms();
+	uint32_t counter = tt_getCounter();
+
+	uart1_write(tt_data, TX_LENGTH);
+	uart1_waitTxDrained();
+
+	*duration = getSystemTime_ms() - start;
+	return tt_getCounter() - counter;
+}
+
+//! Returns how far program 2 counted while we busy-waited for the passed time
+uint32_t tt_countWhileSpinning(time_t duration)
+{
+	time_t start = getSystemTime_ms();
+	uint32_t counter = tt_getCounter();
+
+	while (getSystemTime_ms() - start < duration)
+	{
+	}
+
+	return tt_getCounter() - counter;
+}
+
+// Counts as fast as possible
+PROGRAM(2, DONTSTART)
+{
+	while (1)
+	{
+		tt_counter++;
+	}
+}
+
+// Main program
+PROGRAM(1, AUTOSTART)
+{
+	xbee_init();
+
+	for (uint16_t i = 0; i < TX_LENGTH; i++)
+	{
+		tt_data[i] = i;
+	}
+
+	lcd_clear();
+	lcd_writeProgString(PSTR("Phase 1: Try"));
+	tt_testTryWrite();
+
+	lcd_clear();
+	lcd_writeProgString(PSTR("Phase 2: Block"));
+	os_exec(2, DEFAULT_PRIORITY);
+
+	time_t duration;
+	uint32_t blocking = tt_countWhileWriting(&duration);
+	uint32_t spinning = tt_countWhileSpinning(duration);
+
+	INFO("Writing %u bytes took %lu ms", TX_LENGTH, (unsigned long)duration);
+	INFO("Counter progress: %lu while writing, %lu while spinning", (unsigned long)blocking, (unsigned long)spinning);
+
+	lcd_clear();
+	if (blocking > spinning + spinning / 2)
+	{
+		LCD("  TEST PASSED   ");
+	}
+	else
+	{
+		LCD("  TEST FAILED   ");
+	}
+
+	while (1)
+	{
+		os_yield();
+	}
+}
+
+#endif
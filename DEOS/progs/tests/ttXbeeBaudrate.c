@@ -0,0 +1,105 @@
+//-------------------------------------------------
+//          TestSuite: XBee Baudrate
+//-------------------------------------------------
+// Checks the UBRR selection for the XBee baudrates
+// and switches a connected XBee to 115200 baud and
+// back. Transmitting the same data at both
+// baudrates shows the gained throughput.
+//-------------------------------------------------
+#include "../progs.h"
+#if defined(TESTTASK_ENABLED) && TESTTASK == TT_XBEE_BAUDRATE
+
+#include "../../communication/xbee.h"
+#include "../../lib/lcd.h"
+#include "../../lib/terminal.h"
+#include "../../lib/uart.h"
+#include "../../lib/util.h"
+#include "../../os_core.h"
+#include "../../os_scheduler.h"
+
+//! Number of bytes written for the throughput measurement
+#define TX_LENGTH 512
+
+uint8_t tt_data[TX_LENGTH];
+
+//! Checks that uart_selectBaudrate picks the setting with the smaller error
+void tt_checkSelection(uint32_t baudrate, unsigned int expectedSetting, int16_t expectedError)
+{
+	int16_t error;
+	unsigned int setting = uart_selectBaudrate(baudrate, &error);
+
+	INFO("%6lu baud: UBRR %4u, U2X %u, error %3d per mille", (unsigned long)baudrate, setting & 0x0FFF, (setting & 0x8000) != 0, error);
+
+	if (setting != expectedSetting || error != expectedError)
+	{
+		os_error("Wrong UBRR for  %lu baud", (unsigned long)baudrate);
+	}
+}
+
+//! Returns how long it takes to transmit TX_LENGTH bytes
+time_t tt_measureTransmission(void)
+{
+	time_t start = getSystemTime_ms();
+
+	xbee_writeData(tt_data, 255);
+	xbee_writeData(tt_data + 255, 255);
+	xbee_writeData(tt_data + 510, TX_LENGTH - 510);
+	uart1_waitTxDrained();
+
+	return getSystemTime_ms() - start;
+}
+
+// Main program
+PROGRAM(1, AUTOSTART)
+{
+	lcd_clear();
+	lcd_writeProgString(PSTR("Phase 1: UBRR"));
+
+#if F_CPU == 16000000UL
+	// Values of the baudrate tables in the datasheet
+	tt_checkSelection(38400, 25, 1);
+	tt_checkSelection(115200, 0x8000 | 16, 21);
+	tt_checkSelection(230400, 0x8000 | 8, -35);
+#endif
+
+	lcd_clear();
+	lcd_writeProgString(PSTR("Phase 2: Switch"));
+
+	for (uint16_t i = 0; i < TX_LENGTH; i++)
+	{
+		tt_data[i] = i;
+	}
+
+	xbee_init();
+	time_t slow = tt_measureTransmission();
+
+	if (xbee_setBaudrate(XBEE_BAUD_115200) != XBEE_SUCCESS || xbee_getBaudrate() != XBEE_BAUD_115200)
+	{
+		os_error("XBee did not    switch");
+	}
+	time_t fast = tt_measureTransmission();
+
+	if (xbee_setBaudrate(XBEE_DEFAULT_BAUDRATE) != XBEE_SUCCESS)
+	{
+		os_error("XBee did not    switch back");
+	}
+
+	INFO("Writing %u bytes: %lu ms at 38400 baud, %lu ms at 115200 baud", TX_LENGTH, (unsigned long)slow, (unsigned long)fast);
+
+	lcd_clear();
+	if (fast * 2 < slow)
+	{
+		LCD("  TEST PASSED   ");
+	}
+	else
+	{
+		LCD("  TEST FAILED   ");
+	}
+
+	while (1)
+	{
+		os_yield();
+	}
+}
+
+#endif
@@ -9,12 +9,15 @@
 #if defined(USER_PROGRAM_ENABLED) && USER_PROGRAM == 5
 
 #include "../../communication/rfAdapter.h"
+#include "../../communication/sensorHistory.h"
 #include "../../lib/buttons.h"
 #include "../../lib/defines.h"
 #include "../../lib/lcd.h"
 #include "../../lib/util.h"
 #include "../../os_scheduler.h"
 #include "../../lib/terminal.h"
+#include "../../lib/uart.h"
+#include "../../os_mempool.h"
 #include "../../tlcd/tlcd_graphic.h"
 #include "../../tlcd/tlcd_core.h"
 #include "string.h"
@@ -30,9 +33,23 @@
 PROGRAM(1, AUTOSTART)
 {
     rfAdapter_init();
+
+    // Sensors of the team that are shown on the display
+    rfAdapter_registerSensor(SENSOR_LPS28DFW, PARAM_PRESSURE_PASCAL, enqueue_sensor_data_into_buffer);  // BOL Sensor (1,3)
+    rfAdapter_registerSensor(SENSOR_SHTC3, PARAM_HUMIDITY_PERCENT, enqueue_sensor_data_into_buffer);    // Adil Sensor (1,7)
+    rfAdapter_registerSensor(SENSOR_SCD41, PARAM_CO2_PPM, enqueue_sensor_data_into_buffer);             // Richard Sensor (1,6)
+    rfAdapter_registerSensor(SENSOR_SGP40, PARAM_TVOC_PPB, enqueue_sensor_data_into_buffer);            // Niklas Sensor (1,8)
+    rfAdapter_registerSensor(SENSOR_TMP117, PARAM_TEMPERATURE_CELSIUS, enqueue_sensor_data_into_buffer); // Jannick Sensor (1,5)
+
+    // Statistics to correlate dropped frames with the load
+    terminal_registerCommand('u', uart_printStats);
+    terminal_registerCommand('m', os_memPoolPrintStats);
+    terminal_registerCommand('h', sensorHistory_printStats);
+
     while (1)
     {
         rfAdapter_worker();
+        terminal_processCommands();
     }
 }
 
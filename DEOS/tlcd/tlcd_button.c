@@ -5,9 +5,19 @@
  */
 
 #include "tlcd_button.h"
+#include "../lib/util.h"
+#include "tlcd_core.h"
 #include "tlcd_event_parser.h"
 #include "tlcd_graphic.h"
 
+//! Width of a cell of the button grid
+#define BUTTON_GRID_CELL_WIDTH ((TLCD_WIDTH + BUTTON_GRID_COLUMNS - 1) / BUTTON_GRID_COLUMNS)
+//! Height of a cell of the button grid
+#define BUTTON_GRID_CELL_HEIGHT ((TLCD_HEIGHT + BUTTON_GRID_ROWS - 1) / BUTTON_GRID_ROWS)
+
+//! Marks that no button is held
+#define NO_BUTTON 0xFF
+
 typedef struct
 {
 	uint16_t x1;
@@ -17,11 +27,73 @@ typedef struct
 	uint8_t color;
 	uint8_t downCode;
 	char c;
+	button_state_t state;
 } Button;
 
 Button buttons[MAX_BUTTONS];
 uint8_t usedButtons = 0;
 ButtonCallback *buttonCallback = 0;
+ButtonStateCallback *buttonStateCallback = 0;
+
+//! One bit per button that overlaps a cell of the grid over the display
+uint32_t buttonGrid[BUTTON_GRID_ROWS][BUTTON_GRID_COLUMNS];
+
+//! Index of the button that is held, NO_BUTTON if none. The touch panel reports a single point
+uint8_t heldButton = NO_BUTTON;
+//! Time the held button was pressed
+time_t heldSince;
+
+/*!
+ *  Returns the column of the button grid a x-coordinate lies in
+ */
+static uint8_t gridColumn(uint16_t x)
+{
+	return x >= TLCD_WIDTH ? BUTTON_GRID_COLUMNS - 1 : x / BUTTON_GRID_CELL_WIDTH;
+}
+
+/*!
+ *  Returns the row of the button grid a y-coordinate lies in
+ */
+static uint8_t gridRow(uint16_t y)
+{
+	return y >= TLCD_HEIGHT ? BUTTON_GRID_ROWS - 1 : y / BUTTON_GRID_CELL_HEIGHT;
+}
+
+/*!
+ *  Returns the button at a point. Only the buttons overlapping the grid cell
+ *  of the point are tested, so the cost does not grow with the number of
+ *  buttons on other parts of the display. Of overlapping buttons the one
+ *  added first is returned.
+ *
+ *  \param x X-coordinate of the point
+ *  \param y Y-coordinate of the point
+ *  \return Index of the button or NO_BUTTON
+ */
+static uint8_t findButton(uint16_t x, uint16_t y)
+{
+	uint32_t candidates = buttonGrid[gridRow(y)][gridColumn(x)];
+
+	for (uint8_t i = 0; candidates != 0; i++, candidates >>= 1)
+	{
+		if ((candidates & 1) && x >= buttons[i].x1 && x <= buttons[i].x2 && y >= buttons[i].y1 && y <= buttons[i].y2)
+		{
+			return i;
+		}
+	}
+	return NO_BUTTON;
+}
+
+/*!
+ *  Changes the state of a button and reports it to the state callback
+ */
+static void setButtonState(uint8_t index, button_state_t state)
+{
+	buttons[index].state = state;
+	if (buttonStateCallback != 0)
+	{
+		buttonStateCallback(buttons[index].downCode, state);
+	}
+}
 
 /*!
  *  Set the function to be called if a button was pressed
@@ -33,6 +105,16 @@ void tlcd_setButtonCallback(ButtonCallback *callback)
 	buttonCallback = callback;
 }
 
+/*!
+ *  Set the function to be called if a button was pressed, long pressed or released
+ *
+ *  \param callback The function to be called
+ */
+void tlcd_setButtonStateCallback(ButtonStateCallback *callback)
+{
+	buttonStateCallback = callback;
+}
+
 /*!
  *  Add a button to the screen and internal logic to be handled by the handleButtons function
  *
@@ -72,6 +154,16 @@ void tlcd_addButtonWithChar(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2,
 	buttons[usedButtons].downCode = downCode;
 	buttons[usedButtons].color = color;
 	buttons[usedButtons].c = c;
+	buttons[usedButtons].state = BUTTON_RELEASED;
+
+	// enter the button into every grid cell it overlaps
+	for (uint8_t row = gridRow(buttons[usedButtons].y1); row <= gridRow(buttons[usedButtons].y2); row++)
+	{
+		for (uint8_t column = gridColumn(buttons[usedButtons].x1); column <= gridColumn(buttons[usedButtons].x2); column++)
+		{
+			buttonGrid[row][column] |= (uint32_t)1 << usedButtons;
+		}
+	}
 	usedButtons++;
 }
 
@@ -96,27 +188,72 @@ void tlcd_drawButtons()
 }
 
 /*!
- *  Check an event against all buttons for collision and execute button function if a button was pressed. Will return true if the event was inside a button and a false otherwise.
+ *  Check an event against the buttons of its grid cell for collision and
+ *  update the button states:
+ *  - a down event presses the button and calls the button callback
+ *  - an up event or dragging off the held button releases it
+ *  Will return true if the event was inside a button and a false otherwise.
  *
  *  \param event The touchevent to handle
  *  \return True if event was handled, false otherwise
  */
 bool tlcd_handleButtons(touch_event_t event)
 {
-	// go through buttons and check for collision
+	uint8_t index = findButton(event.x, event.y);
+
+	if (heldButton != NO_BUTTON && (event.type == TOUCHPANEL_UP || index != heldButton))
+	{
+		uint8_t released = heldButton;
+		heldButton = NO_BUTTON;
+		setButtonState(released, BUTTON_RELEASED);
+	}
+
+	if (index == NO_BUTTON)
+	{
+		return false;
+	}
+
+	if (event.type == TOUCHPANEL_DOWN)
+	{
+		heldButton = index;
+		heldSince = getSystemTime_ms();
+		setButtonState(index, BUTTON_PRESSED);
+
+		if (buttonCallback != 0)
+		{
+			buttonCallback(buttons[index].downCode, event.x, event.y);
+		}
+	}
+	return true;
+}
+
+/*!
+ *  Marks the held button as long pressed once it was held for
+ *  BUTTON_LONG_PRESS_MS. The touch panel sends no events while the finger
+ *  rests, so this has to be called regularly, e.g. by tlcd_event_dispatch.
+ */
+void tlcd_updateButtons()
+{
+	if (heldButton != NO_BUTTON && buttons[heldButton].state == BUTTON_PRESSED && getSystemTime_ms() - heldSince >= BUTTON_LONG_PRESS_MS)
+	{
+		setButtonState(heldButton, BUTTON_LONG_PRESSED);
+	}
+}
+
+/*!
+ *  Returns the state of a button
+ *
+ *  \param downCode The code the button was added with
+ *  \return The state of the first button with that code, BUTTON_RELEASED if there is none
+ */
+button_state_t tlcd_getButtonState(uint8_t downCode)
+{
 	for (uint8_t i = 0; i < usedButtons; i++)
 	{
-		if (event.x >= buttons[i].x1 && event.x <= buttons[i].x2)
+		if (buttons[i].downCode == downCode)
 		{
-			if (event.y >= buttons[i].y1 && event.y <= buttons[i].y2)
-			{
-				if (event.type == TOUCHPANEL_DOWN && buttonCallback != 0)
-				{
-					buttonCallback(buttons[i].downCode, event.x, event.y);
-				}
-				return true;
-			}
+			return buttons[i].state;
 		}
 	}
-	return false;
-}
\ No newline at end of file
+	return BUTTON_RELEASED;
+}
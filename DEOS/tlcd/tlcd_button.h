@@ -12,7 +12,20 @@
 #include <stdint.h>
 #include <stdlib.h>
 
-#define MAX_BUTTONS 10
+//! Maximum number of buttons, at most 32 as every cell of the button grid holds one bit per button
+#define MAX_BUTTONS 32
+
+//! Number of columns of the grid the buttons are indexed with, a touch only tests the buttons overlapping its cell
+#define BUTTON_GRID_COLUMNS 6
+//! Number of rows of the grid the buttons are indexed with
+#define BUTTON_GRID_ROWS 4
+
+//! Time in ms a button has to be held down to be long pressed
+#define BUTTON_LONG_PRESS_MS 800
+
+#if MAX_BUTTONS > 32
+#error "MAX_BUTTONS must not exceed the 32 bits of a button grid cell"
+#endif
 
 #undef MIN
 #undef MAX
@@ -20,12 +33,26 @@
 #define MIN(x, y) (x < y ? x : y)
 #define MAX(x, y) (x > y ? x : y)
 
+//! State of a button
+typedef enum ButtonState
+{
+	BUTTON_RELEASED = 0,
+	BUTTON_PRESSED = 1,
+	BUTTON_LONG_PRESSED = 2,
+} button_state_t;
+
 //! Callback function for button presses
 typedef void ButtonCallback(uint8_t buttonCode, uint16_t x, uint16_t y);
 
+//! Callback function for state changes of a button, called with the new state
+typedef void ButtonStateCallback(uint8_t buttonCode, button_state_t state);
+
 //! Set the function to be called if a button was pressed
 void tlcd_setButtonCallback(ButtonCallback *callback);
 
+//! Set the function to be called if a button was pressed, long pressed or released
+void tlcd_setButtonStateCallback(ButtonStateCallback *callback);
+
 //! Add a button to the screen and internal logic to be handled by the handleButtons function
 void tlcd_addButton(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, uint8_t color, uint8_t downCode);
 
@@ -35,7 +62,13 @@ void tlcd_addButtonWithChar(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2,
 //! Draw the buttons onto the screen. This function should be called whenever the screen was cleared.
 void tlcd_drawButtons();
 
-//! Check an event against all buttons for collision and execute button function if a button was pressed. Will return true if the event was inside a button and a false otherwise.
+//! Check an event against the buttons of its grid cell and update the button states. Will return true if the event was inside a button and a false otherwise.
 bool tlcd_handleButtons(touch_event_t event);
 
+//! Marks the held button as long pressed once BUTTON_LONG_PRESS_MS passed. Called by tlcd_event_dispatch
+void tlcd_updateButtons();
+
+//! Returns the state of the button with the given code
+button_state_t tlcd_getButtonState(uint8_t downCode);
+
 #endif
\ No newline at end of file
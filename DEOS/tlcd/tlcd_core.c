@@ -13,6 +13,8 @@
 #include "../spi/spi.h"
 #include "tlcd_graphic.h"
 
+#include <avr/interrupt.h>
+#include <avr/io.h>
 #include <util/delay.h>
 
 // #define DEBUG_SPI_LOW_LEVEL
@@ -23,6 +25,12 @@
 
 bool tlcd_initialized = false;
 
+//! Processes waiting in tlcd_waitForData
+static wait_queue_t tlcd_dataQueue;
+
+//! Number of commands sent with tlcd_writeCommand
+static uint16_t tlcd_commandCount = 0;
+
 //----------------------------------------------------------------------------
 // Given functions
 //----------------------------------------------------------------------------
@@ -49,6 +57,18 @@ inline bool spi_ack_or_timeout(uint8_t *retries)
 	return read != ACK && (*retries)++ < TLCD_MAX_RETRIES;
 }
 
+/*!
+ *  Wakes the processes waiting for data when the SBUF line goes low. As all
+ *  pins of PORTB share this interrupt, it only checks the level of SBUF.
+ */
+ISR(PCINT0_vect)
+{
+	if (!(TLCD_SBUF_PIN & (1 << TLCD_SBUF_BIT)))
+	{
+		os_signal(&tlcd_dataQueue);
+	}
+}
+
 /*!
  *  This function requests the sending buffer from the TLCD. Should only be called, if SBUF pin is low (or through polling).
  */
@@ -97,6 +117,14 @@ void tlcd_init()
 
 	// spi_cs_disable(); // Done in spi_init
 
+#if TLCD_USE_SBUF
+	// SBUF is an input with pull-up, its falling edge wakes tlcd_waitForData
+	TLCD_SBUF_DDR &= ~(1 << TLCD_SBUF_BIT);
+	TLCD_SBUF_PORT |= (1 << TLCD_SBUF_BIT);
+	PCMSK0 |= (1 << TLCD_SBUF_BIT);
+	PCICR |= (1 << PCIE0);
+#endif
+
 	tlcd_clearDisplay();
 
 	tlcd_initialized = true;
@@ -104,6 +132,39 @@ void tlcd_init()
 	os_leaveCriticalSection();
 }
 
+/*!
+ *  Returns true if the TLCD has data to send, so tlcd_requestData would
+ *  return events. Always true if TLCD_USE_SBUF is 0.
+ */
+bool tlcd_hasData()
+{
+#if TLCD_USE_SBUF
+	return !(TLCD_SBUF_PIN & (1 << TLCD_SBUF_BIT));
+#else
+	return true;
+#endif
+}
+
+/*!
+ *  Blocks the calling process until the SBUF line signals data. Other
+ *  processes run meanwhile, there is no SPI traffic while waiting.
+ *  If TLCD_USE_SBUF is 0 this only yields, as the line is not available.
+ */
+void tlcd_waitForData()
+{
+#if TLCD_USE_SBUF
+	cli();
+	while (!tlcd_hasData())
+	{
+		os_waitOn(&tlcd_dataQueue);
+		cli();
+	}
+	sei();
+#else
+	os_yield();
+#endif
+}
+
 /*!
  *  Returns true if the TLCD has been initialized
  */
@@ -167,9 +228,21 @@ void tlcd_writeCommand(const void *cmd, uint8_t len)
 
 	spi_cs_disable();
 
+	tlcd_commandCount++;
+
 	os_leaveCriticalSection();
 }
 
+/*!
+ *  Returns the number of commands sent since the start, wrapping around
+ *  after 65535. The difference of two calls tells how many commands a
+ *  drawing operation took.
+ */
+uint16_t tlcd_getCommandCount()
+{
+	return tlcd_commandCount;
+}
+
 /*!
  *  Calculates the BCC of a given data buffer and adds it to the given BCC value through mutating it.
  *
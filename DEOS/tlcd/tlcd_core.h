@@ -51,6 +51,19 @@
 #define TLCD_PORT PORTB
 #define TLCD_RESET_BIT PB3
 
+//! Set to 1 to read events only when the SBUF line signals data, 0 to poll the TLCD in every tlcd_event_worker call.
+//! The SBUF line is not connected on the standard wiring, it has to be wired to TLCD_SBUF_BIT before enabling this,
+//! otherwise tlcd_waitForData blocks forever and touch input stops.
+#define TLCD_USE_SBUF 0
+
+//! SBUF line of the TLCD, it is low while the send buffer of the TLCD holds data.
+//! Only used if TLCD_USE_SBUF is 1. Must be a pin of PORTB, as those share the pin change interrupt PCINT0_vect,
+//! PB4 is free as SPI and the reset use PB0 to PB3 and PB7.
+#define TLCD_SBUF_DDR DDRB
+#define TLCD_SBUF_PORT PORTB
+#define TLCD_SBUF_PIN PINB
+#define TLCD_SBUF_BIT PB4
+
 //! Physical size of the display
 #define TLCD_WIDTH 480
 #define TLCD_HEIGHT 272
@@ -64,6 +77,9 @@ bool tlcd_isInitialized();
 //! Sends a command to the TLCD. Header and checksum will be added automatically.
 void tlcd_writeCommand(const void* cmd, uint8_t len);
 
+//! Returns the number of commands sent to the TLCD so far
+uint16_t tlcd_getCommandCount();
+
 //! Calculates the tlcd checksum of a given data buffer
 void tlcd_calculateBCC(uint8_t* bcc, const void* data, uint8_t len);
 
@@ -73,4 +89,10 @@ void tlcd_calculateBCC_ProgMem(uint8_t* bcc, const void* data, uint8_t len);
 //! Sends a request to the TLCD so it sends event data back
 void tlcd_requestData();
 
+//! Returns true if the TLCD has data to send (SBUF line low)
+bool tlcd_hasData();
+
+//! Blocks the calling process until the TLCD has data to send, other processes run meanwhile
+void tlcd_waitForData();
+
 #endif /* TLCD_CORE_H_ */
\ No newline at end of file
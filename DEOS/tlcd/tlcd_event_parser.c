@@ -16,10 +16,19 @@
 //! Globals
 EventCallback *eventCallback;
 
+//! Ring buffer of touch events, filled by tlcd_event_worker and emptied by tlcd_event_pop
+static touch_event_t eventQueue[TLCD_EVENT_QUEUE_SIZE];
+//! Index of the oldest event in eventQueue
+static uint8_t eventQueueTail = 0;
+//! Number of events in eventQueue
+static uint8_t eventQueueCount = 0;
+//! Number of events that were dropped because eventQueue was full
+static uint16_t eventDroppedCount = 0;
+
 //! Forward declarations
 void readDataIntoBuffer();
 void parseInputBuffer();
-void parseTouchEvent();
+bool parseTouchEvent(uint8_t *bcc, uint8_t *length, touch_event_t *touchEvent);
 void parseButtonEvent();
 void parseUnknownEvent();
 
@@ -38,11 +47,51 @@ uint8_t read(uint8_t *bcc, uint8_t *length)
 }
 
 /*!
- *  Handles incoming data and calls the parsing process.
+ *  Appends a touch event to the event queue. A drag event that follows a
+ *  drag event which was not taken yet only updates its position, so a
+ *  slow consumer gets the newest position instead of a backlog of moves.
+ *  Must be called from within a critical section.
+ *
+ *  \param event The event to append
+ */
+static void pushEvent(touch_event_t const *event)
+{
+	if (event->type == TOUCHPANEL_DRAG && eventQueueCount > 0)
+	{
+		touch_event_t *newest = &eventQueue[(eventQueueTail + eventQueueCount - 1) % TLCD_EVENT_QUEUE_SIZE];
+		if (newest->type == TOUCHPANEL_DRAG)
+		{
+			newest->x = event->x;
+			newest->y = event->y;
+			return;
+		}
+	}
+
+	if (eventQueueCount == TLCD_EVENT_QUEUE_SIZE)
+	{
+		eventDroppedCount++;
+		return;
+	}
+
+	eventQueue[(eventQueueTail + eventQueueCount) % TLCD_EVENT_QUEUE_SIZE] = *event;
+	eventQueueCount++;
+}
+
+/*!
+ *  Reads the pending events of the TLCD and appends the touch events to the
+ *  event queue. No handlers are called here, so the SPI transfer is as short
+ *  as the packet. Events are only queued if the checksum of the packet
+ *  matches. Returns without SPI traffic if the SBUF line signals no data,
+ *  use tlcd_waitForData to sleep until it does.
  */
 void tlcd_event_worker()
 {
 	// DEBUG("tlcd_event_worker");
+	if (!tlcd_hasData())
+	{
+		return; // nothing to read, save the SPI round trip
+	}
+
 	os_enterCriticalSection();
 	spi_cs_enable();
 	tlcd_requestData();
@@ -51,6 +100,8 @@ void tlcd_event_worker()
 	uint8_t bcc = INITIAL_BCC_VALUE;
 	uint8_t type;
 	uint8_t byte;
+	touch_event_t packetEvents[TLCD_EVENT_PACKET_MAX];
+	uint8_t packetEventCount = 0;
 
 	// read header
 	if (read(&bcc, &len) != DC1_BYTE)
@@ -77,7 +128,18 @@ void tlcd_event_worker()
 
 		if (type == H_BYTE)
 		{
-			parseTouchEvent(&bcc, &len);
+			touch_event_t touchEvent;
+			if (parseTouchEvent(&bcc, &len, &touchEvent))
+			{
+				if (packetEventCount < TLCD_EVENT_PACKET_MAX)
+				{
+					packetEvents[packetEventCount++] = touchEvent;
+				}
+				else
+				{
+					eventDroppedCount++;
+				}
+			}
 		}
 		else
 		{
@@ -86,15 +148,72 @@ void tlcd_event_worker()
 	}
 
 	byte = spi_read();
-	if (byte != bcc)
+	spi_cs_disable();
+
+	// Corrupted packets are dropped as a whole
+	if (byte == bcc)
 	{
+		for (uint8_t i = 0; i < packetEventCount; i++)
+		{
+			pushEvent(&packetEvents[i]);
+		}
+	}
+	os_leaveCriticalSection();
+}
 
-		// lcd_writeHexByte(byte);
-		// os_error("BCC failed afterwards");
-		//  ERROR: Event handlers got called although the data got corrupted. This is a case that's unhandled!
+/*!
+ *  Takes the oldest touch event from the event queue
+ *
+ *  \param event Receives the event
+ *  \return False if the queue is empty
+ */
+bool tlcd_event_pop(touch_event_t *event)
+{
+	os_enterCriticalSection();
+	bool available = eventQueueCount > 0;
+	if (available)
+	{
+		*event = eventQueue[eventQueueTail];
+		eventQueueTail = (eventQueueTail + 1) % TLCD_EVENT_QUEUE_SIZE;
+		eventQueueCount--;
 	}
-	spi_cs_disable();
 	os_leaveCriticalSection();
+
+	return available;
+}
+
+/*!
+ *  Passes all queued touch events to the buttons and then to the callback
+ *  and checks the held button for a long press. Runs in the process of the
+ *  caller and outside of a critical section, so a slow callback only delays
+ *  that process and not the SPI reads.
+ */
+void tlcd_event_dispatch()
+{
+	touch_event_t touchEvent;
+
+	while (tlcd_event_pop(&touchEvent))
+	{
+		if (tlcd_handleButtons(touchEvent))
+		{
+			touchEvent.type = TOUCHPANEL_UP;
+		}
+		if (eventCallback != 0)
+		{
+			eventCallback(touchEvent);
+		}
+	}
+
+	tlcd_updateButtons();
+}
+
+/*!
+ *  Returns the number of touch events that were dropped because the event
+ *  queue or the event list of a packet was full
+ */
+uint16_t tlcd_event_getDroppedCount()
+{
+	return eventDroppedCount;
 }
 
 /*!
@@ -129,44 +248,37 @@ void tlcd_displayEvent(touch_event_t event)
 /*!
  *	This function is called when a free touch panel event packet
  *	has been received. The content of the subframe corresponding
- *	to that event is parsed in this function and delegated to the
- *	event handler tlcd_eventHandler(WithCorrection).
+ *	to that event is parsed in this function, the event is queued
+ *	by tlcd_event_worker and handled by tlcd_event_dispatch.
  *
  *	\param bcc The current BCC value to be updated
  * 	\param length The length value to be decremented
+ * 	\param touchEvent Receives the event
+ * 	\return False if the subframe is too short
  */
-void parseTouchEvent(uint8_t *bcc, uint8_t *length)
+bool parseTouchEvent(uint8_t *bcc, uint8_t *length, touch_event_t *touchEvent)
 {
-	touch_event_t touchEvent;
 	uint8_t x_low;
 	uint8_t y_low;
 
 	if (*length < 6)
 	{
 		// Should be at least 6 (len + 5 data bytes)
-		return;
+		return false;
 	}
 
 	read(bcc, length); // omit size, always 5
 
-	touchEvent.type = read(bcc, length);
+	touchEvent->type = read(bcc, length);
 
 	x_low = read(bcc, length);
-	touchEvent.x = ((read(bcc, length) << 8) | x_low); // combine low and high byte
+	touchEvent->x = ((read(bcc, length) << 8) | x_low); // combine low and high byte
 
 	y_low = read(bcc, length);
-	touchEvent.y = ((read(bcc, length) << 8) | y_low);
-
-	if (tlcd_handleButtons(touchEvent))
-	{
-		touchEvent.type = TOUCHPANEL_UP;
-	}
-	if (eventCallback != 0)
-	{
-		eventCallback(touchEvent);
-	}
+	touchEvent->y = ((read(bcc, length) << 8) | y_low);
 
-	// tlcd_displayEvent(touchEvent);
+	// tlcd_displayEvent(*touchEvent);
+	return true;
 }
 
 /*!
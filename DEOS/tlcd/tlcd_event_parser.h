@@ -7,11 +7,18 @@
 #ifndef TLCD_EVENT_PARSER_H_
 #define TLCD_EVENT_PARSER_H_
 
+#include <stdbool.h>
 #include <stdint.h>
 
 //! Identifier for a TOUCHPANEL_EVENT
 #define TOUCHPANEL_EVENT 0x48
 
+//! Number of touch events that can wait for tlcd_event_dispatch
+#define TLCD_EVENT_QUEUE_SIZE 8
+
+//! Number of touch events that are kept of a single packet of the TLCD, further ones are dropped
+#define TLCD_EVENT_PACKET_MAX 4
+
 //! Enum giving information if the event announces pressing or letting go of the touch panel
 typedef enum TouchEventType
 {
@@ -34,7 +41,16 @@ typedef void EventCallback(touch_event_t event);
 //! Set the function to be called if a touch event was detected
 void tlcd_event_setCallback(EventCallback *callback);
 
-//! Parse a received event and call the callback function if a touch event was detected
+//! Reads the pending events of the TLCD into the event queue, consecutive drag events are merged
 void tlcd_event_worker();
 
+//! Takes the oldest touch event from the event queue, false if it is empty
+bool tlcd_event_pop(touch_event_t *event);
+
+//! Passes all queued touch events to the buttons and the callback, in the process that calls it
+void tlcd_event_dispatch();
+
+//! Returns the number of touch events that were dropped because the event queue was full
+uint16_t tlcd_event_getDroppedCount();
+
 #endif /* TLCD_EVENT_PARSER_H_ */
\ No newline at end of file
@@ -0,0 +1,156 @@
+/*!
+ *  \brief Metrics of the built-in fonts of the TLCD.
+ *
+ *  \author   Fachbereich 5 - FH Aachen
+ *  \date     2024
+ *  \version  1.0
+ */
+
+#include "tlcd_font.h"
+
+#include <avr/pgmspace.h>
+
+//! Size of a glyph at zoom 1
+typedef struct
+{
+	uint8_t width;  //!< Advance of a character, of the widest one for proportional fonts (an upper bound only)
+	uint8_t height; //!< Height of a line
+} tlcd_font_metrics_t;
+
+//! Metrics of the built-in fonts, indexed by font - 1
+static const tlcd_font_metrics_t tlcd_fontMetrics[TLCD_FONT_COUNT] PROGMEM = {
+	{4, 6},    // TLCD_FONT_4X6
+	{6, 8},    // TLCD_FONT_6X8
+	{7, 12},   // TLCD_FONT_7X12
+	{10, 10},  // TLCD_FONT_GENEVA10
+	{14, 14},  // TLCD_FONT_CHICAGO14
+	{30, 30},  // TLCD_FONT_SWISS30B
+	{32, 50},  // TLCD_FONT_BIGZIF50
+	{64, 100}, // TLCD_FONT_BIGZIF100
+};
+
+/*!
+ *  Reads the metrics of a font from program memory
+ *
+ *  \param font The font, unknown fonts are read as TLCD_FONT_DEFAULT
+ *  \return The metrics at zoom 1
+ */
+static tlcd_font_metrics_t tlcd_readFontMetrics(tlcd_font_t font)
+{
+	tlcd_font_metrics_t metrics;
+
+	if (font < 1 || font > TLCD_FONT_COUNT)
+	{
+		font = TLCD_FONT_DEFAULT;
+	}
+	memcpy_P(&metrics, &tlcd_fontMetrics[font - 1], sizeof(metrics));
+	return metrics;
+}
+
+/*!
+ *  Limits a zoom factor to the ones the TLCD supports
+ *
+ *  \param zoom The zoom factor
+ *  \return The zoom factor between 1 and TLCD_ZOOM_MAX
+ */
+static uint8_t tlcd_limitZoom(uint8_t zoom)
+{
+	return zoom < 1 ? 1 : zoom > TLCD_ZOOM_MAX ? TLCD_ZOOM_MAX : zoom;
+}
+
+/*!
+ *  Returns whether all glyphs of a font have the same advance. Only texts
+ *  in these fonts are measured exactly, the others are overestimated.
+ *
+ *  \param font The font
+ *  \return False for the proportional fonts GENEVA10, CHICAGO14 and SWISS30B
+ */
+bool tlcd_isFixedWidth(tlcd_font_t font)
+{
+	return TLCD_FONT_IS_FIXED_WIDTH(font);
+}
+
+/*!
+ *  Returns the height of a line of text
+ *
+ *  \param font The font
+ *  \param zoom The zoom factor, see tlcd_changeTextSize()
+ *  \return Height in pixels
+ */
+uint16_t tlcd_getFontHeight(tlcd_font_t font, uint8_t zoom)
+{
+	return tlcd_readFontMetrics(font).height * tlcd_limitZoom(zoom);
+}
+
+/*!
+ *  Returns the advance of a character, control characters have no glyph.
+ *  Proportional fonts return the advance of their widest glyph.
+ *
+ *  \param font The font
+ *  \param zoom The zoom factor, see tlcd_changeTextSize()
+ *  \param c The character
+ *  \return Width in pixels
+ */
+uint16_t tlcd_getCharWidth(tlcd_font_t font, uint8_t zoom, char c)
+{
+	if ((uint8_t)c < ' ')
+	{
+		return 0;
+	}
+	return tlcd_readFontMetrics(font).width * tlcd_limitZoom(zoom);
+}
+
+/*!
+ *  Returns the width of a string. Exact for fixed-width fonts, an upper
+ *  bound for proportional ones (see tlcd_isFixedWidth()).
+ *
+ *  \param font The font
+ *  \param zoom The zoom factor, see tlcd_changeTextSize()
+ *  \param text The string
+ *  \return Width in pixels
+ */
+uint16_t tlcd_measureString(tlcd_font_t font, uint8_t zoom, const char* text)
+{
+	uint16_t advance = tlcd_getCharWidth(font, zoom, ' ');
+	uint16_t width = 0;
+
+	for (; *text != '\0'; text++)
+	{
+		if ((uint8_t)*text >= ' ')
+		{
+			width += advance;
+		}
+	}
+	return width;
+}
+
+/*!
+ *  Returns how many leading characters of a string fit into a width,
+ *  so a text can be truncated before it is drawn
+ *
+ *  \param font The font
+ *  \param zoom The zoom factor, see tlcd_changeTextSize()
+ *  \param text The string
+ *  \param maxWidth Available width in pixels
+ *  \return Number of characters, the length of the string if all of them fit
+ */
+uint8_t tlcd_fitString(tlcd_font_t font, uint8_t zoom, const char* text, uint16_t maxWidth)
+{
+	uint16_t advance = tlcd_getCharWidth(font, zoom, ' ');
+	uint16_t width = 0;
+	uint8_t count = 0;
+
+	while (text[count] != '\0' && count < UINT8_MAX)
+	{
+		if ((uint8_t)text[count] >= ' ')
+		{
+			width += advance;
+		}
+		if (width > maxWidth)
+		{
+			break;
+		}
+		count++;
+	}
+	return count;
+}
@@ -0,0 +1,65 @@
+/*!
+ *  \brief Metrics of the built-in fonts of the TLCD.
+ *
+ *  Lets callers measure a text before drawing it, so alignment, truncation
+ *  and the area to clear are computed locally instead of being left to the
+ *  display. The metrics of every font are kept in program memory.
+ *
+ *  Only the fixed-width fonts are measured exactly (see tlcd_isFixedWidth()).
+ *  There are no per-glyph advances for the proportional fonts GENEVA10,
+ *  CHICAGO14 and SWISS30B, they are measured with the advance of their
+ *  widest glyph. Their widths are upper bounds that may be used to clear
+ *  or truncate, but not to center or align a text.
+ *
+ *  \author   Fachbereich 5 - FH Aachen
+ *  \date     2024
+ *  \version  1.0
+ */
+
+#ifndef TLCD_FONT_H_
+#define TLCD_FONT_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+//! Built-in fonts of the TLCD, selected with tlcd_changeFont()
+typedef enum TLCD_Font
+{
+	TLCD_FONT_4X6 = 1,
+	TLCD_FONT_6X8 = 2,
+	TLCD_FONT_7X12 = 3,
+	TLCD_FONT_GENEVA10 = 4,
+	TLCD_FONT_CHICAGO14 = 5,
+	TLCD_FONT_SWISS30B = 6,
+	TLCD_FONT_BIGZIF50 = 7,
+	TLCD_FONT_BIGZIF100 = 8,
+} tlcd_font_t;
+
+//! Number of built-in fonts
+#define TLCD_FONT_COUNT 8
+
+//! Font the TLCD starts with
+#define TLCD_FONT_DEFAULT TLCD_FONT_7X12
+
+//! Highest zoom factor of the text, see tlcd_changeTextSize()
+#define TLCD_ZOOM_MAX 8
+
+//! Whether all glyphs of a font have the same advance, usable in static assertions
+#define TLCD_FONT_IS_FIXED_WIDTH(font) ((font) != TLCD_FONT_GENEVA10 && (font) != TLCD_FONT_CHICAGO14 && (font) != TLCD_FONT_SWISS30B)
+
+//! Returns whether all glyphs of a font have the same advance, only then texts are measured exactly
+bool tlcd_isFixedWidth(tlcd_font_t font);
+
+//! Returns the height in pixels of a line of text, unknown fonts are measured as TLCD_FONT_DEFAULT
+uint16_t tlcd_getFontHeight(tlcd_font_t font, uint8_t zoom);
+
+//! Returns the advance in pixels of a single character, the widest one for proportional fonts
+uint16_t tlcd_getCharWidth(tlcd_font_t font, uint8_t zoom, char c);
+
+//! Returns the width in pixels of a string drawn with the given font and zoom, an upper bound for proportional fonts
+uint16_t tlcd_measureString(tlcd_font_t font, uint8_t zoom, const char* text);
+
+//! Returns the number of leading characters of a string that fit into maxWidth pixels
+uint8_t tlcd_fitString(tlcd_font_t font, uint8_t zoom, const char* text, uint16_t maxWidth);
+
+#endif /* TLCD_FONT_H_ */
@@ -311,6 +311,20 @@ void tlcd_changeTextSize(uint8_t size)
     tlcd_writeCommand(cmd, sizeof(cmd) / sizeof(cmd[0]));
 }
 
+/*!
+ *  Select the font of the following texts, see tlcd_font.h for its metrics
+ *
+ *  \param font The font
+ */
+void tlcd_changeFont(tlcd_font_t font)
+{
+#ifdef DEBUG_SPI_HIGH_LEVEL
+    DEBUG("ChangeFont: %d", font);
+#endif
+    const uint8_t cmd[] = { ESC_BYTE, Z_BYTE, F_BYTE, font };
+    tlcd_writeCommand(cmd, sizeof(cmd) / sizeof(cmd[0]));
+}
+
 /*!
  *  Change the color lines are drawn in
  *
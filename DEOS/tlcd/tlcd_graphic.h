@@ -7,6 +7,7 @@
 #ifndef TLCD_GRAPHIC_H_
 #define TLCD_GRAPHIC_H_
 
+#include "tlcd_font.h"
 #include <stdint.h>
 
 
@@ -32,6 +33,9 @@ void tlcd_drawPoint(uint16_t x1, uint16_t y1);
 void tlcd_changePenSize(uint8_t size);
 void tlcd_changeTextSize(uint8_t size);
 
+//! Selects one of the built-in fonts for the following texts
+void tlcd_changeFont(tlcd_font_t font);
+
 //! Changes the color of the pen
 void tlcd_changeLineColor(uint8_t color);
 void tlcd_changeTextColor(uint8_t color);